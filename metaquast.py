@@ -82,6 +82,19 @@ def _start_quast_main(args, assemblies, reference_fpath=None, output_dirpath=Non
     return return_code, num_notifications_tuple
 
 
+def _get_quast_py_args_for_ref(quast_py_args, ref_name):
+    # the coverage of the combined reference is also split by references in the same genomecov pass,
+    # see reads_analyzer.get_coverage; the whole files are kept if there are no per-reference ones
+    ref_quast_py_args = list(quast_py_args)
+    for option in ['--cov', '--phys-cov']:
+        if option in ref_quast_py_args:
+            idx = ref_quast_py_args.index(option) + 1
+            ref_cov_fpath = qutils.add_suffix(ref_quast_py_args[idx], ref_name)
+            if qutils.is_non_empty_file(ref_cov_fpath):
+                ref_quast_py_args[idx] = ref_cov_fpath
+    return ref_quast_py_args
+
+
 def _run_quast_per_ref(quast_py_args, output_dirpath_per_ref, ref_fpath, ref_assemblies, total_num_notifications, is_parallel_run=False):
     ref_name = qutils.name_from_fpath(ref_fpath)
     if not ref_assemblies:
@@ -101,7 +114,8 @@ def _run_quast_per_ref(quast_py_args, output_dirpath_per_ref, ref_fpath, ref_ass
         logger.main_info('\nStarting quast.py ' + run_name +
                          '... (logging to ' + os.path.join(output_dirpath, qconfig.LOGGER_DEFAULT_NAME) + '.log)')
 
-        return_code, total_num_notifications = _start_quast_main(quast_py_args,
+        ref_quast_py_args = _get_quast_py_args_for_ref(quast_py_args, ref_name)
+        return_code, total_num_notifications = _start_quast_main(ref_quast_py_args,
                                                                  assemblies=ref_assemblies,
                                                                  reference_fpath=ref_fpath,
                                                                  output_dirpath=output_dirpath,
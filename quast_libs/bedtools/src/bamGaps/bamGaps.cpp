@@ -0,0 +1,408 @@
+/*****************************************************************************
+  bamGaps.cpp
+
+  Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "bamGaps.h"
+#include "lineFileUtilities.h"
+#include <algorithm>
+#include <climits>
+
+
+QuastDeletion::QuastDeletion(int refId)
+: refId(refId)
+, prevGood(-1)
+, prevBad(-1)
+, nextBad(-1)
+, nextGood(-1)
+, nextBadEnd(-1)
+{
+}
+
+
+bool QuastDeletion::IsValid(int minGap) const {
+    return prevGood != -1 && prevBad != -1 && nextBad != -1 && nextGood != -1 &&
+           nextBad - prevBad > minGap;
+}
+
+
+void QuastDeletion::SetPrevGood(int end) {
+    prevGood = end;
+    prevBad = prevGood;  // prevBad cannot be earlier than prevGood!
+}
+
+
+void QuastDeletion::SetPrevBad(int end, int maxConfInterval) {
+    prevBad = end;
+    if (prevGood == -1 || prevGood + maxConfInterval < prevBad)
+        prevGood = max(1, prevBad - maxConfInterval);
+}
+
+
+void QuastDeletion::SetNextGood(int start, int maxConfInterval) {
+    nextGood = start;
+    if (nextBad == -1)
+        nextBad = nextGood;
+    else if (nextGood - maxConfInterval > nextBad)
+        nextGood = nextBad + maxConfInterval;
+}
+
+
+void QuastDeletion::SetNextBad(int start, int end) {
+    nextBad = start;
+    nextBadEnd = end;
+    nextGood = nextBad;  // nextGood is always unset here (the deletion is complete otherwise)
+}
+
+
+void QuastDeletion::SetNextBadEnd(int start, int end, int maxConfInterval) {
+    if (nextBad == -1)
+        nextBad = start;
+    nextBadEnd = end;
+    nextGood = min(start, nextBad + maxConfInterval);
+}
+
+
+// constructor
+BamGaps::BamGaps(const string &bamFile,
+                 const string &zeroFile, int minZero,
+                 const string &delFile, int minGap, int minMapQual, int maxConfInterval,
+                 const string &labelsFile, const string &splitPrefix)
+: _bamFile(bamFile)
+, _zeroFile(zeroFile)
+, _minZero(minZero)
+, _delFile(delFile)
+, _minGap(minGap)
+, _minMapQual(minMapQual)
+, _maxConfInterval(maxConfInterval)
+, _labelsFile(labelsFile)
+, _splitPrefix(splitPrefix)
+, _coveredEnd(0)
+, _zeroRefId(0)
+{
+    if (!_reader.Open(_bamFile)) {
+        cerr << "Error: The BAM file (" << _bamFile << ") could not be opened.  Exiting!" << endl;
+        exit(1);
+    }
+    _refs = _reader.GetReferenceData();
+
+    if (!_zeroFile.empty()) {
+        _zero.open(_zeroFile.c_str(), ios::out);
+        if (!_zero) {
+            cerr << "Error: The zero coverage file (" << _zeroFile << ") could not be opened.  Exiting!" << endl;
+            exit(1);
+        }
+    }
+    if (!_delFile.empty()) {
+        _del.open(_delFile.c_str(), ios::out);
+        if (!_del) {
+            cerr << "Error: The deletions file (" << _delFile << ") could not be opened.  Exiting!" << endl;
+            exit(1);
+        }
+    }
+    if (!_labelsFile.empty())
+        OpenSplitFiles();
+}
+
+
+// destructor
+BamGaps::~BamGaps(void) {
+    for (size_t i = 0; i < _writers.size(); ++i) {
+        _writers[i]->Close();
+        delete _writers[i];
+    }
+    _reader.Close();
+}
+
+
+void BamGaps::Scan() {
+
+    BamAlignment bam;
+    int currRefId = -1;
+    int currPos = 0;
+    // only the core is needed, except for the split output, which copies the raw record
+    while (_reader.GetNextAlignmentCore(bam)) {
+
+        if (!bam.IsMapped() || bam.RefID < 0)
+            continue;
+
+        if (bam.RefID < currRefId || (bam.RefID == currRefId && bam.Position < currPos)) {
+            cerr << "Error: The BAM file (" << _bamFile << ") is not sorted by position.  Exiting!" << endl;
+            exit(1);
+        }
+        if (bam.RefID != currRefId && _zero.is_open())
+            FinishZeroCoverage(bam.RefID);
+        currRefId = bam.RefID;
+        currPos = bam.Position;
+
+        if (_zero.is_open())
+            AddZeroCoverage(bam);
+        if (_del.is_open())
+            AddDeletionRead(bam);
+        if (!_writers.empty())
+            SplitRead(bam);
+    }
+
+    if (_zero.is_open())
+        FinishZeroCoverage((int)_refs.size());
+    if (_del.is_open())
+        FinishDeletion();
+}
+
+
+// the labels file assigns references to groups ("chrom<TAB>label");
+// the reads of each group go to <prefix><label>.bam, with a header
+// that only lists the references of the group.
+void BamGaps::OpenSplitFiles() {
+
+    ifstream labels(_labelsFile.c_str());
+    if (!labels) {
+        cerr << "Error: The labels file (" << _labelsFile << ") could not be opened.  Exiting!" << endl;
+        exit(1);
+    }
+    map<string, string> chromLabels;
+    string line;
+    vector<string> fields;
+    while (getline(labels, line)) {
+        fields.clear();
+        Tokenize(line, fields);
+        if (fields.size() >= 2)
+            chromLabels[fields[0]] = fields[1];
+    }
+
+    // number the groups in the order of their first reference
+    vector<string> groupLabels;
+    vector<RefVector> groupRefs;
+    _refGroup.assign(_refs.size(), -1);
+    _groupRefId.assign(_refs.size(), -1);
+    for (size_t refId = 0; refId < _refs.size(); ++refId) {
+        map<string, string>::const_iterator labelItr = chromLabels.find(_refs[refId].RefName);
+        if (labelItr == chromLabels.end())
+            continue;
+        size_t group = find(groupLabels.begin(), groupLabels.end(), labelItr->second) - groupLabels.begin();
+        if (group == groupLabels.size()) {
+            groupLabels.push_back(labelItr->second);
+            groupRefs.push_back(RefVector());
+        }
+        _refGroup[refId] = (int)group;
+        _groupRefId[refId] = (int)groupRefs[group].size();
+        groupRefs[group].push_back(_refs[refId]);
+    }
+
+    map<string, int> refIds;
+    for (size_t refId = 0; refId < _refs.size(); ++refId)
+        refIds[_refs[refId].RefName] = (int)refId;
+
+    vector<string> headerLines;
+    Tokenize(_reader.GetHeaderText(), headerLines, '\n');
+
+    for (size_t group = 0; group < groupLabels.size(); ++group) {
+        string header;
+        for (size_t i = 0; i < headerLines.size(); ++i) {
+            const string &headerLine = headerLines[i];
+            if (headerLine.compare(0, 3, "@SQ") == 0) {
+                size_t nameStart = headerLine.find("\tSN:");
+                if (nameStart == string::npos)
+                    continue;
+                nameStart += 4;
+                string name = headerLine.substr(nameStart, headerLine.find('\t', nameStart) - nameStart);
+                map<string, int>::const_iterator refItr = refIds.find(name);
+                if (refItr == refIds.end() || _refGroup[refItr->second] != (int)group)
+                    continue;
+            }
+            header += headerLine + "\n";
+        }
+
+        string splitFile = _splitPrefix + groupLabels[group] + ".bam";
+        BamWriter *writer = new BamWriter();
+        if (!writer->Open(splitFile, header, groupRefs[group])) {
+            cerr << "Error: The split BAM file (" << splitFile << ") could not be opened.  Exiting!" << endl;
+            exit(1);
+        }
+        _writers.push_back(writer);
+    }
+}
+
+
+// the reads are covering just like in genomecov: in blocks split at
+// deletions ("D"), while spliced alignments ("N") count as covered.
+void BamGaps::AddZeroCoverage(const BamAlignment &bam) {
+
+    // nothing can cover what ends before this read any more
+    ReportHoles(bam.Position);
+
+    int currPosition = bam.Position;
+    int blockLength = 0;
+    vector<CigarOp>::const_iterator cigItr = bam.CigarData.begin();
+    vector<CigarOp>::const_iterator cigEnd = bam.CigarData.end();
+    for (; cigItr != cigEnd; ++cigItr) {
+        switch (cigItr->Type) {
+            case ('M') : case ('X') : case ('=') : case ('N') :
+                blockLength += cigItr->Length;
+                break;
+            case ('D') :
+                CoverZero(currPosition, currPosition + blockLength);
+                currPosition += cigItr->Length + blockLength;
+                blockLength = 0;
+                break;
+            default :
+                break;
+        }
+    }
+    CoverZero(currPosition, currPosition + blockLength);
+}
+
+
+// mark [start, end) of the current reference as covered
+void BamGaps::CoverZero(int start, int end) {
+
+    end = min(end, (int)_refs[_zeroRefId].RefLength);
+    if (end <= start)
+        return;
+
+    if (start > _coveredEnd)
+        _holes[_coveredEnd] = start;
+
+    // shrink or drop the holes overlapping [start, end)
+    map<int, int>::iterator holeItr = _holes.upper_bound(start);
+    if (holeItr != _holes.begin()) {
+        --holeItr;
+        if (holeItr->second <= start)
+            ++holeItr;
+    }
+    while (holeItr != _holes.end() && holeItr->first < end) {
+        int holeStart = holeItr->first;
+        int holeEnd = holeItr->second;
+        _holes.erase(holeItr++);
+        if (holeStart < start)
+            _holes[holeStart] = start;
+        if (holeEnd > end) {
+            _holes[end] = holeEnd;
+            break;
+        }
+    }
+    _coveredEnd = max(_coveredEnd, end);
+}
+
+
+void BamGaps::ReportZero(int refId, int start, int end) {
+    if (end > start && end - start >= _minZero)
+        _zero << _refs[refId].RefName << "\t" << start << "\t" << end << "\n";
+}
+
+
+// report the holes that end at or before pos
+void BamGaps::ReportHoles(int pos) {
+    while (!_holes.empty() && _holes.begin()->second <= pos) {
+        ReportZero(_zeroRefId, _holes.begin()->first, _holes.begin()->second);
+        _holes.erase(_holes.begin());
+    }
+}
+
+
+// close the reference in progress, and the ones without reads before nextRefId
+void BamGaps::FinishZeroCoverage(int nextRefId) {
+    for (; _zeroRefId < nextRefId; ++_zeroRefId) {
+        ReportHoles(INT_MAX);
+        ReportZero(_zeroRefId, _coveredEnd, (int)_refs[_zeroRefId].RefLength);
+        _coveredEnd = 0;
+    }
+}
+
+
+// follows the deletion candidate along the reads of one reference.
+// a read spans its length from its (1-based) start, whatever its CIGAR,
+// as QUAST has always counted it.
+void BamGaps::AddDeletionRead(const BamAlignment &bam) {
+
+    int start = bam.Position + 1;
+    int end = start + max(bam.Length, 1) - 1;
+    bool isGood = bam.MapQuality >= _minMapQual;
+
+    // just started or just switched to the next reference
+    if (_currDel.refId != bam.RefID) {
+        FinishDeletion();
+        _currDel = QuastDeletion(bam.RefID);
+        _currDel.SetPrevGood(end);
+        return;
+    }
+
+    if (_currDel.nextBad == -1) {
+        // the previous read was BEFORE the zero-covered fragment
+        if (start - _currDel.prevBad > _minGap) {
+            // just passed the zero-covered fragment
+            _currDel.SetNextBad(start, end);
+            if (isGood) {
+                _currDel.SetNextGood(start, _maxConfInterval);
+                if (_currDel.IsValid(_minGap))
+                    ReportDeletion(_currDel);
+                _currDel = QuastDeletion(bam.RefID);
+                _currDel.SetPrevGood(end);
+            }
+        }
+        else if (isGood)
+            _currDel.SetPrevGood(end);
+        else
+            _currDel.SetPrevBad(end, _maxConfInterval);
+    }
+    else {
+        // the previous read was AFTER the zero-covered fragment
+        if (start - _currDel.nextBadEnd > _minGap) {
+            // just passed another zero-covered fragment, after the "bad" reads of this one
+            if (_currDel.IsValid(_minGap))
+                ReportDeletion(_currDel);
+            int prevBad = _currDel.nextBadEnd;
+            _currDel = QuastDeletion(bam.RefID);
+            _currDel.SetPrevBad(prevBad, _maxConfInterval);
+        }
+        else if (isGood) {
+            _currDel.SetNextGood(start, _maxConfInterval);
+            if (_currDel.IsValid(_minGap))
+                ReportDeletion(_currDel);
+            _currDel = QuastDeletion(bam.RefID);
+            _currDel.SetPrevGood(end);
+        }
+        else
+            _currDel.SetNextBadEnd(start, end, _maxConfInterval);
+    }
+}
+
+
+// the reference of the deletion in progress ends: its end is the "good" side
+void BamGaps::FinishDeletion() {
+    if (_currDel.refId < 0)
+        return;
+    _currDel.SetNextGood((int)_refs[_currDel.refId].RefLength, _maxConfInterval);
+    if (_currDel.IsValid(_minGap))
+        ReportDeletion(_currDel);
+    _currDel = QuastDeletion();
+}
+
+
+void BamGaps::ReportDeletion(const QuastDeletion &deletion) {
+    const string &chrom = _refs[deletion.refId].RefName;
+    _del << chrom << "\t" << deletion.prevGood << "\t" << deletion.prevBad << "\t"
+         << chrom << "\t" << deletion.nextBad << "\t" << deletion.nextGood << "\t"
+         << "QuastDEL" << "\n";
+}
+
+
+// write the read to the BAM of its group, if its mate (if any) is in the same group
+void BamGaps::SplitRead(BamAlignment &bam) {
+
+    int group = _refGroup[bam.RefID];
+    if (group < 0)
+        return;
+    if (bam.MateRefID >= 0 && _refGroup[bam.MateRefID] != group)
+        return;
+
+    // renumber the references for the group's header, just for this record
+    int refId = bam.RefID;
+    int mateRefId = bam.MateRefID;
+    bam.RefID = _groupRefId[refId];
+    if (mateRefId >= 0)
+        bam.MateRefID = _groupRefId[mateRefId];
+    _writers[group]->SaveAlignment(bam);
+    bam.RefID = refId;
+    bam.MateRefID = mateRefId;
+}
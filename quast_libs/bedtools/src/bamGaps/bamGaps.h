@@ -0,0 +1,118 @@
+/*****************************************************************************
+  bamGaps.h
+
+  Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#ifndef BAMGAPS_H
+#define BAMGAPS_H
+
+#include "api/BamReader.h"
+#include "api/BamWriter.h"
+using namespace BamTools;
+
+#include <vector>
+#include <map>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <stdlib.h>
+using namespace std;
+
+
+//************************************************
+// A deletion candidate the way QUAST describes it:
+//   GGGGBBBBBNNNNNNNNNNNNBBBBBBGGGGGG
+// G -- "good" read (high mapping quality)
+// B -- "bad" read (low mapping quality)
+// N -- no mapped reads
+// The Ns are the deletion (longer than the minimum gap),
+// the Bs are the confidence interval around it (no longer
+// than the maximum one, fixing the last/first G position
+// otherwise). All positions are 1-based; -1 means unset.
+//************************************************
+struct QuastDeletion {
+
+    int refId;
+    int prevGood, prevBad;
+    int nextBad, nextGood, nextBadEnd;
+
+    QuastDeletion(int refId = -1);
+
+    bool IsValid(int minGap) const;
+
+    void SetPrevGood(int end);
+    void SetPrevBad(int end, int maxConfInterval);
+    void SetNextGood(int start, int maxConfInterval);
+    void SetNextBad(int start, int end);
+    void SetNextBadEnd(int start, int end, int maxConfInterval);
+};
+
+
+//************************************************
+// Streams a position-sorted BAM once and reports
+//   - the zero-covered intervals of every reference (BED),
+//   - QUAST's trivial deletion candidates (BEDPE-like),
+//   - the reads of each group of references, in a BAM per group.
+//************************************************
+class BamGaps {
+
+public:
+
+    // constructor
+    BamGaps(const string &bamFile,
+            const string &zeroFile, int minZero,
+            const string &delFile, int minGap, int minMapQual, int maxConfInterval,
+            const string &labelsFile, const string &splitPrefix);
+
+    // destructor
+    ~BamGaps(void);
+
+    void Scan();
+
+private:
+
+    string _bamFile;
+    string _zeroFile;
+    int _minZero;           // shorter zero-covered intervals are not reported
+    string _delFile;
+    int _minGap;            // deletions have to be longer than this
+    int _minMapQual;        // reads with a lower MAPQ are "bad" ones
+    int _maxConfInterval;
+    string _labelsFile;
+    string _splitPrefix;
+
+    BamReader _reader;
+    RefVector _refs;
+    ofstream _zero;
+    ofstream _del;
+
+    // zero coverage on the current reference: the stretches behind
+    // _coveredEnd that no read covers so far, by start. they stay
+    // open until the reads start past them.
+    map<int, int> _holes;
+    int _coveredEnd;
+    int _zeroRefId;         // last reference whose zero coverage is reported
+
+    QuastDeletion _currDel;
+
+    // per-group output of the reads
+    vector<int> _refGroup;      // group of each reference, -1 if not split
+    vector<int> _groupRefId;    // RefID of each reference in its group's BAM
+    vector<BamWriter *> _writers;
+
+    void OpenSplitFiles();
+
+    void AddZeroCoverage(const BamAlignment &bam);
+    void CoverZero(int start, int end);
+    void ReportZero(int refId, int start, int end);
+    void ReportHoles(int pos);
+    void FinishZeroCoverage(int lastRefId);
+
+    void AddDeletionRead(const BamAlignment &bam);
+    void FinishDeletion();
+    void ReportDeletion(const QuastDeletion &deletion);
+
+    void SplitRead(BamAlignment &bam);
+};
+
+#endif /* BAMGAPS_H */
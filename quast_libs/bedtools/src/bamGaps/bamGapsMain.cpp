@@ -0,0 +1,221 @@
+/*****************************************************************************
+  bamGapsMain.cpp
+
+  Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "bamGaps.h"
+#include "version.h"
+
+using namespace std;
+
+// define our program name
+#define PROGRAM_NAME "bedtools bamgaps"
+
+// define our parameter checking macro
+#define PARAMETER_CHECK(param, paramLen, actualLen) (strncmp(argv[i], param, min(actualLen, paramLen))== 0) && (actualLen == paramLen)
+
+// function declarations
+void bamgaps_help(void);
+
+int bamgaps_main(int argc, char* argv[]) {
+
+    // our configuration variables
+    bool showHelp = false;
+
+    // input / output files
+    string bamFile;
+    string zeroFile;
+    string delFile;
+    string labelsFile;
+    string splitPrefix;
+
+    // parm flags
+    bool haveBam    = false;
+    bool haveMinZero = false;
+    bool haveMinGap = false;
+    bool haveMapQual = false;
+    bool haveMaxCI  = false;
+    bool havePrefix = false;
+
+    int minZero = 1;
+    int minGap = 700;
+    int minMapQual = 20;
+    int maxConfInterval = 150;
+
+    // check to see if we should print out some help
+    if(argc <= 1) showHelp = true;
+
+    for(int i = 1; i < argc; i++) {
+        int parameterLength = (int)strlen(argv[i]);
+
+        if((PARAMETER_CHECK("-h", 2, parameterLength)) ||
+        (PARAMETER_CHECK("--help", 5, parameterLength))) {
+            showHelp = true;
+        }
+    }
+
+    if(showHelp) bamgaps_help();
+
+    // do some parsing (all of these parameters require 2 strings)
+    for(int i = 1; i < argc; i++) {
+
+        int parameterLength = (int)strlen(argv[i]);
+
+        if(PARAMETER_CHECK("-ibam", 5, parameterLength)) {
+            if ((i+1) < argc) {
+                haveBam = true;
+                bamFile = argv[i + 1];
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-zero", 5, parameterLength)) {
+            if ((i+1) < argc) {
+                zeroFile = argv[i + 1];
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-minzero", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                haveMinZero = true;
+                minZero = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-del", 4, parameterLength)) {
+            if ((i+1) < argc) {
+                delFile = argv[i + 1];
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-mingap", 7, parameterLength)) {
+            if ((i+1) < argc) {
+                haveMinGap = true;
+                minGap = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-mapq", 5, parameterLength)) {
+            if ((i+1) < argc) {
+                haveMapQual = true;
+                minMapQual = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-maxci", 6, parameterLength)) {
+            if ((i+1) < argc) {
+                haveMaxCI = true;
+                maxConfInterval = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-split", 6, parameterLength)) {
+            if ((i+1) < argc) {
+                labelsFile = argv[i + 1];
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-prefix", 7, parameterLength)) {
+            if ((i+1) < argc) {
+                havePrefix = true;
+                splitPrefix = argv[i + 1];
+                i++;
+            }
+        }
+        else {
+            cerr << endl << "*****ERROR: Unrecognized parameter: " << argv[i] << " *****" << endl << endl;
+            showHelp = true;
+        }
+    }
+
+    // make sure we have both input files
+    if (!haveBam) {
+        cerr << endl << "*****" << endl << "*****ERROR: Need -ibam. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (zeroFile.empty() && delFile.empty() && labelsFile.empty()) {
+        cerr << endl << "*****" << endl << "*****ERROR: Need at least one of -zero, -del and -split. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (haveMinZero && zeroFile.empty()) {
+        cerr << endl << "*****" << endl << "*****ERROR: -minzero requires -zero. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (haveMinZero && minZero < 1) {
+        cerr << endl << "*****" << endl << "*****ERROR: -minzero must be a positive integer. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if ((haveMinGap || haveMapQual || haveMaxCI) && delFile.empty()) {
+        cerr << endl << "*****" << endl << "*****ERROR: -mingap, -mapq and -maxci require -del. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    // -mingap may be negative: QUAST passes --extensive-mis-size minus 300
+    if (minMapQual < 0 || maxConfInterval < 0) {
+        cerr << endl << "*****" << endl << "*****ERROR: -mapq and -maxci cannot be negative. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (havePrefix && labelsFile.empty()) {
+        cerr << endl << "*****" << endl << "*****ERROR: -prefix requires -split. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+
+    if (!showHelp) {
+        BamGaps *bamGaps = new BamGaps(bamFile, zeroFile, minZero,
+                                       delFile, minGap, minMapQual, maxConfInterval,
+                                       labelsFile, splitPrefix);
+        bamGaps->Scan();
+        delete bamGaps;
+    }
+    else {
+        bamgaps_help();
+    }
+    return 0;
+}
+
+void bamgaps_help(void) {
+
+    cerr << "\nTool:    bedtools bamgaps" << endl;
+    cerr << "Version: " << VERSION << "\n";
+    cerr << "Summary: Scans a position-sorted BAM file once for the regions without reads:" << endl;
+    cerr << "\t the zero-covered intervals and QUAST's trivial deletion candidates." << endl;
+    cerr << "\t Can also split the reads by groups of references along the way." << endl << endl;
+
+    cerr << "Usage:   " << PROGRAM_NAME << " [OPTIONS] -ibam <bam> [-zero <bed>] [-del <bedpe>] [-split <labels>]" << endl << endl;
+
+    cerr << "Options: " << endl;
+
+    cerr << "\t-zero\t\t" << "Write the zero-covered intervals to this file (BED)." << endl;
+    cerr << "\t\t\tCoverage is counted as in genomecov: reads are split at" << endl;
+    cerr << "\t\t\tdeletions (CIGAR D), but not at spliced alignments (N)." << endl << endl;
+
+    cerr << "\t-minzero\t" << "Report only zero-covered intervals at least this long." << endl;
+    cerr << "\t\t\t- Default is 1." << endl << endl;
+
+    cerr << "\t-del\t\t" << "Write the trivial deletions to this file: fragments without reads" << endl;
+    cerr << "\t\t\tlonger than -mingap, flanked by reads with MAPQ >= -mapq." << endl;
+    cerr << "\t\t\tEach line is: chrom, prev. good, prev. bad, chrom, next bad," << endl;
+    cerr << "\t\t\tnext good (1-based) and the QuastDEL name." << endl << endl;
+
+    cerr << "\t-mingap\t\t" << "The minimum length of the deletions (may be negative)." << endl;
+    cerr << "\t\t\t- Default is 700." << endl << endl;
+
+    cerr << "\t-mapq\t\t" << "The minimum MAPQ of the \"good\" reads around the deletions." << endl;
+    cerr << "\t\t\t- Default is 20." << endl << endl;
+
+    cerr << "\t-maxci\t\t" << "The maximum length of the low MAPQ stretch (the confidence" << endl;
+    cerr << "\t\t\tinterval) on each side of the deletions." << endl;
+    cerr << "\t\t\t- Default is 150." << endl << endl;
+
+    cerr << "\t-split\t\t" << "A tab-delimited file assigning references to groups (chrom, label)." << endl;
+    cerr << "\t\t\tThe reads of each group, whose mates are in the same group," << endl;
+    cerr << "\t\t\tare written to <prefix><label>.bam." << endl << endl;
+
+    cerr << "\t-prefix\t\t" << "The prefix (e.g. a directory) of the split BAM files." << endl << endl;
+
+    cerr << "Notes: " << endl;
+    cerr << "\t(1) The input BAM file must be sorted by position." << endl;
+    cerr << "\t(2) Unmapped reads are ignored." << endl;
+    cerr << "\t(3) Reads without sequence (SEQ *) span one base for -del." << endl << endl;
+
+    // end the program here
+    exit(1);
+}
@@ -22,6 +22,7 @@ using namespace BamTools;
 #include <sstream>
 #include <fstream>
 #include <stdlib.h>
+#include <stdio.h>
 
 using namespace std;
 
@@ -40,12 +41,30 @@ void ConvertBamToBed(const string &bamFile, bool useEditDistance,
                      const string &bamTag, bool writeBed12, 
                      bool obeySplits, bool splitOnDeletions, 
                      const string &color, bool useCigar,
-                     bool useNovoalign, bool useBWA);
+                     bool useNovoalign, bool useBWA, int numThreads);
                      
 void ConvertBamToBedpe(const string &bamFile, 
-                       const bool &useEditDistance, bool mate1First);
+                       const bool &useEditDistance, bool mate1First,
+                       int numThreads);
 
-string PrintTag(const BamAlignment &bam, const string &tag);
+bool GetNextBedpeAlignment(BamReader &reader, BamAlignment &bam, bool useEditDistance);
+
+void FlushOutput();
+
+void EndLine();
+
+void AppendNumber(int64_t number);
+
+void AppendCigarString(const vector<CigarOp> &cigar);
+
+void AppendTag(const BamAlignment &bam, const string &tag);
+
+void AppendBedStart(const string &chrom, int64_t start, int64_t end, const string &name);
+
+void AppendBedPE(const string &chrom1, int start1, int end1,
+                 const string &chrom2, int start2, int end2,
+                 const string &name, int score,
+                 const string &strand1, const string &strand2);
 
 void PrintBed(const BamAlignment &bam, const RefVector &refs, 
               bool useEditDistance, const string &bamTag, 
@@ -64,7 +83,6 @@ void PrintBedPE(const BamAlignment &bam1, const BamAlignment &bam2,
 void ParseCigarBed12(const vector<CigarOp> &cigar, vector<int> &blockStarts,
                      vector<int> &blockEnds, int &alignmentEnd);
 
-string BuildCigarString(const vector<CigarOp> &cigar);
 
 bool bamtobed_IsCorrectMappingForBEDPE (const BamAlignment &bam);
 
@@ -78,6 +96,7 @@ int bamtobed_main(int argc, char* argv[]) {
     string bamFile = "stdin";
     string color   = "255,0,0";
     string tag     = "";
+    int numThreads = 1;
 
     bool haveBam           = true;
     bool haveColor         = false;
@@ -156,6 +175,12 @@ int bamtobed_main(int argc, char* argv[]) {
                 i++;
             }
         }
+        else if(PARAMETER_CHECK("-threads", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                numThreads = atoi(argv[i + 1]);
+                i++;
+            }
+        }
         else if(PARAMETER_CHECK("-tag", 4, parameterLength)) {
             if ((i+1) < argc) {
                 haveOtherTag = true;
@@ -219,9 +244,9 @@ int bamtobed_main(int argc, char* argv[]) {
                             tag, writeBed12, 
                             obeySplits, splitOnDeletions, 
                             color, useCigar,
-                            useNovoalign, useBWA);
+                            useNovoalign, useBWA, numThreads);
         else
-            ConvertBamToBedpe(bamFile, useEditDistance, mate1First);
+            ConvertBamToBedpe(bamFile, useEditDistance, mate1First, numThreads);
     }
     else {
         bamtobed_help();
@@ -271,6 +296,9 @@ void bamtobed_help(void) {
   
     cerr << "\t-cigar\t"      << "Add the CIGAR string to the BED entry as a 7th column." << endl << endl;
 
+    cerr << "\t-threads\t"    << "Number of threads used to decompress the BAM input." << endl;
+    cerr                      << "\t\tDefault is 1." << endl << endl;
+
 
     // end the program here
     exit(1);
@@ -279,7 +307,8 @@ void bamtobed_help(void) {
 
 void ConvertBamToBed(const string &bamFile, bool useEditDistance, const string &bamTag,
                      bool writeBed12, bool obeySplits, bool splitOnDeletions, 
-                     const string &color, bool useCigar, bool useNovoalign, bool useBWA) 
+                     const string &color, bool useCigar, bool useNovoalign, bool useBWA,
+                     int numThreads) 
 {
     
     // open the BAM file
@@ -288,15 +317,22 @@ void ConvertBamToBed(const string &bamFile, bool useEditDistance, const string &
         cerr << "Failed to open BAM file " << bamFile << endl;
         exit(1);
     }
+    reader.SetNumThreads(numThreads);
 
     // get header & reference information
     string header = reader.GetHeaderText();
     RefVector refs = reader.GetReferenceData();
 
+    // only the tags need the full char data of the alignments,
+    // the plain BED output gets by with the read name.
+    bool useTags = useEditDistance || bamTag != "" || useNovoalign || useBWA;
+
     // rip through the BAM file and convert each mapped entry to BED
     BamAlignment bam;
-    while (reader.GetNextAlignment(bam)) {
+    while (reader.GetNextAlignmentCore(bam)) {
         if (bam.IsMapped() == true) {
+            if (useTags) bam.BuildCharData();
+            else bam.BuildName();
             if (writeBed12 == false)                 // BED
                 PrintBed(bam, refs, useEditDistance, bamTag, obeySplits, splitOnDeletions,
                          useCigar, useNovoalign, useBWA);
@@ -305,10 +341,23 @@ void ConvertBamToBed(const string &bamFile, bool useEditDistance, const string &
                            color);
         }
     }
+    FlushOutput();
     reader.Close();
 }
 
 
+// the next alignment with its read name, and its tags only if the edit
+// distance is reported: the bases and qualities are never needed for BEDPE.
+bool GetNextBedpeAlignment(BamReader &reader, BamAlignment &bam, bool useEditDistance)
+{
+    if (!reader.GetNextAlignmentCore(bam))
+        return false;
+    if (useEditDistance) bam.BuildCharData();
+    else bam.BuildName();
+    return true;
+}
+
+
 /*
   Assumptions:
      1.  The BAM file is grouped/sorted by query name,
@@ -316,7 +365,8 @@ void ConvertBamToBed(const string &bamFile, bool useEditDistance, const string &
 */
 void ConvertBamToBedpe(const string &bamFile, 
                        const bool &useEditDistance,
-                       bool mate1First) 
+                       bool mate1First,
+                       int numThreads) 
 {
     // open the BAM file
     BamReader reader;
@@ -324,6 +374,7 @@ void ConvertBamToBedpe(const string &bamFile,
         cerr << "Failed to open BAM file " << bamFile << endl;
         exit(1);
     }
+    reader.SetNumThreads(numThreads);
 
     // get header & reference information
     string header = reader.GetHeaderText();
@@ -331,9 +382,9 @@ void ConvertBamToBedpe(const string &bamFile,
 
     // rip through the BAM file and convert each mapped entry to BEDPE
     BamAlignment bam1, bam2;
-    while (reader.GetNextAlignment(bam1)) {
+    while (GetNextBedpeAlignment(reader, bam1, useEditDistance)) {
         
-        reader.GetNextAlignment(bam2);        
+        GetNextBedpeAlignment(reader, bam2, useEditDistance);
         if (bam1.Name != bam2.Name) {
             while (bam1.Name != bam2.Name)
             {
@@ -344,7 +395,7 @@ void ConvertBamToBedpe(const string &bamFile,
                          << " next to it in your BAM file.  Skipping. " << endl;
                 }
                 bam1 = bam2;
-                reader.GetNextAlignment(bam2);
+                GetNextBedpeAlignment(reader, bam2, useEditDistance);
             }
             PrintBedPE(bam1, bam2, refs, useEditDistance, mate1First);
         }
@@ -352,13 +403,45 @@ void ConvertBamToBedpe(const string &bamFile,
             PrintBedPE(bam1, bam2, refs, useEditDistance, mate1First);
         }
     }
+    FlushOutput();
     reader.Close();
 }
 
 
-string BuildCigarString(const vector<CigarOp> &cigar) {
+// all of the BED output is formatted into one buffer, and written out
+// with a single fwrite whenever it fills up (and once at the end).
+static const size_t MAX_OUTBUF_SIZE = 1 << 20; // 1 M
+static string outBuf;
+
+void FlushOutput() {
+    fwrite(outBuf.data(), 1, outBuf.size(), stdout);
+    outBuf.clear();
+}
+
+// ends the current line, flushing the buffer if it is full
+void EndLine() {
+    outBuf += '\n';
+    if (outBuf.size() >= MAX_OUTBUF_SIZE)
+        FlushOutput();
+}
+
+// appends a number to the buffer, without any stream or printf machinery.
+// (int64_t holds both the signed and unsigned 32 bit values printed here.)
+void AppendNumber(int64_t number) {
+    char tmpBuffer[24];
+    char *tmpBuf = &tmpBuffer[sizeof tmpBuffer];
+    uint64_t useNum = number < 0 ? 0 - (uint64_t)number : (uint64_t)number;
+    do {
+        *--tmpBuf = (useNum % 10) + '0';
+        useNum /= 10;
+    } while (useNum > 0);
+    if (number < 0)
+        *--tmpBuf = '-';
+    outBuf.append(tmpBuf, &tmpBuffer[sizeof tmpBuffer] - tmpBuf);
+}
+
+void AppendCigarString(const vector<CigarOp> &cigar) {
 
-    stringstream cigarString;
     for (size_t i = 0; i < cigar.size(); ++i) {
         switch (cigar[i].Type) {
             case ('M') :
@@ -368,28 +451,39 @@ string BuildCigarString(const vector<CigarOp> &cigar) {
             case ('S') :
             case ('H') :
             case ('P') :
-                cigarString << cigar[i].Length << cigar[i].Type;
+                AppendNumber(cigar[i].Length);
+                outBuf += cigar[i].Type;
         }
     }
-    return cigarString.str();
 }
 
-string PrintTag(const BamAlignment &bam, const string &tag)
+void AppendTag(const BamAlignment &bam, const string &tag)
 {
     uint32_t uTagValue;
     int32_t sTagValue;
-    ostringstream value;
     if (bam.GetTag(tag, uTagValue))
-        value << uTagValue;
+        AppendNumber(uTagValue);
     else if (bam.GetTag(tag, sTagValue))
-        value << sTagValue;
+        AppendNumber(sTagValue);
     else {
+        FlushOutput();
         cerr << "The requested tag (" 
              << tag 
              << ") was not found in the BAM file.  Exiting\n";
         exit(1);
     }
-    return value.str();
+}
+
+// chrom, start, end and name: the leading fields of all the BED outputs
+void AppendBedStart(const string &chrom, int64_t start, int64_t end, const string &name) {
+    outBuf += chrom;
+    outBuf += '\t';
+    AppendNumber(start);
+    outBuf += '\t';
+    AppendNumber(end);
+    outBuf += '\t';
+    outBuf += name;
+    outBuf += '\t';
 }
 
 void PrintBed(const BamAlignment &bam,  const RefVector &refs, 
@@ -399,8 +493,8 @@ void PrintBed(const BamAlignment &bam,  const RefVector &refs,
               bool useBWA) 
 {
     // set the strand
-    string strand = "+";
-    if (bam.IsReverseStrand() == true) strand = "-";
+    char strand = '+';
+    if (bam.IsReverseStrand() == true) strand = '-';
 
     // set the name of the feature based on the sequence
     string name = bam.Name;
@@ -412,32 +506,23 @@ void PrintBed(const BamAlignment &bam,  const RefVector &refs,
 
     // report the entire BAM footprint as a single BED entry
     if (obeySplits == false) {
-        
+        // -novo together with -bwa matches none of the formats below: print nothing.
+        if (useNovoalign && useBWA)
+            return;
+
+        AppendBedStart(refs.at(bam.RefID).RefName, bam.Position, alignmentEnd, name);
         if (!useNovoalign && !useBWA) {
             // report the alignment in BED6 format.
-            if (bamTag == "") {
-                cout << refs.at(bam.RefID).RefName << "\t"
-                     << bam.Position << "\t"
-                     << alignmentEnd << "\t"
-                     << name << "\t"
-                     << bam.MapQuality << "\t"
-                     << strand;
-            }
-            else {
-                cout << refs.at(bam.RefID).RefName << "\t"
-                     << bam.Position << "\t"
-                     << alignmentEnd << "\t"
-                     << name << "\t"
-                     << PrintTag(bam, bamTag) << "\t"
-                     << strand;
-            }
+            if (bamTag == "")
+                AppendNumber(bam.MapQuality);
+            else
+                AppendTag(bam, bamTag);
+            outBuf += '\t';
+            outBuf += strand;
             // does the user want CIGAR as well?
-            if (useCigar == false) {
-                printf("\n");
-            }
-            else {
-                string cigar = BuildCigarString(bam.CigarData);
-                printf("\t%s\n", cigar.c_str());
+            if (useCigar == true) {
+                outBuf += '\t';
+                AppendCigarString(bam.CigarData);
             }
         }
         else if (useNovoalign && !useBWA) {
@@ -448,15 +533,13 @@ void PrintBed(const BamAlignment &bam,  const RefVector &refs,
                 // if ZN is missing, this means just one alignment was found.
                 numMappings = 1;
             }
-            cout << refs.at(bam.RefID).RefName << "\t"
-                 << bam.Position << "\t"
-                 << alignmentEnd << "\t"
-                 << name << "\t"
-                 << bam.MapQuality << "\t"
-                 << PrintTag(bam, "NM") << "\t"
-                 << numMappings << "\t"
-                 << strand
-                 << endl;
+            AppendNumber(bam.MapQuality);
+            outBuf += '\t';
+            AppendTag(bam, "NM");
+            outBuf += '\t';
+            AppendNumber(numMappings);
+            outBuf += '\t';
+            outBuf += strand;
         }
         else if (!useNovoalign && useBWA) {
             // special BED format for Hydra using Novoalign.
@@ -471,16 +554,15 @@ void PrintBed(const BamAlignment &bam,  const RefVector &refs,
             else {
                 numMappings = x0 + x1;
             }
-            cout << refs.at(bam.RefID).RefName << "\t"
-                 << bam.Position << "\t"
-                 << alignmentEnd << "\t"
-                 << name << "\t"
-                 << bam.MapQuality << "\t"
-                 << PrintTag(bam, "NM") << "\t"
-                 << numMappings << "\t"
-                 << strand
-                 << endl;
+            AppendNumber(bam.MapQuality);
+            outBuf += '\t';
+            AppendTag(bam, "NM");
+            outBuf += '\t';
+            AppendNumber(numMappings);
+            outBuf += '\t';
+            outBuf += strand;
         }
+        EndLine();
     }
     // Report each chunk of the BAM alignment as a discrete BED entry
     // For example 10M100N10M would be reported as two seprate BED entries of
@@ -498,27 +580,28 @@ void PrintBed(const BamAlignment &bam,  const RefVector &refs,
 
         unsigned int i;
         for (i = 0; i < bedBlocks.size(); ++i) {
-            BED curr = bedBlocks[i];
+            const BED &curr = bedBlocks[i];
 
             if (bamTag == "") {
-                printf("%s\t%d\t%d\t%s\t%d\t%s\n", 
-                       chrom.c_str(), 
-                       curr.start,
-                       curr.end,
-                       name.c_str(),
-                       bam.MapQuality,
-                       strand.c_str());
+                AppendBedStart(chrom, (int)curr.start, (int)curr.end, name);
+                AppendNumber(bam.MapQuality);
             }
             else {
-                cout << chrom << "\t"
-                     << bam.Position << "\t"
-                     << curr.start << "\t"
-                     << curr.end << "\t"
-                     << name << "\t"
-                     << PrintTag(bam, bamTag) << "\t"
-                     << strand
-                     << endl;            
+                outBuf += chrom;
+                outBuf += '\t';
+                AppendNumber(bam.Position);
+                outBuf += '\t';
+                AppendNumber(curr.start);
+                outBuf += '\t';
+                AppendNumber(curr.end);
+                outBuf += '\t';
+                outBuf += name;
+                outBuf += '\t';
+                AppendTag(bam, bamTag);
             }
+            outBuf += '\t';
+            outBuf += strand;
+            EndLine();
         }
     }
 }
@@ -531,8 +614,8 @@ void PrintBed12(const BamAlignment &bam, const RefVector &refs,
 {
 
     // set the strand
-    string strand = "+";
-    if (bam.IsReverseStrand()) strand = "-";
+    char strand = '+';
+    if (bam.IsReverseStrand()) strand = '-';
 
     // set the name of the feature based on the sequence
     string name = bam.Name;
@@ -549,39 +632,60 @@ void PrintBed12(const BamAlignment &bam, const RefVector &refs,
     else
         GetBamBlocks(bam, chrom, bedBlocks, true, true);
 
-    if (bamTag == "") {
-        cout << refs.at(bam.RefID).RefName << "\t"
-             << bam.Position << "\t"
-             << alignmentEnd << "\t"
-             << name << "\t"
-             << bam.MapQuality << "\t"
-             << strand << "\t";
-    }
-    else {
-        cout << refs.at(bam.RefID).RefName << "\t"
-             << bam.Position << "\t"
-             << alignmentEnd << "\t"
-             << name << "\t"
-             << PrintTag(bam, bamTag) << "\t"
-             << strand << "\t";
-    }
+    AppendBedStart(chrom, bam.Position, alignmentEnd, name);
+    if (bamTag == "")
+        AppendNumber(bam.MapQuality);
+    else
+        AppendTag(bam, bamTag);
+    outBuf += '\t';
+    outBuf += strand;
+    outBuf += '\t';
 
     // write the colors, etc.
-    printf("%d\t%d\t%s\t%d\t", bam.Position, alignmentEnd, 
-                               color.c_str(), (int) bedBlocks.size());
+    AppendNumber(bam.Position);
+    outBuf += '\t';
+    AppendNumber((int)alignmentEnd);
+    outBuf += '\t';
+    outBuf += color;
+    outBuf += '\t';
+    AppendNumber((int)bedBlocks.size());
+    outBuf += '\t';
 
     // now write the lengths portion
     unsigned int b;
-    for (b = 0; b < bedBlocks.size() - 1; ++b) {
-        printf("%d,", bedBlocks[b].end - bedBlocks[b].start);
+    for (b = 0; b < bedBlocks.size(); ++b) {
+        if (b > 0) outBuf += ',';
+        AppendNumber((int)(bedBlocks[b].end - bedBlocks[b].start));
     }
-    printf("%d\t", bedBlocks[b].end - bedBlocks[b].start);
+    outBuf += '\t';
 
     // now write the starts portion
-    for (b = 0; b < bedBlocks.size() - 1; ++b) {
-        printf("%d,", bedBlocks[b].start - bam.Position);
+    for (b = 0; b < bedBlocks.size(); ++b) {
+        if (b > 0) outBuf += ',';
+        AppendNumber((int)(bedBlocks[b].start - bam.Position));
     }
-    printf("%d\n", bedBlocks[b].start - bam.Position);
+    EndLine();
+}
+
+
+void AppendBedPE(const string &chrom1, int start1, int end1,
+                 const string &chrom2, int start2, int end2,
+                 const string &name, int score,
+                 const string &strand1, const string &strand2)
+{
+    AppendBedStart(chrom1, start1, end1, chrom2);
+    AppendNumber(start2);
+    outBuf += '\t';
+    AppendNumber(end2);
+    outBuf += '\t';
+    outBuf += name;
+    outBuf += '\t';
+    AppendNumber(score);
+    outBuf += '\t';
+    outBuf += strand1;
+    outBuf += '\t';
+    outBuf += strand2;
+    EndLine();
 }
 
 
@@ -610,6 +714,7 @@ void PrintBedPE(const BamAlignment &bam1, const BamAlignment &bam2,
         if (useEditDistance == true && 
             bam1.GetTag("NM", editDistance1) == false) 
         {
+            FlushOutput();
             cerr << "The edit distance tag (NM) was not found in the BAM file.  Please disable -ed.  Exiting\n";
             exit(1);
         }
@@ -628,6 +733,7 @@ void PrintBedPE(const BamAlignment &bam1, const BamAlignment &bam2,
         if (useEditDistance == true && 
             bam2.GetTag("NM", editDistance2) == false) 
         {
+            FlushOutput();
             cerr << "The edit distance tag (NM) was not found in the BAM file.  Please disable -ed.  Exiting\n";
             exit(1);
         }
@@ -660,12 +766,8 @@ void PrintBedPE(const BamAlignment &bam1, const BamAlignment &bam2,
         if (bam1.IsMapped() == true && bam2.IsMapped() == true)
             minMapQuality = min(bam1.MapQuality, bam2.MapQuality);
 
-        printf("%s\t%d\t%d\t%s\t%d\t%d\t%s\t%d\t%s\t%s\n",
-                chrom1.c_str(), start1, 
-                end1, chrom2.c_str(), 
-                start2, end2,
-                bam1.Name.c_str(), minMapQuality, 
-                strand1.c_str(), strand2.c_str());
+        AppendBedPE(chrom1, start1, end1, chrom2, start2, end2,
+                    bam1.Name, minMapQuality, strand1, strand2);
     }
     // report BEDPE using total edit distance
     else {
@@ -677,12 +779,8 @@ void PrintBedPE(const BamAlignment &bam1, const BamAlignment &bam2,
         else if (bam2.IsMapped() == true)
             totalEditDistance = editDistance2;
 
-        printf("%s\t%d\t%d\t%s\t%d\t%d\t%s\t%d\t%s\t%s\n",
-                chrom1.c_str(), start1, 
-                end1, chrom2.c_str(), 
-                start2, end2,
-                bam1.Name.c_str(), totalEditDistance, 
-                strand1.c_str(), strand2.c_str());
+        AppendBedPE(chrom1, start1, end1, chrom2, start2, end2,
+                    bam1.Name, totalEditDistance, strand1, strand2);
     }
 }
 
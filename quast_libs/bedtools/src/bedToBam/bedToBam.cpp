@@ -37,7 +37,8 @@ using namespace std;
 
 // function declarations
 void bedtobam_help(void);
-void ProcessBed(BedFile *bed, GenomeFile *genome, bool isBED12, int mapQual, bool uncompressedBam);
+void ProcessBed(BedFile *bed, GenomeFile *genome, bool isBED12, int mapQual, bool uncompressedBam,
+                int compressionLevel, int numThreads);
 void ConvertBedToBam(const BED &bed, BamAlignment &bam, map<string, int> &chromToId, bool isBED12, int mapQual, int lineNum);
 void MakeBamHeader(const string &genomeFile, RefVector &refs, string &header, map<string, int> &chromToInt);
 int  bedtobam_reg2bin(int beg, int end);
@@ -54,6 +55,8 @@ int bedtobam_main(int argc, char* argv[]) {
     string genomeFile;
 
     int mapQual = 255;
+    int compressionLevel = -1;
+    int numThreads = 1;
 
     bool haveBed         = true;
     bool haveGenome      = false;
@@ -103,6 +106,18 @@ int bedtobam_main(int argc, char* argv[]) {
         else if(PARAMETER_CHECK("-ubam", 5, parameterLength)) {
             uncompressedBam = true;
         }
+        else if(PARAMETER_CHECK("-bamlevel", 9, parameterLength)) {
+            if ((i+1) < argc) {
+                compressionLevel = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-threads", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                numThreads = atoi(argv[i + 1]);
+                i++;
+            }
+        }
         else {
             cerr << endl << "*****ERROR: Unrecognized parameter: " << argv[i] << " *****" << endl << endl;
             showHelp = true;
@@ -122,13 +137,21 @@ int bedtobam_main(int argc, char* argv[]) {
         cerr << endl << "*****" << endl << "*****ERROR: MAPQ must be in range [0,255]. " << endl << "*****" << endl;
         showHelp = true;
     }
+    if (compressionLevel < -1 || compressionLevel > 9) {
+        cerr << endl << "*****" << endl << "*****ERROR: -bamlevel must be in range [-1,9] (-1 is the zlib default). " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (numThreads < 1) {
+        cerr << endl << "*****" << endl << "*****ERROR: -threads must be at least 1. " << endl << "*****" << endl;
+        showHelp = true;
+    }
 
 
     if (!showHelp) {
         BedFile *bed       = new BedFile(bedFile);
         GenomeFile *genome = new GenomeFile(genomeFile);
 
-        ProcessBed(bed, genome, isBED12, mapQual, uncompressedBam);
+        ProcessBed(bed, genome, isBED12, mapQual, uncompressedBam, compressionLevel, numThreads);
     }
     else {
         bedtobam_help();
@@ -155,6 +178,13 @@ void bedtobam_help(void) {
 
     cerr << "\t-ubam\t"     << "Write uncompressed BAM output. Default writes compressed BAM." << endl << endl;
 
+    cerr << "\t-bamlevel\t" << "Compression level (0-9, or -1 for zlib default) for BAM output." << endl;
+    cerr                    << "\t\tUse 0 or 1 for temporary BAM files." << endl;
+    cerr                    << "\t\t(INT) Default: -1 (zlib default, i.e. 6)" << endl << endl;
+
+    cerr << "\t-threads\t"  << "Number of threads used to compress BAM output." << endl;
+    cerr                    << "\t\t(INT) Default: 1" << endl << endl;
+
     cerr << "Notes: " << endl;
     cerr << "\t(1)  BED files must be at least BED4 to create BAM (needs name field)." << endl << endl;
 
@@ -164,7 +194,8 @@ void bedtobam_help(void) {
 }
 
 
-void ProcessBed(BedFile *bed, GenomeFile *genome, bool isBED12, int mapQual, bool uncompressedBam) {
+void ProcessBed(BedFile *bed, GenomeFile *genome, bool isBED12, int mapQual, bool uncompressedBam,
+                int compressionLevel, int numThreads) {
 
     BamWriter *writer = new BamWriter();
 
@@ -178,6 +209,8 @@ void ProcessBed(BedFile *bed, GenomeFile *genome, bool isBED12, int mapQual, boo
     BamWriter::CompressionMode compressionMode = BamWriter::Compressed;
     if ( uncompressedBam ) compressionMode = BamWriter::Uncompressed;
     writer->SetCompressionMode(compressionMode);
+    writer->SetCompressionLevel(compressionLevel);
+    writer->SetNumThreads(numThreads);
     // open a BAM and add the reference headers to the BAM file
     writer->Open("stdout", bamHeader, refs);
 
@@ -39,6 +39,7 @@ void showHelp(const string &subCmd);
 void showErrors(const string &errors);
 
 int annotate_main(int argc, char* argv[]);//
+int bamgaps_main(int argc, char* argv[]);//
 int bamtobed_main(int argc, char* argv[]);//
 int bamtofastq_main(int argc, char* argv[]);//
 int bed12tobed6_main(int argc, char* argv[]); //
@@ -67,6 +68,7 @@ void merge_help();
 int multibamcov_main(int argc, char* argv[]);//
 int multiintersect_main(int argc, char* argv[]);//
 int nuc_main(int argc, char* argv[]);//
+int pairstats_main(int argc, char* argv[]);//
 int pairtobed_main(int argc, char* argv[]);//
 int pairtopair_main(int argc, char* argv[]);//
 int random_main(int argc, char* argv[]); //
@@ -140,6 +142,8 @@ int main(int argc, char *argv[])
     // BAM-specific tools
     else if (subCmd == "multicov")    return multibamcov_main(argc-1, argv+1);
     else if (subCmd == "tag")         return tagbam_main(argc-1, argv+1);
+    else if (subCmd == "bamgaps")     return bamgaps_main(argc-1, argv+1);
+    else if (subCmd == "pairstats")   return pairstats_main(argc-1, argv+1);
 
     // fasta tools
     else if (subCmd == "getfasta")    return fastafrombed_main(argc-1, argv+1);
@@ -255,6 +259,8 @@ int bedtools_help(void)
     cout  << "[ BAM focused tools ]" << endl;
     cout  << "    multicov      "  << "Counts coverage from multiple BAMs at specific intervals.\n";
     cout  << "    tag           "  << "Tag BAM alignments based on overlaps with interval files.\n";
+    cout  << "    bamgaps       "  << "Find zero-covered regions and deletions in a sorted BAM file.\n";
+    cout  << "    pairstats     "  << "Estimate the insert size and read length of the pairs in a BAM file.\n";
 
     cout  << endl;
     cout  << "[ Statistical relationships ]" << endl;
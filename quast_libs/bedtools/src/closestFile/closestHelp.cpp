@@ -74,6 +74,7 @@ void closest_help(void) {
 
     IntersectCommonHelp();
     multiDbOutputHelp();
+    sortedThreadsHelp();
     allToolsCommonHelp();
 
     cerr << "Notes: " << endl;
@@ -16,7 +16,7 @@ CoverageFile::CoverageFile(ContextCoverage *context)
  _totalQueryLen(0),
  _hitCount(0),
  _queryOffset(0),
- _floatValBuf(NULL)
+ _valBuf(NULL)
 {
 	//allocate and initialize depth array.
 	//Use C's malloc and free becauase we want
@@ -27,12 +27,12 @@ CoverageFile::CoverageFile(ContextCoverage *context)
 	memset(_depthArray, 0, newSize);
 	_depthArrayCapacity = DEFAULT_DEPTH_CAPACITY;
 
-	_floatValBuf = new char[floatValBufLen];
+	_valBuf = new char[valBufLen];
 }
 
 CoverageFile::~CoverageFile() {
 	free(_depthArray);
-	delete _floatValBuf;
+	delete [] _valBuf;
 }
 
 
@@ -88,18 +88,8 @@ void CoverageFile::giveFinalReport(RecordOutputMgr *outputMgr) {
 		//cout << "x\n";
 		float depthPct = (float)basesAtDepth / (float)_totalQueryLen;
 		//cout << "y\n";
-		ostringstream s;
-		s << "all\t";
-		s << depth;
-		s << "\t";
-		s << basesAtDepth;
-		s << "\t";
-		s << _totalQueryLen;
-		s << "\t";
-		char *depthPctString;
-		asprintf(&depthPctString, "%0.7f", depthPct);
-		s << depthPctString;
-		_finalOutput = s.str();
+		int len = snprintf(_valBuf, valBufLen, "all\t%zu\t%zu\t%zu\t%0.7f", depth, basesAtDepth, _totalQueryLen, depthPct);
+		_finalOutput.assign(_valBuf, len);
 
 		outputMgr->printRecord(NULL, _finalOutput);
 	}
@@ -148,9 +138,8 @@ size_t CoverageFile::countBasesAtDepth(size_t depth) {
 
 void CoverageFile::doCounts(RecordOutputMgr *outputMgr, RecordKeyVector &hits)
 {
-	ostringstream s;
-	s << _hitCount;
-	_finalOutput.append(s.str());
+	int len = snprintf(_valBuf, valBufLen, "%zu", _hitCount);
+	_finalOutput.append(_valBuf, len);
 	outputMgr->printRecord(hits.getKey(), _finalOutput);
 }
 
@@ -160,11 +149,8 @@ void CoverageFile::doPerBase(RecordOutputMgr *outputMgr, RecordKeyVector &hits)
 	
 	Record * queryRec = hits.getKey();
 	for (size_t i= 0; i < _queryLen; i++) {
-		ostringstream s;
-		s << (i+1);
-		s << "\t";
-		s << _depthArray[i];
-		_finalOutput = s.str();
+		int len = snprintf(_valBuf, valBufLen, "%zu\t%zu", i+1, _depthArray[i]);
+		_finalOutput.assign(_valBuf, len);
 		outputMgr->printRecord(queryRec, _finalOutput);
 	}
 }
@@ -175,12 +161,9 @@ void CoverageFile::doMean(RecordOutputMgr *outputMgr, RecordKeyVector &hits)
 	for (size_t i= 0; i < _queryLen; i++) {
 		sum += _depthArray[i];
 	}
-	ostringstream s;
 	float mean = ((float)sum / (float)_queryLen);
-	char *meanString;
-	asprintf(&meanString, "%0.7f", mean);
-	s << meanString;
-	_finalOutput.append(s.str());
+	int len = snprintf(_valBuf, valBufLen, "%0.7f", mean);
+	_finalOutput.append(_valBuf, len);
 	outputMgr->printRecord(hits.getKey(), _finalOutput);
 }
 
@@ -199,17 +182,8 @@ void CoverageFile::doHist(RecordOutputMgr *outputMgr, RecordKeyVector &hits)
 		size_t numBasesAtDepth = iter->second;
 		float coveredFraction = (float)numBasesAtDepth / (float)_queryLen;
 
-		ostringstream s;
-		s << depth;
-		s << "\t";
-		s << numBasesAtDepth;
-		s << "\t";
-		s << _queryLen;
-		s << "\t";
-		char *coveredFractionString;
-		asprintf(&coveredFractionString, "%0.7f", coveredFraction);
-		s << coveredFractionString;
-		_finalOutput = s.str();
+		int len = snprintf(_valBuf, valBufLen, "%zu\t%zu\t%zu\t%0.7f", depth, numBasesAtDepth, _queryLen, coveredFraction);
+		_finalOutput.assign(_valBuf, len);
 		outputMgr->printRecord(hits.getKey(), _finalOutput);
 	}
 }
@@ -219,17 +193,8 @@ void CoverageFile::doDefault(RecordOutputMgr *outputMgr, RecordKeyVector &hits)
 	size_t nonZeroBases = _queryLen - countBasesAtDepth(0);
 	float coveredFraction = (float)nonZeroBases / (float)_queryLen;
 
-	ostringstream s;
-	s << _hitCount;
-	s << "\t";
-	s << nonZeroBases;
-	s << "\t";
-	s << _queryLen;
-	s << "\t";
-	char *coveredFractionString;
-	asprintf(&coveredFractionString, "%0.7f", coveredFraction);
-	s << coveredFractionString;
-	_finalOutput = s.str();
+	int len = snprintf(_valBuf, valBufLen, "%zu\t%zu\t%zu\t%0.7f", _hitCount, nonZeroBases, _queryLen, coveredFraction);
+	_finalOutput.assign(_valBuf, len);
 	outputMgr->printRecord(hits.getKey(), _finalOutput);
 }
 
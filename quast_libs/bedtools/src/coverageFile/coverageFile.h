@@ -31,8 +31,9 @@ protected:
 	size_t _hitCount;
 	int _queryOffset;
 	static const int DEFAULT_DEPTH_CAPACITY = 1024;
-	char *_floatValBuf;
-	static const int floatValBufLen = 16;
+	//formatted output values, printed with snprintf instead of streams.
+	char *_valBuf;
+	static const int valBufLen = 128;
 
 	typedef map<size_t, size_t> depthMapType;
 	depthMapType _currDepthMap;
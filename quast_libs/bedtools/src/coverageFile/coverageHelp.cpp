@@ -39,6 +39,7 @@ void coverage_help(void) {
 
     IntersectCommonHelp();
     sortedHelp();
+    sortedThreadsHelp();
     allToolsCommonHelp();
 
     cerr << "Default Output:  " << endl;
@@ -12,13 +12,23 @@
 #include "lineFileUtilities.h"
 #include "fastaFromBed.h"
 #include "bedFile.h"
+#include <thread>
+
+// a batch ends after this many features or bases, whichever comes first
+static const int MAX_BATCH_FEATURES = 1 << 16;
+static const size_t MAX_BATCH_BASES = 1 << 26;
+// the features are handed out to the threads in runs of this many
+static const size_t BATCH_RUN_SIZE = 64;
+// the output is written in chunks of about this size
+static const size_t MAX_OUTBUF_SIZE = 1 << 20;
 
 
 Bed2Fa::Bed2Fa(const string &dbFile, 
                const string &bedFile, const string &fastaOutFile,
                bool useFasta, bool useStrand, 
                bool useBlocks, bool useFullHeader,
-               bool useBedOut, bool useName, bool useNamePlus) :
+               bool useBedOut, bool useName, bool useNamePlus,
+               int numThreads) :
     _dbFile(dbFile),
     _bedFile(bedFile),
     _fastaOutFile(fastaOutFile),
@@ -28,7 +38,8 @@ Bed2Fa::Bed2Fa(const string &dbFile,
     _useFullHeader(useFullHeader),
     _useBedOut(useBedOut),
     _useName(useName),
-    _useNamePlus(useNamePlus)
+    _useNamePlus(useNamePlus),
+    _numThreads(numThreads)
 {
     _bed = new BedFile(_bedFile);
 
@@ -60,44 +71,35 @@ Bed2Fa::~Bed2Fa(void) {
 
 
 //******************************************************************************
-// ReportDNA
+// ReportHeader: start the output record of a feature, the sequence follows
 //******************************************************************************
-void Bed2Fa::ReportDNA(const BED &bed, string &dna) {
-
-    // revcomp if necessary.  Thanks to Thomas Doktor.
-    if ((_useStrand == true) && (bed.strand == "-"))
-        reverseComplement(dna);
+void Bed2Fa::ReportHeader(const BED &bed, string &output) const {
 
-    if (_useBedOut) {
-        _bed->reportBedTab(bed);
-        *_faOut  << dna << endl;
-    }
-    else {
-        ostringstream header;
+    // with -bedOut, the BED record itself is printed by ReportBatch()
+    output.clear();
+    if (!_useBedOut) {
+        if (_useFasta)
+            output += '>';
         if (_useName)
         {
-            header << bed.name;
+            output += bed.name;
         }
         else if (_useNamePlus) 
         {
-            header << bed.name << "::" << bed.chrom << ":" 
-                   << bed.start << "-" << bed.end;
+            output += bed.name + "::" + bed.chrom + ":" 
+                    + to_string(bed.start) + "-" + to_string(bed.end);
         }
         else 
         {
-            header << bed.chrom << ":" 
-                   << bed.start << "-" << bed.end;
+            output += bed.chrom + ":" 
+                    + to_string(bed.start) + "-" + to_string(bed.end);
         }
         
         if (_useStrand)
         {
-            header << "(" << bed.strand << ")";
+            output += "(" + bed.strand + ")";
         }
-        
-        if (_useFasta)
-            *_faOut << ">" << header.str() << endl << dna << endl;
-        else
-            *_faOut << header.str() << "\t" << dna << endl;
+        output += _useFasta ? '\n' : '\t';
     }
 }
 
@@ -125,69 +127,214 @@ void Bed2Fa::ExtractDNA() {
     fr->open(_dbFile, memmap, _useFullHeader);
 
     BED bed, nullBed;
-    string sequence;
+    string outBuf;
+    int batchSize = 0;
+    size_t batchBases = 0;
 
     _bed->Open();
     while (_bed->GetNextBed(bed)) {
         if (_bed->_status == BED_VALID) {
-            // make sure we are extracting >= 1 bp
-            if (bed.zeroLength == false) {
-    
-                size_t seqLength = fr->sequenceLength(bed.chrom);
-                // seqLength > 0 means chrom was found in index.
-                // seqLength == 0 otherwise.
-                if (seqLength) {
-                    // make sure this feature will not exceed 
-                    // the end of the chromosome.
-                    if ( (bed.start <= seqLength) && (bed.end <= seqLength) ) 
-                    {
-                        int length = bed.end - bed.start;
-                        if(_useBlocks){
-                            // vec to store the discrete BED "blocks"
-                            bedVector bedBlocks;  
-                            GetBedBlocks(bed, bedBlocks);
-                            sequence.clear();
-                            for (int i = 0; i < (int) bedBlocks.size(); ++i) {
-                                sequence += fr->getSubSequence(bed.chrom,
-                                        bedBlocks[i].start,
-                                        bedBlocks[i].end - bedBlocks[i].start);
-                            }
-                        } else {
-                            sequence = \
-                               fr->getSubSequence(bed.chrom, bed.start, length);
-                        }
-                        ReportDNA(bed, sequence);
-                    }
-                    else
-                    {
-                        cerr << "Feature (" << bed.chrom << ":" 
-                             << bed.start << "-" << bed.end 
-                            << ") beyond the length of "
-                            << bed.chrom 
-                            << " size (" << seqLength << " bp).  Skipping." 
-                            << endl;
-                    }
+            if (batchSize == (int) _batch.size())
+                _batch.push_back(Feature());
+            Feature &feature = _batch[batchSize++];
+            feature.bed = move(bed);
+            CheckFeature(fr, feature);
+            if (feature.status == FEATURE_OK)
+                batchBases += feature.bed.end - feature.bed.start;
+
+            if (batchSize == MAX_BATCH_FEATURES || batchBases >= MAX_BATCH_BASES) {
+                ExtractBatch(fr, batchSize);
+                ReportBatch(batchSize, outBuf);
+                batchSize = 0;
+                batchBases = 0;
+            }
+            bed = nullBed;
+        }
+    }
+    ExtractBatch(fr, batchSize);
+    ReportBatch(batchSize, outBuf);
+    _faOut->write(outBuf.data(), outBuf.size());
+    _faOut->flush();
+    _bed->Close();
+    delete fr;
+}
+
+
+//******************************************************************************
+// CheckFeature: can the feature be extracted, and from which sequence?
+//******************************************************************************
+void Bed2Fa::CheckFeature(const FastaReference *fr, Feature &feature) const {
+
+    const BED &bed = feature.bed;
+    feature.entry = NULL;
+    // make sure we are extracting >= 1 bp
+    if (bed.zeroLength) {
+        feature.status = FEATURE_ZERO_LENGTH;
+        return;
+    }
+    // a sequence of length 0 is as good as missing
+    FastaIndex::const_iterator entryItr = fr->index->find(bed.chrom);
+    if (entryItr == fr->index->end() || entryItr->second.length == 0) {
+        feature.status = FEATURE_NO_CHROM;
+        return;
+    }
+    feature.entry = &entryItr->second;
+    // make sure this feature will not exceed 
+    // the end of the chromosome.
+    size_t seqLength = feature.entry->length;
+    if ( (bed.start <= seqLength) && (bed.end <= seqLength) )
+        feature.status = FEATURE_OK;
+    else
+        feature.status = FEATURE_BEYOND_END;
+}
+
+
+//******************************************************************************
+// ExtractBatch: extract the sequences of the first batchSize features of
+// the batch in the order of the FASTA file, spread over the threads
+//******************************************************************************
+void Bed2Fa::ExtractBatch(const FastaReference *fr, int batchSize) {
+
+    _batchOrder.clear();
+    for (int i = 0; i < batchSize; ++i) {
+        if (_batch[i].status == FEATURE_OK)
+            _batchOrder.push_back(i);
+    }
+    const vector<Feature> &batch = _batch;
+    sort(_batchOrder.begin(), _batchOrder.end(), [&batch](int a, int b) {
+        if (batch[a].entry->offset != batch[b].entry->offset)
+            return batch[a].entry->offset < batch[b].entry->offset;
+        if (batch[a].bed.start != batch[b].bed.start)
+            return batch[a].bed.start < batch[b].bed.start;
+        return a < b;
+    });
+
+    _nextBatchFeature = 0;
+    const int numRuns = (_batchOrder.size() + BATCH_RUN_SIZE - 1) / BATCH_RUN_SIZE;
+    const int numWorkers = min(_numThreads, numRuns);
+    if (numWorkers <= 1) {
+        ExtractBatchWorker(fr);
+        return;
+    }
+    vector<thread> workers;
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back(thread(&Bed2Fa::ExtractBatchWorker, this, fr));
+    for (int i = 0; i < numWorkers; ++i)
+        workers[i].join();
+}
+
+
+void Bed2Fa::ExtractBatchWorker(const FastaReference *fr) {
+
+    const size_t numFeatures = _batchOrder.size();
+    while (true) {
+        const size_t first = _nextBatchFeature.fetch_add(BATCH_RUN_SIZE);
+        if (first >= numFeatures)
+            return;
+        const size_t last = min(first + BATCH_RUN_SIZE, numFeatures);
+        for (size_t i = first; i < last; ++i)
+            ExtractFeature(fr, _batch[_batchOrder[i]]);
+    }
+}
+
+
+static void AppendSubSequence(const FastaReference *fr, const FastaIndexEntry &entry,
+                              int start, int length, string &sequence) {
+    if (start < 0 || length < 1) {
+        cerr << "Error: cannot construct subsequence with negative offset or length < 1" << endl;
+        exit(1);
+    }
+    fr->appendSubSequence(entry, start, length, sequence);
+}
+
+
+void Bed2Fa::ExtractFeature(const FastaReference *fr, Feature &feature) const {
+
+    const BED &bed = feature.bed;
+    ReportHeader(bed, feature.output);
+
+    // the sequence goes straight to the output, unless it has to be
+    // reverse complemented first.  Thanks to Thomas Doktor.
+    const bool useRevComp = (_useStrand == true) && (bed.strand == "-");
+    string &sequence = useRevComp ? feature.sequence : feature.output;
+    if (useRevComp)
+        sequence.clear();
+    if(_useBlocks){
+        // vec to store the discrete BED "blocks"
+        bedVector bedBlocks;  
+        GetBedBlocks(bed, bedBlocks);
+        for (int i = 0; i < (int) bedBlocks.size(); ++i) {
+            AppendSubSequence(fr, *feature.entry, bedBlocks[i].start,
+                              bedBlocks[i].end - bedBlocks[i].start, sequence);
+        }
+    } else {
+        AppendSubSequence(fr, *feature.entry, bed.start, bed.end - bed.start, sequence);
+    }
+    if (useRevComp) {
+        reverseComplement(sequence);
+        feature.output += sequence;
+    }
+    feature.output += '\n';
+}
+
+
+//******************************************************************************
+// ReportBatch: report the first batchSize features of the batch in BED order
+//******************************************************************************
+void Bed2Fa::ReportBatch(int batchSize, string &outBuf) {
+
+    for (int i = 0; i < batchSize; ++i) {
+        Feature &feature = _batch[i];
+        const BED &bed = feature.bed;
+        switch (feature.status) {
+            case FEATURE_OK:
+                if (_useBedOut) {
+                    // the BED record goes to stdout, so nothing can wait in outBuf
+                    _faOut->write(outBuf.data(), outBuf.size());
+                    outBuf.clear();
+                    _bed->reportBedTab(bed);
+                    _faOut->write(feature.output.data(), feature.output.size());
                 }
-                else
-                {
-                    cerr << "WARNING. chromosome (" 
-                         << bed.chrom 
-                         << ") was not found in the FASTA file. Skipping."
-                         << endl;
+                else if (feature.output.size() >= MAX_OUTBUF_SIZE) {
+                    // no point in copying long records
+                    _faOut->write(outBuf.data(), outBuf.size());
+                    outBuf.clear();
+                    _faOut->write(feature.output.data(), feature.output.size());
                 }
-            }
+                else {
+                    outBuf += feature.output;
+                    if (outBuf.size() >= MAX_OUTBUF_SIZE) {
+                        _faOut->write(outBuf.data(), outBuf.size());
+                        outBuf.clear();
+                    }
+                }
+                break;
+            case FEATURE_BEYOND_END:
+                cerr << "Feature (" << bed.chrom << ":" 
+                     << bed.start << "-" << bed.end 
+                    << ") beyond the length of "
+                    << bed.chrom 
+                    << " size (" << feature.entry->length << " bp).  Skipping." 
+                    << endl;
+                break;
+            case FEATURE_NO_CHROM:
+                cerr << "WARNING. chromosome (" 
+                     << bed.chrom 
+                     << ") was not found in the FASTA file. Skipping."
+                     << endl;
+                break;
             // handle zeroLength 
-            else {
+            case FEATURE_ZERO_LENGTH:
                 cerr << "Feature (" << bed.chrom << ":" 
                      << bed.start+1 << "-" << bed.end-1 
                      << ") has length = 0, Skipping." 
                      << endl;
-            }
-            bed = nullBed;
+                break;
+        }
+        // don't keep the buffers of long features around
+        if (feature.output.capacity() > MAX_OUTBUF_SIZE || feature.sequence.capacity() > MAX_OUTBUF_SIZE) {
+            string().swap(feature.sequence);
+            string().swap(feature.output);
         }
     }
-    _bed->Close();
 }
-
-
-
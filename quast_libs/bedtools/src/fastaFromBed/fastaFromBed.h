@@ -19,6 +19,7 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <atomic>
 
 using namespace std;
 
@@ -34,17 +35,29 @@ public:
            const string &bedFile, const string &fastaOutFile,
            bool useFasta, bool useStrand, 
            bool useBlocks, bool useFullHeader,
-           bool useBedOut, bool useName, bool useNamePlus);
+           bool useBedOut, bool useName, bool useNamePlus,
+           int numThreads);
 
     // destructor
     ~Bed2Fa(void);
 
     void ExtractDNA();
-    void ReportDNA(const BED &bed, string &dna);
 
 
 private:
 
+    // why a feature is skipped, if it is
+    enum FeatureStatus { FEATURE_OK, FEATURE_ZERO_LENGTH, FEATURE_NO_CHROM, FEATURE_BEYOND_END };
+
+    // a feature of the current batch and its FASTA (or tab) record
+    struct Feature {
+        BED bed;
+        FeatureStatus status;
+        const FastaIndexEntry *entry;
+        string sequence;    // only for reverse complements
+        string output;
+    };
+
     string _dbFile;
     string _bedFile;
     string _fastaOutFile;
@@ -56,10 +69,24 @@ private:
     bool _useBedOut;    // priginal BED records followed by FASTA on same line
     bool _useName;
     bool _useNamePlus;
+    int _numThreads;
+
+    // the batch being extracted: the features are read in BED order, extracted
+    // in FASTA order by the threads, and reported in BED order again
+    vector<Feature> _batch;
+    vector<int> _batchOrder;
+    atomic<size_t> _nextBatchFeature;
 
     // instance of a bed file class.
     BedFile  *_bed;
     ostream *_faOut;
+
+    void CheckFeature(const FastaReference *fr, Feature &feature) const;
+    void ExtractBatch(const FastaReference *fr, int batchSize);
+    void ExtractBatchWorker(const FastaReference *fr);
+    void ExtractFeature(const FastaReference *fr, Feature &feature) const;
+    void ReportHeader(const BED &bed, string &output) const;
+    void ReportBatch(int batchSize, string &outBuf);
 };
 
 #endif
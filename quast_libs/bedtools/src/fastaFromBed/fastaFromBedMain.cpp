@@ -47,6 +47,7 @@ int fastafrombed_main(int argc, char* argv[]) {
     bool useBlocks = false;
     bool useFullHeader = false;
     bool useBedOut = false;
+    int numThreads = 1;
 
     // check to see if we should print out some help
     if(argc <= 1) showHelp = true;
@@ -110,6 +111,12 @@ int fastafrombed_main(int argc, char* argv[]) {
         else if(PARAMETER_CHECK("-fullHeader", 11, parameterLength)) {
             useFullHeader = true;
         }
+        else if(PARAMETER_CHECK("-threads", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                numThreads = atoi(argv[i + 1]);
+                i++;
+            }
+        }
         else {
             cerr << "*****ERROR: Unrecognized parameter: " 
                  << argv[i] 
@@ -122,6 +129,10 @@ int fastafrombed_main(int argc, char* argv[]) {
     if (!haveFastaDb || !haveBed) {
         showHelp = true;
     }
+    if (numThreads < 1) {
+        cerr << endl << "*****" << endl << "*****ERROR: -threads must be at least 1. " << endl << "*****" << endl;
+        showHelp = true;
+    }
 
     if (!haveFastaOut) {
         fastaOutFile = "stdout";
@@ -133,7 +144,8 @@ int fastafrombed_main(int argc, char* argv[]) {
                                  bedFile, fastaOutFile,
                                  useFasta, useStrand, 
                                  useBlocks, useFullHeader,
-                                 useBedOut, useName, useNamePlus);
+                                 useBedOut, useName, useNamePlus,
+                                 numThreads);
         delete b2f;
     }
     else {
@@ -170,6 +182,9 @@ void fastafrombed_help(void) {
     cerr << "\t-fullHeader\tUse full fasta header." << endl;
     cerr << "\t\t- By default, only the word before the first space or tab "
 	     << "\n\t\tis used." << endl << endl;
+    cerr << "\t-threads\tNumber of threads extracting the sequences." << endl;
+    cerr << "\t\t- The output keeps the order of the BED file." << endl;
+    cerr << "\t\t- Default is 1." << endl << endl;
 
     // end the program here
     exit(1);
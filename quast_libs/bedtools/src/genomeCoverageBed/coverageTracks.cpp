@@ -0,0 +1,91 @@
+/*****************************************************************************
+coverageTracks.cpp
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "lineFileUtilities.h"
+#include "coverageTracks.h"
+#include <algorithm>
+#include <iostream>
+#include <stdlib.h>
+
+
+CoverageTracks::CoverageTracks(const string &tracksFile, bool byReadGroup, const RefVector &refs)
+: _byReadGroup(byReadGroup)
+{
+    ifstream tracks(tracksFile.c_str());
+    if (!tracks) {
+        cerr << "Error: The tracks file (" << tracksFile << ") could not be opened.  Exiting!" << endl;
+        exit(1);
+    }
+
+    const int numRefs = refs.size();
+    _refTracks.resize(numRefs);
+
+    string line;
+    vector<string> fields;
+    while (getline(tracks, line)) {
+        fields.clear();
+        Tokenize(line, fields);
+        if (fields.size() < 2 || fields[1].empty())
+            continue;
+        const string &key = fields[0];
+        const int track = AddTrack(fields[1], numRefs);
+
+        if (_byReadGroup) {
+            AddUnique(_readGroupTracks[key], track);
+            continue;
+        }
+        const bool isPrefix = !key.empty() && key[key.size() - 1] == '*';
+        const string name = isPrefix ? key.substr(0, key.size() - 1) : key;
+        for (int refId = 0; refId < numRefs; ++refId) {
+            const string &refName = refs[refId].RefName;
+            if (isPrefix ? refName.compare(0, name.size(), name) == 0 : refName == name) {
+                AddUnique(_refTracks[refId], track);
+                _hasRef[track][refId] = true;
+            }
+        }
+    }
+
+    // read group tracks cover the whole genome
+    if (_byReadGroup) {
+        for (int track = 0; track < Size(); ++track)
+            _hasRef[track].assign(numRefs, true);
+    }
+}
+
+
+CoverageTracks::~CoverageTracks(void) {
+    for (size_t track = 0; track < _outputs.size(); ++track)
+        delete _outputs[track];
+}
+
+
+const vector<int> &CoverageTracks::ReadGroupTracks(const string &readGroup) const {
+    map<string, vector<int> >::const_iterator tracksItr = _readGroupTracks.find(readGroup);
+    return tracksItr != _readGroupTracks.end() ? tracksItr->second : _noTracks;
+}
+
+
+// the track writing to this file, opened on its first line
+int CoverageTracks::AddTrack(const string &fileName, int numRefs) {
+    vector<string>::const_iterator fileItr = find(_fileNames.begin(), _fileNames.end(), fileName);
+    if (fileItr != _fileNames.end())
+        return fileItr - _fileNames.begin();
+
+    ofstream *output = new ofstream(fileName.c_str());
+    if (!*output) {
+        cerr << "Error: The track file (" << fileName << ") could not be created.  Exiting!" << endl;
+        exit(1);
+    }
+    _fileNames.push_back(fileName);
+    _outputs.push_back(output);
+    _hasRef.push_back(vector<bool>(numRefs, false));
+    return Size() - 1;
+}
+
+
+void CoverageTracks::AddUnique(vector<int> &tracks, int track) {
+    if (find(tracks.begin(), tracks.end(), track) == tracks.end())
+        tracks.push_back(track);
+}
@@ -0,0 +1,65 @@
+/*****************************************************************************
+coverageTracks.h
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#ifndef COVERAGETRACKS_H
+#define COVERAGETRACKS_H
+
+#include "api/BamAux.h"
+using namespace BamTools;
+
+#include <vector>
+#include <map>
+#include <string>
+#include <fstream>
+using namespace std;
+
+
+//************************************************
+// The output tracks of genomecov -tracks, read from
+// a tab-delimited file of (key, output file) lines.
+//
+// By default the keys are reference names: a key
+// ending with '*' is a prefix of the names ('*' alone
+// matches all of them). With read groups, the keys
+// are RG IDs, and every track covers all references.
+// The lines with the same output file make up one
+// track, and an alignment counts in every track it
+// matches.
+//************************************************
+class CoverageTracks {
+
+public:
+
+    CoverageTracks(const string &tracksFile, bool byReadGroup, const RefVector &refs);
+    ~CoverageTracks(void);
+
+    int Size() const { return (int)_fileNames.size(); }
+    bool ByReadGroup() const { return _byReadGroup; }
+
+    ostream &Output(int track) { return *_outputs[track]; }
+
+    // true if the track reports this reference
+    bool HasRef(int track, int refId) const { return _hasRef[track][refId]; }
+
+    // the tracks of the alignments on a reference (reference keys),
+    // or of the alignments of a read group (read group keys)
+    const vector<int> &RefTracks(int refId) const { return _refTracks[refId]; }
+    const vector<int> &ReadGroupTracks(const string &readGroup) const;
+
+private:
+
+    bool _byReadGroup;
+    vector<string> _fileNames;
+    vector<ofstream *> _outputs;
+    vector<vector<bool> > _hasRef;          // by track, then by RefID
+    vector<vector<int> > _refTracks;        // by RefID
+    map<string, vector<int> > _readGroupTracks;
+    vector<int> _noTracks;
+
+    int AddTrack(const string &fileName, int numRefs);
+    static void AddUnique(vector<int> &tracks, int track);
+};
+
+#endif /* COVERAGETRACKS_H */
@@ -0,0 +1,119 @@
+/*****************************************************************************
+depthDeltas.cpp
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "depthDeltas.h"
+#include <algorithm>
+
+
+DepthDeltas::DepthDeltas()
+: _size(0),
+  _isDense(false),
+  _runPos(0),
+  _runDepth(0),
+  _eventIdx(0)
+{
+}
+
+
+void DepthDeltas::Reset(int chromSize) {
+    _size = (chromSize > 0) ? chromSize : 0;
+    std::vector<event>().swap(_events);
+    std::vector<int>().swap(_deltas);
+    _isDense = false;
+    _runPos = 0;
+    _runDepth = 0;
+    _eventIdx = 0;
+}
+
+
+void DepthDeltas::AddCoverage(int start, int end) {
+    // the old engine counted starts[start] and ends[end], with out-of-range
+    // ends piled onto the last base. depth at pos was the sum of starts up to
+    // pos minus the sum of ends before pos, so an end at the last base (or
+    // anywhere off the chromosome) never lowers a reported depth.
+    if (start >= 0 && start < _size)
+        AddDelta(start, 1);
+    if (end >= 0 && end + 1 < _size)
+        AddDelta(end + 1, -1);
+}
+
+
+void DepthDeltas::AddDelta(int pos, int delta) {
+    if (_isDense) {
+        _deltas[pos] += delta;
+        return;
+    }
+    _events.push_back(event(pos, delta));
+    // switch to one int per base once that is the smaller representation
+    if (_events.size() * sizeof(event) >= (size_t)_size * sizeof(int))
+        MakeDense();
+}
+
+
+void DepthDeltas::MakeDense() {
+    _deltas.assign(_size, 0);
+    vector<event>::const_iterator eventItr = _events.begin();
+    vector<event>::const_iterator eventEnd = _events.end();
+    for (; eventItr != eventEnd; ++eventItr)
+        _deltas[eventItr->first] += eventItr->second;
+    std::vector<event>().swap(_events);
+    _isDense = true;
+}
+
+
+// sum of all deltas at pos. in sparse mode, positions must be asked for in
+// increasing order, as this consumes the sorted events.
+int DepthDeltas::DeltaAt(int pos) {
+    if (_isDense)
+        return _deltas[pos];
+    int delta = 0;
+    while (_eventIdx < _events.size() && _events[_eventIdx].first == pos)
+        delta += _events[_eventIdx++].second;
+    return delta;
+}
+
+
+void DepthDeltas::BeginRuns() {
+    if (!_isDense)
+        sort(_events.begin(), _events.end());
+    _eventIdx = 0;
+    _runPos = 0;
+    _runDepth = (_size > 0) ? DeltaAt(0) : 0;
+}
+
+
+bool DepthDeltas::NextRun(int &start, int &end, int &depth) {
+    if (_runPos >= _size)
+        return false;
+
+    start = _runPos;
+    depth = _runDepth;
+
+    // find the next position where the depth actually changes
+    int pos = _runPos + 1;
+    int nextDepth = depth;
+    while (pos < _size) {
+        if (_isDense) {
+            nextDepth = depth + _deltas[pos];
+        }
+        else {
+            // jump straight to the next event
+            if (_eventIdx >= _events.size()) {
+                pos = _size;
+                break;
+            }
+            pos = _events[_eventIdx].first;
+            nextDepth = depth + DeltaAt(pos);
+        }
+        if (nextDepth != depth)
+            break;
+        ++pos;
+    }
+
+    end = pos;
+    _runPos = pos;
+    _runDepth = nextDepth;
+    return true;
+}
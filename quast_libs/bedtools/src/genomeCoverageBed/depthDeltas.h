@@ -0,0 +1,64 @@
+/*****************************************************************************
+depthDeltas.h
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#ifndef DEPTHDELTAS_H
+#define DEPTHDELTAS_H
+
+#include <vector>
+#include <utility>
+using namespace std;
+
+
+//************************************************
+// Coverage of a single chromosome, kept as depth
+// changes rather than per-base start/end counts.
+//
+// Intervals are first recorded as a sparse list of
+// (position, delta) events. Once that list would take
+// more memory than one int per base, it is folded
+// into a dense delta array. Either way, depth runs
+// are recovered by a prefix sum, one run at a time.
+//************************************************
+class DepthDeltas {
+
+public:
+
+    DepthDeltas();
+
+    // forget all coverage and start over on a chromosome of chromSize bases
+    void Reset(int chromSize);
+
+    // add one to the depth of [start, end] (end is inclusive).
+    // out-of-range ends are handled like the old vector<DEPTH> engine did.
+    void AddCoverage(int start, int end);
+
+    int Size() const { return _size; }
+
+    // iterate over maximal runs of constant depth, covering [0, Size()).
+    // call BeginRuns() first; NextRun() returns false when done.
+    // runs are half-open: [start, end).
+    void BeginRuns();
+    bool NextRun(int &start, int &end, int &depth);
+
+private:
+
+    typedef pair<int, int> event;
+
+    int _size;
+    vector<event> _events;   // sparse mode: unsorted (position, delta) pairs
+    vector<int> _deltas;     // dense mode: delta at each position
+    bool _isDense;
+
+    // run iteration state
+    int _runPos;
+    int _runDepth;
+    size_t _eventIdx;
+
+    void AddDelta(int pos, int delta);
+    void MakeDense();
+    int DeltaAt(int pos);
+};
+
+#endif /* DEPTHDELTAS_H */
@@ -0,0 +1,89 @@
+/*****************************************************************************
+depthHistogram.cpp
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "depthHistogram.h"
+
+
+DepthHistogram::DepthHistogram()
+: _denseIdx(0)
+{
+    _overflowIt = _overflow.end();
+}
+
+
+void DepthHistogram::Add(int depth, unsigned int numBases) {
+    if (depth >= 0 && depth < DENSE_DEPTHS) {
+        if ((size_t)depth >= _dense.size())
+            _dense.resize(depth + 1, 0);
+        _dense[depth] += numBases;
+    }
+    else {
+        _overflow[depth] += numBases;
+    }
+}
+
+
+void DepthHistogram::Merge(const DepthHistogram &other) {
+    if (other._dense.size() > _dense.size())
+        _dense.resize(other._dense.size(), 0);
+    for (size_t depth = 0; depth < other._dense.size(); ++depth)
+        _dense[depth] += other._dense[depth];
+
+    overflowMap::const_iterator depthIt = other._overflow.begin();
+    overflowMap::const_iterator depthEnd = other._overflow.end();
+    for (; depthIt != depthEnd; ++depthIt)
+        _overflow[depthIt->first] += depthIt->second;
+}
+
+
+void DepthHistogram::Clear() {
+    std::vector<unsigned int>().swap(_dense);
+    _overflow.clear();
+    _overflowIt = _overflow.end();
+    _denseIdx = 0;
+}
+
+
+void DepthHistogram::Swap(DepthHistogram &other) {
+    _dense.swap(other._dense);
+    _overflow.swap(other._overflow);
+    _overflowIt = _overflow.end();
+    _denseIdx = 0;
+    other._overflowIt = other._overflow.end();
+    other._denseIdx = 0;
+}
+
+
+void DepthHistogram::BeginBins() {
+    _overflowIt = _overflow.begin();
+    _denseIdx = 0;
+}
+
+
+bool DepthHistogram::NextBin(int &depth, unsigned int &numBases) {
+    // negative depths sort before the dense part
+    if (_overflowIt != _overflow.end() && _overflowIt->first < 0) {
+        depth = _overflowIt->first;
+        numBases = _overflowIt->second;
+        ++_overflowIt;
+        return true;
+    }
+    // skip depths without any bases, they never made it into the old map either
+    while (_denseIdx < _dense.size()) {
+        size_t idx = _denseIdx++;
+        if (_dense[idx] > 0) {
+            depth = idx;
+            numBases = _dense[idx];
+            return true;
+        }
+    }
+    if (_overflowIt != _overflow.end()) {
+        depth = _overflowIt->first;
+        numBases = _overflowIt->second;
+        ++_overflowIt;
+        return true;
+    }
+    return false;
+}
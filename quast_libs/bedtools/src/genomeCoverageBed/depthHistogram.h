@@ -0,0 +1,52 @@
+/*****************************************************************************
+depthHistogram.h
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#ifndef DEPTHHISTOGRAM_H
+#define DEPTHHISTOGRAM_H
+
+#include <vector>
+#include <map>
+using namespace std;
+
+
+//************************************************
+// Number of bases seen at each depth.
+//
+// Depths below DENSE_DEPTHS are counted in a plain
+// array (grown on demand up to the highest depth
+// seen), anything else goes to a small overflow map.
+//************************************************
+class DepthHistogram {
+
+public:
+
+    static const int DENSE_DEPTHS = 1 << 16;
+
+    DepthHistogram();
+
+    void Add(int depth, unsigned int numBases);
+    // add all counts of another histogram to this one
+    void Merge(const DepthHistogram &other);
+    void Clear();
+    void Swap(DepthHistogram &other);
+
+    // iterate over the depths with bases, in increasing order of depth.
+    // call BeginBins() first; NextBin() returns false when done.
+    void BeginBins();
+    bool NextBin(int &depth, unsigned int &numBases);
+
+private:
+
+    typedef map<int, unsigned int> overflowMap;
+
+    vector<unsigned int> _dense;
+    overflowMap _overflow;     // negative depths and depths >= DENSE_DEPTHS
+
+    // bin iteration state
+    overflowMap::const_iterator _overflowIt;
+    size_t _denseIdx;
+};
+
+#endif /* DEPTHHISTOGRAM_H */
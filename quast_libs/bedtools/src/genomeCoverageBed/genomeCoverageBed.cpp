@@ -22,7 +22,12 @@ BedGenomeCoverage::BedGenomeCoverage(string bedFile, string genomeFile,
                                      bool only_5p_end, bool only_3p_end,
                                      bool pair_chip, bool haveSize, int fragmentSize, bool dUTP,
                                      bool eachBaseZeroBased,
-                                     bool add_gb_track_line, string gb_track_line_opts) {
+                                     bool add_gb_track_line, string gb_track_line_opts,
+                                     int window, bool windowMinMax,
+                                     const vector<int> &summaryThresholds,
+                                     bool footprint, bool bedpe, bool fragments,
+                                     string tracksFile, bool tracksByReadGroup,
+                                     int numThreads) {
 
     _bedFile = bedFile;
     _genomeFile = genomeFile;
@@ -37,6 +42,7 @@ BedGenomeCoverage::BedGenomeCoverage(string bedFile, string genomeFile,
     _obeySplits = obeySplits;
     _filterByStrand = filterByStrand;
     _requestedStrand = requestedStrand;
+    _wantReverseStrand = (requestedStrand == "-");
     _only_3p_end = only_3p_end;
     _only_5p_end = only_5p_end;
     _pair_chip_ = pair_chip;
@@ -45,6 +51,15 @@ BedGenomeCoverage::BedGenomeCoverage(string bedFile, string genomeFile,
     _dUTP = dUTP;
     _add_gb_track_line = add_gb_track_line;
     _gb_track_line_opts = gb_track_line_opts;
+    _window = window;
+    _windowMinMax = windowMinMax;
+    _summaryThresholds = summaryThresholds;
+    _footprint = footprint;
+    _bedpe = bedpe;
+    _fragments = fragments;
+    _tracksFile = tracksFile;
+    _tracksByReadGroup = tracksByReadGroup;
+    _numThreads = numThreads;
     _currChromName = "";
     _currChromSize = 0 ;
 
@@ -53,7 +68,9 @@ BedGenomeCoverage::BedGenomeCoverage(string bedFile, string genomeFile,
         _genome = new GenomeFile(genomeFile);
     }
 
-    PrintTrackDefinitionLine();
+    // with -tracks, each track file gets its own track line
+    if (_tracksFile.empty())
+        PrintTrackDefinitionLine(cout);
 
     if (_bamInput == false) {
         _bed = new BedFile(bedFile);
@@ -64,7 +81,7 @@ BedGenomeCoverage::BedGenomeCoverage(string bedFile, string genomeFile,
     }
 }
 
-void BedGenomeCoverage::PrintTrackDefinitionLine()
+void BedGenomeCoverage::PrintTrackDefinitionLine(ostream &out) const
 {
     //Print Track Definition line (if requested)
     if ( (_bedGraph||_bedGraphAll) && _add_gb_track_line) {
@@ -73,7 +90,7 @@ void BedGenomeCoverage::PrintTrackDefinitionLine()
             line += " " ;
             line += _gb_track_line_opts ;
         }
-        cout << line << endl;
+        out << line << endl;
     }
 
 }
@@ -88,7 +105,7 @@ BedGenomeCoverage::~BedGenomeCoverage(void) {
 void BedGenomeCoverage::ResetChromCoverage() {
     _currChromName = "";
     _currChromSize = 0 ;
-    std::vector<DEPTH>().swap(_currChromCoverage);
+    _currChromCoverage.Reset(0);
 }
 
 
@@ -96,12 +113,12 @@ void BedGenomeCoverage::StartNewChrom(const string& newChrom) {
     // If we've moved beyond the first encountered chromosomes,
     // process the results of the previous chromosome.
     if (_currChromName.length() > 0) {
-        ReportChromCoverage(_currChromCoverage, _currChromSize,
-                _currChromName, _currChromDepthHist);
+        ReportCurrChromCoverage();
     }
 
-    // empty the previous chromosome and reserve new
-    std::vector<DEPTH>().swap(_currChromCoverage);
+    // empty the previous chromosome
+    _currChromCoverage.Reset(0);
+    _currChromMates.Clear();
 
     if (_visitedChromosomes.find(newChrom) != _visitedChromosomes.end()) {
         cerr << "Input error: Chromosome " << _currChromName
@@ -116,7 +133,7 @@ void BedGenomeCoverage::StartNewChrom(const string& newChrom) {
     _currChromSize = _genome->getChromSize(_currChromName);
 
     if (_currChromSize >= 0)
-        _currChromCoverage.resize(_currChromSize);
+        _currChromCoverage.Reset(_currChromSize);
     else {
         cerr << "Input error: Chromosome " << _currChromName << " found in your input file but not in your genome file." << endl;
         exit(1);
@@ -125,14 +142,8 @@ void BedGenomeCoverage::StartNewChrom(const string& newChrom) {
 
 
 void BedGenomeCoverage::AddCoverage(int start, int end) {
-    // process the first line for this chromosome.
-    // make sure the coordinates fit within the chrom
-    if (start < _currChromSize)
-        _currChromCoverage[start].starts++;
-    if (end >= 0 && end < _currChromSize)
-        _currChromCoverage[end].ends++;
-    else
-        _currChromCoverage[_currChromSize-1].ends++;
+    // coordinates outside of the chrom are clipped by the depth engine
+    _currChromCoverage.AddCoverage(start, end);
 }
 
 
@@ -148,6 +159,42 @@ void BedGenomeCoverage::AddBlockedCoverage(const vector<BED> &bedBlocks) {
 }
 
 
+// same blocks as GetBamBlocks(bam, chrom, blocks, true, _obeySplits) followed
+// by AddBlockedCoverage(), but walks the CIGAR ops straight into the depth
+// array without building a BED (and its strings) for every block.
+void BedGenomeCoverage::AddBamBlockedCoverage(const BamAlignment &bam, DepthDeltas &cov) const {
+    CHRPOS currPosition = bam.Position;
+    int blockLength  = 0;
+
+    vector<CigarOp>::const_iterator cigItr = bam.CigarData.begin();
+    vector<CigarOp>::const_iterator cigEnd = bam.CigarData.end();
+    for (; cigItr != cigEnd; ++cigItr) {
+        switch (cigItr->Type) {
+            case ('M') : case ('X') : case ('='):
+                blockLength += cigItr->Length;
+                break;
+            case ('I') : case ('S') : case ('P') : case ('H') :
+                break;
+            case ('N') :
+                if (!_obeySplits) {
+                    blockLength += cigItr->Length;
+                    break;
+                }
+                // fall through - with -split, "N" ops split blocks just like "D" ops
+            case ('D') :
+                cov.AddCoverage(currPosition, currPosition + blockLength - 1);
+                currPosition += cigItr->Length + blockLength;
+                blockLength = 0;
+                break;
+            default    :
+                fprintf(stderr,"ERROR: Invalid Cigar op type \'%c\'.\n",cigItr->Type);   // shouldn't get here
+                exit(1);
+        }
+    }
+    cov.AddCoverage(currPosition, currPosition + blockLength - 1);
+}
+
+
 void BedGenomeCoverage::CoverageBed() {
 
     BED a;
@@ -195,8 +242,7 @@ void BedGenomeCoverage::CoverageBed() {
     _bed->Close();
 
     // process the results of the last chromosome.
-    ReportChromCoverage(_currChromCoverage, _currChromSize,
-            _currChromName, _currChromDepthHist);
+    ReportCurrChromCoverage();
 
     // report all empty chromsomes
     PrintEmptyChromosomes();
@@ -217,27 +263,30 @@ void BedGenomeCoverage::PrintEmptyChromosomes()
         if (_visitedChromosomes.find(chrom) == _visitedChromosomes.end()) {
             _currChromName = chrom;
             _currChromSize = _genome->getChromSize(_currChromName);
-            std::vector<DEPTH>().swap(_currChromCoverage);
-            _currChromCoverage.resize(_currChromSize);
-            for (int i = 0; i < _currChromSize; ++i)
-            {
-                _currChromCoverage[i].starts = 0;
-                _currChromCoverage[i].ends = 0;
-            }
-            ReportChromCoverage(_currChromCoverage, _currChromSize,
-                    _currChromName, _currChromDepthHist);
+            _currChromCoverage.Reset(_currChromSize);
+            ReportCurrChromCoverage();
         }
     }
 }
 
 void BedGenomeCoverage::PrintFinalCoverage()
 {
-    if (_eachBase == false && _bedGraph == false && _bedGraphAll == false) {
-        ReportGenomeCoverage(_currChromDepthHist);
+    if (_eachBase == false && _bedGraph == false && _bedGraphAll == false && _window == 0) {
+        ReportGenomeCoverage();
     }
 }
 
 
+// reports the current chromosome & adds its histogram to the genome-wide one
+void BedGenomeCoverage::ReportCurrChromCoverage()
+{
+    ReportChromCoverage(_currChromCoverage, _currChromSize,
+            _currChromName, _currChromDepthHist, cout);
+    _genomeDepthHist.Merge(_currChromDepthHist);
+    _currChromDepthHist.Clear();
+}
+
+
 void BedGenomeCoverage::CoverageBam(string bamFile) {
 
     ResetChromCoverage();
@@ -248,6 +297,7 @@ void BedGenomeCoverage::CoverageBam(string bamFile) {
         cerr << "Failed to open BAM file " << bamFile << endl;
         exit(1);
     }
+    reader.SetNumThreads(_numThreads);
 
     // get header & reference information
     string header = reader.GetHeaderText();
@@ -255,107 +305,248 @@ void BedGenomeCoverage::CoverageBam(string bamFile) {
 
     // load the BAM header references into a BEDTools "genome file"
     _genome = new GenomeFile(refs);
-    // convert each aligned BAM entry to BED
-    // and compute coverage on B
+
+    // bamtobed-style coverage doesn't need a sorted BAM
+    if (_footprint || _bedpe) {
+        CoverageBamAnyOrder(reader, refs);
+        reader.Close();
+        return;
+    }
+
+    // every alignment goes to its own output tracks
+    if (!_tracksFile.empty()) {
+        CoverageBamTracks(reader, refs);
+        reader.Close();
+        return;
+    }
+
+    // with several threads, a sorted and indexed BAM is split up by chromosome.
+    // (-d output is left to the serial path, it is too big to buffer per chrom.)
+    if (_numThreads > 1 && !_eachBase &&
+        reader.GetHeader().SortOrder == Constants::SAM_HD_SORTORDER_COORDINATE &&
+        reader.LocateIndex())
+    {
+        reader.Close();
+        CoverageBamByChrom(bamFile, refs);
+        return;
+    }
+
+    // compute coverage straight from the core alignment data: only
+    // flags, positions and CIGAR ops are needed, so skip decoding names,
+    // bases, qualities and tags, and track chromosome changes by RefID.
+    int currRefID = -1;
     BamAlignment bam;
-    while (reader.GetNextAlignment(bam)) {
-        // skip if the read is unaligned
-        if (bam.IsMapped() == false)
+    while (reader.GetNextAlignmentCore(bam)) {
+        // skip unaligned reads and reads on the wrong strand
+        if (!IsCoveredAlignment(bam))
             continue;
 
-        bool _isReverseStrand = bam.IsReverseStrand();
+        // are we on a new chromosome?
+        if ( bam.RefID != currRefID ) {
+            StartNewChrom(refs.at(bam.RefID).RefName);
+            currRefID = bam.RefID;
+        }
+        if (_fragments)
+            AddBamFragmentCoverage(bam, _currChromMates, _currChromCoverage);
+        else
+            AddBamCoverage(bam, _currChromCoverage);
+    }
+    // close the BAM
+    reader.Close();
 
-        //changing second mate's strand to opposite
-        if( _dUTP && bam.IsPaired() && bam.IsMateMapped() && bam.IsSecondMate())
-            _isReverseStrand = !bam.IsReverseStrand();
+    // process the results of the last chromosome.
+    ReportCurrChromCoverage();
 
-        // skip if we care about strands and the strand isn't what
-        // the user wanted
-        if ( (_filterByStrand == true) &&
-             ((_requestedStrand == "-") != _isReverseStrand) )
-            continue;
+    // report all empty chromsomes
+    PrintEmptyChromosomes();
+
+    // report the overall coverage if asked.
+    PrintFinalCoverage();
+}
 
-        // extract the chrom, start and end from the BAM alignment
-        string chrom(refs.at(bam.RefID).RefName);
-        CHRPOS start = bam.Position;
-        CHRPOS end = bam.GetEndPosition(false, false) - 1;
 
-        // are we on a new chromosome?
-        if ( chrom != _currChromName )
-            StartNewChrom(chrom);
-        if(_pair_chip_) {
-            // Skip if not a proper pair
-            if (bam.IsPaired() && (!bam.IsProperPair() or !bam.IsMateMapped()) )
+void BedGenomeCoverage::CoverageBamByChrom(const string &bamFile, const RefVector &refs) {
+
+    const int numChroms = refs.size();
+    const int numWorkers = min(_numThreads, max(numChroms, 1));
+
+    // every worker gets its own reader, opened up front so that
+    // errors are reported before any output is written
+    vector<BamReader *> readers;
+    for (int i = 0; i < numWorkers; ++i) {
+        BamReader *reader = new BamReader();
+        if (!reader->Open(bamFile) || !reader->LocateIndex()) {
+            cerr << "Failed to open BAM file " << bamFile << " with its index" << endl;
+            exit(1);
+        }
+        readers.push_back(reader);
+    }
+
+    _chromResults.assign(numChroms, ChromResult());
+    _nextChrom = 0;
+    _numChromsPrinted = 0;
+    _maxChromsAhead = 2 * numWorkers;
+
+    vector<thread> workers;
+    for (int i = 0; i < numWorkers; ++i)
+        workers.push_back(thread(&BedGenomeCoverage::CoverageBamWorker, this, readers[i], cref(refs)));
+
+    // print the chromosomes in header order (i.e. the order in which the serial
+    // path meets them in a sorted BAM). chromosomes without coverage are left
+    // for PrintEmptyChromosomes(), exactly like the serial path does.
+    for (int refId = 0; refId < numChroms; ++refId) {
+        ChromResult &result = _chromResults[refId];
+        {
+            unique_lock<mutex> lock(_chromResultsMutex);
+            while (!result.isDone)
+                _chromResultDone.wait(lock);
+        }
+        if (result.isVisited) {
+            cout << result.output;
+            _visitedChromosomes.insert(refs[refId].RefName);
+            _genomeDepthHist.Merge(result.hist);
+        }
+        string().swap(result.output);
+        result.hist.Clear();
+        {
+            lock_guard<mutex> lock(_chromResultsMutex);
+            ++_numChromsPrinted;
+        }
+        _chromResultDone.notify_all();
+    }
+
+    for (int i = 0; i < numWorkers; ++i) {
+        workers[i].join();
+        readers[i]->Close();
+        delete readers[i];
+    }
+    vector<ChromResult>().swap(_chromResults);
+
+    // report all empty chromsomes
+    PrintEmptyChromosomes();
+
+    // report the overall coverage if asked.
+    PrintFinalCoverage();
+}
+
+
+void BedGenomeCoverage::CoverageBamWorker(BamReader *reader, const RefVector &refs) {
+
+    const int numChroms = refs.size();
+    DepthDeltas chromCov;
+    PendingMates chromMates;
+    BamAlignment bam;
+
+    while (true) {
+        // grab the next chromosome, but don't get too far ahead of the printer
+        int refId;
+        {
+            unique_lock<mutex> lock(_chromResultsMutex);
+            while (_nextChrom < numChroms && _nextChrom >= _numChromsPrinted + _maxChromsAhead)
+                _chromResultDone.wait(lock);
+            if (_nextChrom >= numChroms)
+                return;
+            refId = _nextChrom++;
+        }
+
+        ChromResult &result = _chromResults[refId];
+        const string &chrom = refs[refId].RefName;
+        const int chromSize = refs[refId].RefLength;
+
+        // jump to the first alignment on this chromosome & stop at the next one
+        if (!reader->SetRegion(BamRegion(refId, 0))) {
+            cerr << "Failed to jump to chromosome " << chrom << " in BAM index" << endl;
+            exit(1);
+        }
+        chromCov.Reset(chromSize);
+        while (reader->GetNextAlignmentCore(bam) && bam.RefID == refId) {
+            if (!IsCoveredAlignment(bam))
                 continue;
-            // Skip if wrong coordinates
-            if( ( (bam.Position<bam.MatePosition) && bam.IsReverseStrand() ) ||
-                ( (bam.MatePosition < bam.Position) && bam.IsMateReverseStrand() ) ) {
-                    //chemically designed: left on positive strand, right on reverse one
-                    continue;
-            }
+            result.isVisited = true;
+            if (_fragments)
+                AddBamFragmentCoverage(bam, chromMates, chromCov);
+            else
+                AddBamCoverage(bam, chromCov);
+        }
+        chromMates.Clear();
 
-            /*if(_haveSize) {
-                if (bam.IsFirstMate() && bam.IsReverseStrand()) { //put fragmentSize in to the middle of pair end_fragment
-                    int mid = bam.MatePosition+abs(bam.InsertSize)/2;
-                    if(mid<_fragmentSize/2)
-                        AddCoverage(0, mid+_fragmentSize/2);
-                    else
-                        AddCoverage(mid-_fragmentSize/2, mid+_fragmentSize/2);
-                }
-                else if (bam.IsFirstMate() && bam.IsMateReverseStrand()) { //put fragmentSize in to the middle of pair end_fragment
-                    int mid = start+abs(bam.InsertSize)/2;
-                    if(mid<_fragmentSize/2)
-                        AddCoverage(0, mid+_fragmentSize/2);
-                    else
-                        AddCoverage(mid-_fragmentSize/2, mid+_fragmentSize/2);
-                }
-            } else */
+        if (result.isVisited) {
+            ostringstream out;
+            ReportChromCoverage(chromCov, chromSize, chrom, result.hist, out);
+            result.output = out.str();
+        }
+        chromCov.Reset(0);
 
-            if (bam.IsFirstMate() && bam.IsReverseStrand()) { //prolong to the mate to the left
-                AddCoverage(bam.MatePosition, end);
-            }
-            else if (bam.IsFirstMate() && bam.IsMateReverseStrand()) { //prolong to the mate to the right
-                AddCoverage(start, start + abs(bam.InsertSize) - 1);
-            }
-        } else if (_haveSize) {
-            if(bam.IsReverseStrand()) {
-                if(end<_fragmentSize) { //sometimes fragmentSize is bigger :(
-                    AddCoverage(0, end);
-                } else {
-                    AddCoverage(end + 1 - _fragmentSize, end );
-                }
-            } else {
-                AddCoverage(start,start+_fragmentSize - 1);
-            }
-        } else
-        // add coverage accordingly.
-        if (!_only_5p_end && !_only_3p_end) {
-            bedVector bedBlocks;
-            // we always want to split blocks when a D CIGAR op is found.
-            // if the user invokes -split, we want to also split on N ops.
-            if (_obeySplits) { // "D" true, "N" true
-                GetBamBlocks(bam, refs.at(bam.RefID).RefName, bedBlocks, true, true);
-            }
-            else { // "D" true, "N" false
-                GetBamBlocks(bam, refs.at(bam.RefID).RefName, bedBlocks, true, false);
-            }
-            AddBlockedCoverage(bedBlocks);
+        {
+            lock_guard<mutex> lock(_chromResultsMutex);
+            result.isDone = true;
         }
-        else if (_only_5p_end) {
-            int pos = ( !bam.IsReverseStrand() ) ? start : end;
-            AddCoverage(pos,pos);
+        _chromResultDone.notify_all();
+    }
+}
+
+
+// coverage of the intervals "bamtobed" (-footprint) or "bamtobed -bedpe" (-bedpe)
+// would report, which then went through "sort" and "genomecov -i". the BAM may
+// be in any order (a -bedpe BAM is grouped by name), so the depth of every
+// chromosome is kept until the whole BAM has been read, and chromosomes are
+// reported in header order.
+void BedGenomeCoverage::CoverageBamAnyOrder(BamReader &reader, const RefVector &refs) {
+
+    const int numChroms = refs.size();
+    vector<DepthDeltas> chromCovs(numChroms);
+    vector<bool> isVisited(numChroms, false);
+
+    BamAlignment bam1, bam2;
+    if (_bedpe) {
+        while (NextBamPair(reader, bam1, bam2)) {
+            // a pair with an unmapped end has no fragment to cover
+            if (!bam1.IsMapped() || !bam2.IsMapped())
+                continue;
+
+            // the leftmost end comes first, exactly like bamtobed -bedpe orders them
+            const string &chrom1 = refs.at(bam1.RefID).RefName;
+            const string &chrom2 = refs.at(bam2.RefID).RefName;
+            const BamAlignment *first = &bam1, *second = &bam2;
+            if (chrom1 > chrom2 || (chrom1 == chrom2 && bam1.Position > bam2.Position))
+                swap(first, second);
+
+            // the fragment: start of the first end to the end of the second one
+            int start = first->Position;
+            int end = second->GetEndPosition(false);
+            if (end <= start)
+                continue;
+            const int refId = first->RefID;
+            if (!isVisited[refId]) {
+                chromCovs[refId].Reset(refs[refId].RefLength);
+                isVisited[refId] = true;
+            }
+            chromCovs[refId].AddCoverage(start, end - 1);
         }
-        else if (_only_3p_end) {
-            int pos = ( bam.IsReverseStrand() ) ? start : end;
-            AddCoverage(pos,pos);
+    }
+    else {
+        while (reader.GetNextAlignmentCore(bam1)) {
+            if (!IsCoveredAlignment(bam1))
+                continue;
+            const int refId = bam1.RefID;
+            if (!isVisited[refId]) {
+                chromCovs[refId].Reset(refs[refId].RefLength);
+                isVisited[refId] = true;
+            }
+            // the whole footprint of the read, deletions and skipped regions included
+            chromCovs[refId].AddCoverage(bam1.Position, bam1.GetEndPosition(false, false) - 1);
         }
     }
-    // close the BAM
-    reader.Close();
 
-    // process the results of the last chromosome.
-    ReportChromCoverage(_currChromCoverage, _currChromSize,
-            _currChromName, _currChromDepthHist);
+    for (int refId = 0; refId < numChroms; ++refId) {
+        if (!isVisited[refId])
+            continue;
+        ReportChromCoverage(chromCovs[refId], refs[refId].RefLength, refs[refId].RefName, _currChromDepthHist, cout);
+        _genomeDepthHist.Merge(_currChromDepthHist);
+        _currChromDepthHist.Clear();
+        _visitedChromosomes.insert(refs[refId].RefName);
+        chromCovs[refId].Reset(0);
+    }
 
     // report all empty chromsomes
     PrintEmptyChromosomes();
@@ -365,49 +556,294 @@ void BedGenomeCoverage::CoverageBam(string bamFile) {
 }
 
 
-void BedGenomeCoverage::ReportChromCoverage(const vector<DEPTH> &chromCov, const int &chromSize, const string &chrom, chromHistMap &chromDepthHist) {
+// -tracks: the coverage of several outputs in one pass over a position-sorted BAM.
+// each track is reported just like genomecov would report the BAM of its own
+// alignments, with the references of the track as the genome.
+void BedGenomeCoverage::CoverageBamTracks(BamReader &reader, const RefVector &refs) {
+
+    CoverageTracks tracks(_tracksFile, _tracksByReadGroup, refs);
+    const int numTracks = tracks.Size();
+    const int numChroms = refs.size();
+    vector<TrackCoverage> trackCovs(numTracks);
+    for (int track = 0; track < numTracks; ++track) {
+        trackCovs[track].isVisitedChrom.assign(numChroms, false);
+        PrintTrackDefinitionLine(tracks.Output(track));
+    }
+
+    vector<bool> isChromDone(numChroms, false);
+    int currRefID = -1;
+    string readGroup;
+    BamAlignment bam;
+    while (reader.GetNextAlignmentCore(bam)) {
+        if (!IsCoveredAlignment(bam))
+            continue;
+
+        // are we on a new chromosome?
+        if (bam.RefID != currRefID) {
+            if (currRefID >= 0)
+                ReportTracksChrom(tracks, trackCovs, refs, currRefID);
+            if (isChromDone[bam.RefID]) {
+                cerr << "Input error: Chromosome " << refs[bam.RefID].RefName
+                     << " found in non-sequential lines. This suggests that the input file is not sorted correctly." << endl;
+            }
+            currRefID = bam.RefID;
+            isChromDone[currRefID] = true;
+        }
+
+        // only the read groups need the tags decoded
+        const vector<int> *alignmentTracks = &tracks.RefTracks(currRefID);
+        if (tracks.ByReadGroup()) {
+            bam.BuildCharData();
+            if (!bam.GetTag("RG", readGroup))
+                continue;
+            alignmentTracks = &tracks.ReadGroupTracks(readGroup);
+        }
+        for (size_t i = 0; i < alignmentTracks->size(); ++i) {
+            TrackCoverage &trackCov = trackCovs[(*alignmentTracks)[i]];
+            if (!trackCov.isVisited) {
+                trackCov.cov.Reset(refs[currRefID].RefLength);
+                trackCov.isVisited = true;
+                trackCov.isVisitedChrom[currRefID] = true;
+            }
+            if (_fragments)
+                AddBamFragmentCoverage(bam, trackCov.mates, trackCov.cov);
+            else
+                AddBamCoverage(bam, trackCov.cov);
+        }
+    }
+    if (currRefID >= 0)
+        ReportTracksChrom(tracks, trackCovs, refs, currRefID);
+
+    // report the empty chromosomes and the overall coverage of each track
+    const bool reportGenome = (_eachBase == false && _bedGraph == false && _bedGraphAll == false && _window == 0);
+    for (int track = 0; track < numTracks; ++track) {
+        TrackCoverage &trackCov = trackCovs[track];
+        ostream &out = tracks.Output(track);
+        unsigned int genomeSize = 0;
+        for (int refId = 0; refId < numChroms; ++refId) {
+            if (!tracks.HasRef(track, refId))
+                continue;
+            genomeSize += refs[refId].RefLength;
+            if (trackCov.isVisitedChrom[refId])
+                continue;
+            trackCov.cov.Reset(refs[refId].RefLength);
+            ReportChromCoverage(trackCov.cov, refs[refId].RefLength, refs[refId].RefName, trackCov.chromHist, out);
+            trackCov.genomeHist.Merge(trackCov.chromHist);
+            trackCov.chromHist.Clear();
+        }
+        trackCov.cov.Reset(0);
+        if (reportGenome)
+            ReportGenomeCoverage(genomeSize, trackCov.genomeHist, out);
+    }
+}
+
+
+// reports the tracks with alignments on this chromosome and readies them for the next one
+void BedGenomeCoverage::ReportTracksChrom(CoverageTracks &tracks, vector<TrackCoverage> &trackCovs,
+                                          const RefVector &refs, int refId) const {
+    for (int track = 0; track < tracks.Size(); ++track) {
+        TrackCoverage &trackCov = trackCovs[track];
+        if (!trackCov.isVisited)
+            continue;
+        ReportChromCoverage(trackCov.cov, refs[refId].RefLength, refs[refId].RefName,
+                            trackCov.chromHist, tracks.Output(track));
+        trackCov.genomeHist.Merge(trackCov.chromHist);
+        trackCov.chromHist.Clear();
+        trackCov.cov.Reset(0);
+        trackCov.mates.Clear();
+        trackCov.isVisited = false;
+    }
+}
+
+
+// the next two alignments with the same name, paired up the way
+// ConvertBamToBedpe does it: reads whose mate isn't next to them are skipped.
+// only the read names are decoded, coverage needs nothing else of the char data.
+bool BedGenomeCoverage::NextBamPair(BamReader &reader, BamAlignment &bam1, BamAlignment &bam2) const {
+    while (reader.GetNextAlignmentCore(bam1)) {
+        bam1.BuildName();
+        if (!reader.GetNextAlignmentCore(bam2))
+            return false;
+        bam2.BuildName();
+        if (bam1.Name != bam2.Name) {
+            while (bam1.Name != bam2.Name) {
+                if (bam1.IsPaired()) {
+                    cerr << "*****WARNING: Query " << bam1.Name
+                         << " is marked as paired, but its mate does not occur"
+                         << " next to it in your BAM file.  Skipping. " << endl;
+                }
+                bam1 = bam2;
+                if (!reader.GetNextAlignmentCore(bam2))
+                    return false;
+                bam2.BuildName();
+            }
+            return true;
+        }
+        else if (bam1.IsPaired() && bam2.IsPaired()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+// -fragments: the fragment of each pair in a coordinate-sorted BAM, from the start
+// of the leftmost mate to the end of the other one, i.e. what -bedpe counts on the
+// same BAM sorted by name. the fragment is added once its second mate shows up.
+// pairs split across chromosomes, secondary and supplementary alignments are skipped.
+void BedGenomeCoverage::AddBamFragmentCoverage(const BamAlignment &bam, PendingMates &mates, DepthDeltas &cov) const {
+    if (!bam.IsPaired() || !bam.IsMateMapped() || bam.RefID != bam.MateRefID ||
+        !bam.IsPrimaryAlignment() || (bam.AlignmentFlag & 0x800))
+        return;
+
+    // only the core data has been read: the name leads the char data
+    const string name = bam.SupportData.HasCoreOnly ? string(bam.SupportData.AllCharData.c_str()) : bam.Name;
+    int fragStart, fragEnd;
+    if (mates.AddMate(name, bam.Position, bam.GetEndPosition(false), bam.MatePosition, bam.IsFirstMate(),
+                      fragStart, fragEnd) && fragEnd > fragStart)
+        cov.AddCoverage(fragStart, fragEnd - 1);
+}
+
+
+// true if the alignment contributes to coverage at all:
+// it has to be aligned, and on the requested strand (if any).
+bool BedGenomeCoverage::IsCoveredAlignment(const BamAlignment &bam) const {
+    // skip if the read is unaligned
+    if (bam.IsMapped() == false)
+        return false;
+
+    bool _isReverseStrand = bam.IsReverseStrand();
+
+    //changing second mate's strand to opposite
+    if( _dUTP && bam.IsPaired() && bam.IsMateMapped() && bam.IsSecondMate())
+        _isReverseStrand = !bam.IsReverseStrand();
+
+    // skip if we care about strands and the strand isn't what
+    // the user wanted
+    if ( (_filterByStrand == true) &&
+         (_wantReverseStrand != _isReverseStrand) )
+        return false;
+
+    return true;
+}
+
+
+void BedGenomeCoverage::AddBamCoverage(const BamAlignment &bam, DepthDeltas &cov) const {
+
+    // extract the start and end from the BAM alignment
+    CHRPOS start = bam.Position;
+    CHRPOS end = bam.GetEndPosition(false, false) - 1;
+
+    if(_pair_chip_) {
+        // Skip if not a proper pair
+        if (bam.IsPaired() && (!bam.IsProperPair() or !bam.IsMateMapped()) )
+            return;
+        // Skip if wrong coordinates
+        if( ( (bam.Position<bam.MatePosition) && bam.IsReverseStrand() ) ||
+            ( (bam.MatePosition < bam.Position) && bam.IsMateReverseStrand() ) ) {
+                //chemically designed: left on positive strand, right on reverse one
+                return;
+        }
+
+        /*if(_haveSize) {
+            if (bam.IsFirstMate() && bam.IsReverseStrand()) { //put fragmentSize in to the middle of pair end_fragment
+                int mid = bam.MatePosition+abs(bam.InsertSize)/2;
+                if(mid<_fragmentSize/2)
+                    AddCoverage(0, mid+_fragmentSize/2);
+                else
+                    AddCoverage(mid-_fragmentSize/2, mid+_fragmentSize/2);
+            }
+            else if (bam.IsFirstMate() && bam.IsMateReverseStrand()) { //put fragmentSize in to the middle of pair end_fragment
+                int mid = start+abs(bam.InsertSize)/2;
+                if(mid<_fragmentSize/2)
+                    AddCoverage(0, mid+_fragmentSize/2);
+                else
+                    AddCoverage(mid-_fragmentSize/2, mid+_fragmentSize/2);
+            }
+        } else */
+
+        if (bam.IsFirstMate() && bam.IsReverseStrand()) { //prolong to the mate to the left
+            cov.AddCoverage(bam.MatePosition, end);
+        }
+        else if (bam.IsFirstMate() && bam.IsMateReverseStrand()) { //prolong to the mate to the right
+            cov.AddCoverage(start, start + abs(bam.InsertSize) - 1);
+        }
+    } else if (_haveSize) {
+        if(bam.IsReverseStrand()) {
+            if(end<_fragmentSize) { //sometimes fragmentSize is bigger :(
+                cov.AddCoverage(0, end);
+            } else {
+                cov.AddCoverage(end + 1 - _fragmentSize, end );
+            }
+        } else {
+            cov.AddCoverage(start,start+_fragmentSize - 1);
+        }
+    } else
+    // add coverage accordingly.
+    if (!_only_5p_end && !_only_3p_end) {
+        // we always want to split blocks when a D CIGAR op is found.
+        // if the user invokes -split, we want to also split on N ops.
+        AddBamBlockedCoverage(bam, cov);
+    }
+    else if (_only_5p_end) {
+        int pos = ( !bam.IsReverseStrand() ) ? start : end;
+        cov.AddCoverage(pos,pos);
+    }
+    else if (_only_3p_end) {
+        int pos = ( bam.IsReverseStrand() ) ? start : end;
+        cov.AddCoverage(pos,pos);
+    }
+}
+
+
+void BedGenomeCoverage::ReportChromCoverage(DepthDeltas &chromCov, const int &chromSize, const string &chrom,
+                                            DepthHistogram &chromHist, ostream &out) const {
+
+    int start, end, depth;
 
     if (_eachBase) {
-        int depth = 0; // initialize the depth
         int offset = (_eachBaseZeroBased)?0:1;
-        for (int pos = 0; pos < chromSize; pos++) {
-
-            depth += chromCov[pos].starts;
-            // report the depth for this position.
-            if (depth>0 || !_eachBaseZeroBased)
-                cout << chrom << "\t" << pos+offset << "\t" << depth * _scale << endl;
-            depth = depth - chromCov[pos].ends;
+        chromCov.BeginRuns();
+        while (chromCov.NextRun(start, end, depth)) {
+            // -dz skips uncovered runs altogether
+            if (depth <= 0 && _eachBaseZeroBased)
+                continue;
+            // report the depth for each position of the run.
+            for (int pos = start; pos < end; pos++)
+                out << chrom << "\t" << pos+offset << "\t" << depth * _scale << endl;
         }
     }
     else if (_bedGraph == true || _bedGraphAll == true) {
-        ReportChromCoverageBedGraph(chromCov, chromSize, chrom);
+        ReportChromCoverageBedGraph(chromCov, chromSize, chrom, out);
+    }
+    else if (_window > 0) {
+        ReportChromCoverageWindows(chromCov, chromSize, chrom, out);
     }
     else {
 
-        int depth = 0; // initialize the depth
-
-        for (int pos = 0; pos < chromSize; pos++) {
-
-            depth += chromCov[pos].starts;
+        chromCov.BeginRuns();
+        while (chromCov.NextRun(start, end, depth)) {
 
-            // add the depth at this position to the depth histogram
+            // add the bases of this run to the depth histogram
             // for this chromosome. if the depth is greater than the
             // maximum bin requested, then readjust the depth to be the max
             if (depth >= _max) {
-                chromDepthHist[chrom][_max]++;
+                chromHist.Add(_max, end - start);
             }
             else {
-                chromDepthHist[chrom][depth]++;
+                chromHist.Add(depth, end - start);
             }
-            depth = depth - chromCov[pos].ends;
+        }
+        // or just its summary, if that is all that was asked for
+        if (!_summaryThresholds.empty()) {
+            ReportDepthSummary(chrom, chromSize, chromHist, out);
+            return;
         }
         // report the histogram for each chromosome
-        histMap::const_iterator depthIt = chromDepthHist[chrom].begin();
-        histMap::const_iterator depthEnd = chromDepthHist[chrom].end();
-        for (; depthIt != depthEnd; ++depthIt) {
-            int depth = depthIt->first;
-            unsigned int numBasesAtDepth = depthIt->second;
-            cout << chrom << "\t" << depth << "\t" << numBasesAtDepth << "\t"
+        unsigned int numBasesAtDepth;
+        chromHist.BeginBins();
+        while (chromHist.NextBin(depth, numBasesAtDepth)) {
+            out << chrom << "\t" << depth << "\t" << numBasesAtDepth << "\t"
                 << chromSize << "\t" << (float) ((float)numBasesAtDepth / (float)chromSize) << endl;
         }
     }
@@ -415,78 +851,130 @@ void BedGenomeCoverage::ReportChromCoverage(const vector<DEPTH> &chromCov, const
 
 
 
-void BedGenomeCoverage::ReportGenomeCoverage(chromHistMap &chromDepthHist) {
+void BedGenomeCoverage::ReportGenomeCoverage() {
 
     // get the list of chromosome names in the genome
     vector<string> chromList = _genome->getChromList();
 
+    // every chromosome has been reported by now (empty ones by
+    // PrintEmptyChromosomes), and each report has been added to
+    // the genome-wide histogram as it went, so just total up the size.
     unsigned int genomeSize = 0;
     vector<string>::const_iterator chromItr = chromList.begin();
     vector<string>::const_iterator chromEnd = chromList.end();
     for (; chromItr != chromEnd; ++chromItr) {
-        string chrom = *chromItr;
-        genomeSize += _genome->getChromSize(chrom);
-        // if there were no reads for a give chromosome, then
-        // add the length of the chrom to the 0 bin.
-        if ( chromDepthHist.find(chrom) == chromDepthHist.end() ) {
-            chromDepthHist[chrom][0] += _genome->getChromSize(chrom);
-        }
+        genomeSize += _genome->getChromSize(*chromItr);
     }
+    ReportGenomeCoverage(genomeSize, _genomeDepthHist, cout);
+}
 
-    histMap genomeHist; // depth histogram for the entire genome
 
-    // loop through each chromosome and add the depth and number of bases at each depth
-    // to the aggregate histogram for the entire genome
-    for (chromHistMap::iterator chromIt = chromDepthHist.begin(); chromIt != chromDepthHist.end(); ++chromIt) {
-        string chrom = chromIt->first;
-        for (histMap::iterator depthIt = chromDepthHist[chrom].begin(); depthIt != chromDepthHist[chrom].end(); ++depthIt) {
-            int depth = depthIt->first;
-            unsigned int numBasesAtDepth = depthIt->second;
-            genomeHist[depth] += numBasesAtDepth;
-        }
+void BedGenomeCoverage::ReportGenomeCoverage(unsigned int genomeSize, DepthHistogram &hist, ostream &out) const {
+
+    if (!_summaryThresholds.empty()) {
+        ReportDepthSummary("genome", genomeSize, hist, out);
+        return;
     }
 
     // loop through the depths for the entire genome
     // and report the number and fraction of bases in
     // the entire genome that are at said depth.
-    for (histMap::iterator genomeDepthIt = genomeHist.begin(); genomeDepthIt != genomeHist.end(); ++genomeDepthIt) {
-        int depth = genomeDepthIt->first;
-        unsigned int numBasesAtDepth = genomeDepthIt->second;
+    int depth;
+    unsigned int numBasesAtDepth;
+    hist.BeginBins();
+    while (hist.NextBin(depth, numBasesAtDepth)) {
 
-        cout << "genome" << "\t" << depth << "\t" << numBasesAtDepth << "\t"
+        out << "genome" << "\t" << depth << "\t" << numBasesAtDepth << "\t"
             << genomeSize << "\t" << (float) ((float)numBasesAtDepth / (float)genomeSize) << endl;
     }
 }
 
 
-void BedGenomeCoverage::ReportChromCoverageBedGraph(const vector<DEPTH> &chromCov, const int &chromSize, const string &chrom) {
+// one line instead of the histogram: the mean depth, then the fraction
+// of bases at or above each of the summary thresholds, in the order given.
+void BedGenomeCoverage::ReportDepthSummary(const string &name, unsigned int size, DepthHistogram &hist,
+                                           ostream &out) const {
 
-    int depth = 0; // initialize the depth
-    int lastStart = -1;
-    int lastDepth = -1;
+    const size_t numThresholds = _summaryThresholds.size();
+    vector<unsigned long> numBasesAbove(numThresholds, 0);
+    double depthSum = 0;
 
-    for (int pos = 0; pos < chromSize; pos++) {
-        depth += chromCov[pos].starts;
+    int depth;
+    unsigned int numBasesAtDepth;
+    hist.BeginBins();
+    while (hist.NextBin(depth, numBasesAtDepth)) {
+        depthSum += (double)depth * numBasesAtDepth;
+        for (size_t i = 0; i < numThresholds; ++i) {
+            if (depth >= _summaryThresholds[i])
+                numBasesAbove[i] += numBasesAtDepth;
+        }
+    }
 
-        if (depth != lastDepth) {
-            // Coverage depth has changed, print the last interval coverage (if any)
-            // Print if:
-            // (1) depth>0 (the default running mode),
-            // (2) depth==0 and the user requested to print zero covered regions (_bedGraphAll)
-            if ( (lastDepth != -1) && (lastDepth > 0 || _bedGraphAll) ) {
-                cout << chrom << "\t" << lastStart << "\t" << pos << "\t" << lastDepth * _scale << endl;
+    char valueString[64];
+    snprintf(valueString, sizeof(valueString), "%0.7f", size > 0 ? depthSum / size : 0.0);
+    out << name << "\t" << size << "\t" << valueString;
+    for (size_t i = 0; i < numThresholds; ++i) {
+        snprintf(valueString, sizeof(valueString), "%0.7f", size > 0 ? (double)numBasesAbove[i] / size : 0.0);
+        out << "\t" << valueString;
+    }
+    out << endl;
+}
+
+
+void BedGenomeCoverage::ReportChromCoverageBedGraph(DepthDeltas &chromCov, const int &chromSize, const string &chrom,
+                                                    ostream &out) const {
+
+    int start, end, depth;
+
+    // each run is a maximal interval of constant depth, straight from the prefix sum.
+    // Print if:
+    // (1) depth>0 (the default running mode),
+    // (2) depth==0 and the user requested to print zero covered regions (_bedGraphAll)
+    chromCov.BeginRuns();
+    while (chromCov.NextRun(start, end, depth)) {
+        if (depth > 0 || _bedGraphAll) {
+            out << chrom << "\t" << start << "\t" << end << "\t" << depth * _scale << endl;
+        }
+    }
+}
+
+
+void BedGenomeCoverage::ReportChromCoverageWindows(DepthDeltas &chromCov, const int &chromSize, const string &chrom,
+                                                   ostream &out) const {
+
+    int start, end, depth;
+    int winStart = 0;
+    int winEnd = min(_window, chromSize);
+    double winSum = 0;
+    int winMin = INT_MAX;
+    int winMax = INT_MIN;
+    char meanString[64];
+
+    // the runs tile the whole chromosome, so every window (the last one may be
+    // shorter) is printed as soon as the runs reach its end. a long run just
+    // spans several windows.
+    chromCov.BeginRuns();
+    while (chromCov.NextRun(start, end, depth)) {
+        while (start < end) {
+            int runEnd = min(end, winEnd);
+            winSum += (double)depth * (runEnd - start);
+            winMin = min(winMin, depth);
+            winMax = max(winMax, depth);
+            start = runEnd;
+
+            if (start == winEnd) {
+                snprintf(meanString, sizeof(meanString), "%0.7f", winSum / (winEnd - winStart) * _scale);
+                out << chrom << "\t" << winStart << "\t" << winEnd << "\t" << meanString;
+                if (_windowMinMax)
+                    out << "\t" << winMin * _scale << "\t" << winMax * _scale;
+                out << endl;
+
+                winStart = winEnd;
+                winEnd = min(winEnd + _window, chromSize);
+                winSum = 0;
+                winMin = INT_MAX;
+                winMax = INT_MIN;
             }
-            //Set current position as the new interval start + depth
-            lastDepth = depth;
-            lastStart = pos;
-        }
-        // Default: the depth has not changed, so we will not print anything.
-        // Proceed until the depth changes.
-        // Update depth
-        depth = depth - chromCov[pos].ends;
-    }
-    //Print information about the last position
-    if ( (lastDepth != -1) && (lastDepth > 0 || _bedGraphAll) ) {
-        cout << chrom << "\t" << lastStart << "\t" << chromSize << "\t" << lastDepth * _scale << endl;
+        }
     }
 }
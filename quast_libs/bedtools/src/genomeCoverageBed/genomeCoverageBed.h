@@ -13,14 +13,23 @@ Licenced under the GNU General Public License 2.0 license.
 #include "GenomeFile.h"
 
 #include "BlockedIntervals.h"
+#include "depthDeltas.h"
+#include "depthHistogram.h"
+#include "pendingMates.h"
+#include "coverageTracks.h"
 #include "api/BamReader.h"
 #include "api/BamAux.h"
+#include "api/SamConstants.h"
 using namespace BamTools;
 
 #include <vector>
 #include <set>
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 using namespace std;
 
 
@@ -30,9 +39,6 @@ using namespace std;
 typedef map<int, DEPTH, less<int> > depthMap;
 typedef map<string, depthMap, less<string> > chromDepthMap;
 
-typedef map<int, unsigned int, less<int> > histMap;
-typedef map<string, histMap, less<string> > chromHistMap;
-
 //************************************************
 // Class methods and elements
 //************************************************
@@ -50,7 +56,12 @@ public:
                       bool only_5p_end, bool only_3p_end,
                       bool pair_chip,bool haveSize, int fragmentSize, bool dUTP,
                       bool eachBaseZeroBased,
-                      bool add_gb_track_line, string gb_track_line_opts);
+                      bool add_gb_track_line, string gb_track_line_opts,
+                      int window, bool windowMinMax,
+                      const vector<int> &summaryThresholds,
+                      bool footprint, bool bedpe, bool fragments,
+                      string tracksFile, bool tracksByReadGroup,
+                      int numThreads);
 
     // destructor
     ~BedGenomeCoverage(void);
@@ -78,7 +89,17 @@ private:
     int _fragmentSize;
     bool _add_gb_track_line;
     string _gb_track_line_opts;
+    int _window;
+    bool _windowMinMax;
+    vector<int> _summaryThresholds;
+    bool _footprint;
+    bool _bedpe;
+    bool _fragments;
+    string _tracksFile;
+    bool _tracksByReadGroup;
     string _requestedStrand;
+    bool _wantReverseStrand;
+    int _numThreads;
 
     BedFile *_bed;
     GenomeFile *_genome;
@@ -86,24 +107,70 @@ private:
     // data for internal processing
     chromDepthMap _chromCov;
     string _currChromName ;
-    vector<DEPTH> _currChromCoverage;
-    chromHistMap _currChromDepthHist;
+    DepthDeltas _currChromCoverage;
+    PendingMates _currChromMates;
+    DepthHistogram _currChromDepthHist;
+    DepthHistogram _genomeDepthHist;
     int _currChromSize ;
     set<string> _visitedChromosomes;
 
+    // per-chromosome results of the parallel BAM path, in header order
+    struct ChromResult {
+        bool isDone;
+        bool isVisited;
+        string output;
+        DepthHistogram hist;
+        ChromResult() : isDone(false), isVisited(false) {}
+    };
+    vector<ChromResult> _chromResults;
+    int _nextChrom;
+    int _numChromsPrinted;
+    int _maxChromsAhead;
+    mutex _chromResultsMutex;
+    condition_variable _chromResultDone;
+
+    // coverage of one -tracks output on the current chromosome
+    struct TrackCoverage {
+        DepthDeltas cov;
+        PendingMates mates;
+        DepthHistogram chromHist;
+        DepthHistogram genomeHist;
+        bool isVisited;                 // has alignments on the current chromosome
+        vector<bool> isVisitedChrom;    // by RefID
+        TrackCoverage() : isVisited(false) {}
+    };
+
 
     // methods
     void CoverageBed();
     void CoverageBam(string bamFile);
+    void CoverageBamByChrom(const string &bamFile, const RefVector &refs);
+    void CoverageBamWorker(BamReader *reader, const RefVector &refs);
+    void CoverageBamAnyOrder(BamReader &reader, const RefVector &refs);
+    void CoverageBamTracks(BamReader &reader, const RefVector &refs);
+    void ReportTracksChrom(CoverageTracks &tracks, vector<TrackCoverage> &trackCovs,
+                           const RefVector &refs, int refId) const;
+    bool NextBamPair(BamReader &reader, BamAlignment &bam1, BamAlignment &bam2) const;
     void LoadBamHeaderIntoGenomeFile(const string &bamFile);
-    void ReportChromCoverage(const vector<DEPTH> &, const int &chromSize, const string &chrom, chromHistMap&);
-    void ReportGenomeCoverage(chromHistMap &chromDepthHist);
-    void ReportChromCoverageBedGraph(const vector<DEPTH> &chromCov, const int &chromSize, const string &chrom);
+    void ReportChromCoverage(DepthDeltas &chromCov, const int &chromSize, const string &chrom,
+                             DepthHistogram &chromHist, ostream &out) const;
+    void ReportCurrChromCoverage();
+    void ReportGenomeCoverage();
+    void ReportGenomeCoverage(unsigned int genomeSize, DepthHistogram &hist, ostream &out) const;
+    void ReportDepthSummary(const string &name, unsigned int size, DepthHistogram &hist, ostream &out) const;
+    void ReportChromCoverageBedGraph(DepthDeltas &chromCov, const int &chromSize, const string &chrom,
+                                     ostream &out) const;
+    void ReportChromCoverageWindows(DepthDeltas &chromCov, const int &chromSize, const string &chrom,
+                                    ostream &out) const;
     void ResetChromCoverage();
     void StartNewChrom (const string& chrom);
     void AddCoverage (int start, int end);
     void AddBlockedCoverage(const vector<BED> &bedBlocks);
+    bool IsCoveredAlignment(const BamAlignment &bam) const;
+    void AddBamCoverage(const BamAlignment &bam, DepthDeltas &cov) const;
+    void AddBamBlockedCoverage(const BamAlignment &bam, DepthDeltas &cov) const;
+    void AddBamFragmentCoverage(const BamAlignment &bam, PendingMates &mates, DepthDeltas &cov) const;
     void PrintFinalCoverage();
     void PrintEmptyChromosomes();
-    void PrintTrackDefinitionLine();
+    void PrintTrackDefinitionLine(ostream &out) const;
 };
@@ -9,6 +9,7 @@ aaronquinlan@gmail.com
 
 Licenced under the GNU General Public License 2.0 license.
 ******************************************************************************/
+#include "lineFileUtilities.h"
 #include "genomeCoverageBed.h"
 #include "version.h"
 
@@ -33,6 +34,8 @@ int genomecoverage_main(int argc, char* argv[]) {
     string bedFile;
     string genomeFile;
     int max = INT_MAX;
+    int numThreads = 1;
+    int window = 0;
     float scale = 1.0;
     float fragmentSize = 146; //Nucleosome :)
 
@@ -53,6 +56,14 @@ int genomecoverage_main(int argc, char* argv[]) {
     bool only_5p_end = false;
     bool only_3p_end = false;
     bool add_gb_track_line = false;
+    bool windowMinMax = false;
+    bool haveSummary = false;
+    bool footprint = false;
+    bool bedpe = false;
+    bool fragments = false;
+    bool tracksByReadGroup = false;
+    vector<int> summaryThresholds;
+    string tracksFile;
     string gb_track_opts;
     string requestedStrand = "X";
 
@@ -160,6 +171,62 @@ int genomecoverage_main(int argc, char* argv[]) {
         else if(PARAMETER_CHECK("-du", 3, parameterLength)) {
             dUTP = true;
         }
+        else if(PARAMETER_CHECK("-window", 7, parameterLength)) {
+            if ((i+1) < argc) {
+                window = atoi(argv[i + 1]);
+                if (window <= 0) {
+                    cerr << "*****ERROR: -window requires a positive window size" << endl;
+                    showHelp = true;
+                }
+                i++;
+            }
+            else {
+                cerr << "*****ERROR: -window requires a window size" << endl;
+                showHelp = true;
+            }
+        }
+        else if(PARAMETER_CHECK("-minmax", 7, parameterLength)) {
+            windowMinMax = true;
+        }
+        else if(PARAMETER_CHECK("-summary", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                haveSummary = true;
+                Tokenize(argv[i + 1], summaryThresholds, ',');
+                if (summaryThresholds.empty()) {
+                    cerr << "*****ERROR: -summary requires a comma-separated list of depths" << endl;
+                    showHelp = true;
+                }
+                i++;
+            }
+            else {
+                cerr << "*****ERROR: -summary requires a comma-separated list of depths" << endl;
+                showHelp = true;
+            }
+        }
+        else if(PARAMETER_CHECK("-footprint", 10, parameterLength)) {
+            footprint = true;
+        }
+        else if(PARAMETER_CHECK("-bedpe", 6, parameterLength)) {
+            bedpe = true;
+        }
+        else if(PARAMETER_CHECK("-fragments", 10, parameterLength)) {
+            fragments = true;
+        }
+        else if(PARAMETER_CHECK("-tracks", 7, parameterLength)) {
+            if ((i+1) < argc) {
+                tracksFile = argv[i + 1];
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-rg", 3, parameterLength)) {
+            tracksByReadGroup = true;
+        }
+        else if(PARAMETER_CHECK("-threads", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                numThreads = atoi(argv[i + 1]);
+                i++;
+            }
+        }
         else if(PARAMETER_CHECK("-trackline", 10, parameterLength)) {
                 add_gb_track_line = true;
         }
@@ -197,6 +264,53 @@ int genomecoverage_main(int argc, char* argv[]) {
       showHelp = true;
     }
 
+    if (window > 0 && (bedGraph || bedGraphAll || eachBase)) {
+      cerr << endl << "*****" << endl << "*****ERROR: Use -window or -d/-dz/-bg/-bga, not both" << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if (haveSummary && (bedGraph || bedGraphAll || eachBase || window > 0)) {
+      cerr << endl << "*****" << endl << "*****ERROR: -summary replaces the histogram, it can't be used with -d/-dz/-bg/-bga/-window" << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if (windowMinMax && window == 0) {
+      cerr << endl << "*****" << endl << "*****ERROR: Using -minmax requires windowed output (use -window)." << endl << "*****" << endl;
+      showHelp = true;
+    }
+
+    if ((footprint || bedpe) && !bamInput) {
+      cerr << endl << "*****" << endl << "*****ERROR: -footprint and -bedpe require BAM input (-ibam)." << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if (fragments && !bamInput) {
+      cerr << endl << "*****" << endl << "*****ERROR: -fragments requires BAM input (-ibam)." << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if ((footprint + bedpe + fragments) > 1) {
+      cerr << endl << "*****" << endl << "*****ERROR: Use only one of -footprint, -bedpe and -fragments" << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if ((footprint || bedpe || fragments) && (obeySplits || pair_chip || haveSize || only_3p_end || only_5p_end)) {
+      cerr << endl << "*****" << endl << "*****ERROR: -footprint, -bedpe and -fragments can't be used with -split, -pc, -fs, -3 or -5." << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if ((bedpe || fragments) && filterByStrand) {
+      cerr << endl << "*****" << endl << "*****ERROR: -bedpe and -fragments can't be used with -strand." << endl << "*****" << endl;
+      showHelp = true;
+    }
+
+    if (!tracksFile.empty() && !bamInput) {
+      cerr << endl << "*****" << endl << "*****ERROR: -tracks requires BAM input (-ibam)." << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if (!tracksFile.empty() && (footprint || bedpe)) {
+      cerr << endl << "*****" << endl << "*****ERROR: -tracks can't be used with -footprint or -bedpe." << endl << "*****" << endl;
+      showHelp = true;
+    }
+    if (tracksByReadGroup && tracksFile.empty()) {
+      cerr << endl << "*****" << endl << "*****ERROR: -rg requires -tracks." << endl << "*****" << endl;
+      showHelp = true;
+    }
+
     if (only_3p_end && only_5p_end) {
       cerr << endl << "*****" << endl << "*****ERROR: Use -3 or -5, not both " << endl << "*****" << endl;
       showHelp = true;
@@ -212,8 +326,8 @@ int genomecoverage_main(int argc, char* argv[]) {
       showHelp = true;
     }
 
-    if (haveScale && !(bedGraph||bedGraphAll||eachBase)) {
-      cerr << endl << "*****" << endl << "*****ERROR: Using -scale requires bedGraph output (use -bg or -bga) or per base depth (-d)." << endl << "*****" << endl;
+    if (haveScale && !(bedGraph||bedGraphAll||eachBase||window > 0)) {
+      cerr << endl << "*****" << endl << "*****ERROR: Using -scale requires bedGraph output (use -bg or -bga), per base depth (-d) or windows (-window)." << endl << "*****" << endl;
       showHelp = true;
     }
     
@@ -225,7 +339,12 @@ int genomecoverage_main(int argc, char* argv[]) {
                                                       only_5p_end, only_3p_end,
                                                       pair_chip, haveSize, fragmentSize, dUTP,
                                                       eachBaseZeroBased,
-                                                      add_gb_track_line, gb_track_opts);
+                                                      add_gb_track_line, gb_track_opts,
+                                                      window, windowMinMax,
+                                                      summaryThresholds,
+                                                      footprint, bedpe, fragments,
+                                                      tracksFile, tracksByReadGroup,
+                                                      numThreads);
         delete bc;
     }
     else {
@@ -263,6 +382,18 @@ void genomecoverage_help(void) {
     cerr << "\t\t\tquickly extract all regions of a genome with 0 " << endl;
     cerr << "\t\t\tcoverage by applying: \"grep -w 0$\" to the output." << endl << endl;
 
+    cerr << "\t-window\t\t" << "Report the mean depth of consecutive windows of this many bases" << endl;
+    cerr << "\t\t\t(chrom, start, end, mean). The last window of each" << endl;
+    cerr << "\t\t\tchromosome may be shorter. Uncovered windows are reported too." << endl;
+    cerr << "\t\t\t- (INTEGER)" << endl << endl;
+
+    cerr << "\t-minmax\t\t" << "With -window, also report the min and max depth of each window." << endl << endl;
+
+    cerr << "\t-summary\t" << "Instead of the histogram, report one line per chromosome and one for the" << endl;
+    cerr << "\t\t\twhole genome: chrom, size, mean depth and then the fraction of" << endl;
+    cerr << "\t\t\tbases with depth >= each of the given depths." << endl;
+    cerr << "\t\t\t- (comma-separated INTEGERs, e.g. 1,5,10)" << endl << endl;
+
     cerr << "\t-split\t\t" << "Treat \"split\" BAM or BED12 entries as distinct BED intervals." << endl;
     cerr << "\t\t\twhen computing coverage." << endl;
     cerr << "\t\t\tFor BAM files, this uses the CIGAR \"N\" and \"D\" operations " << endl;
@@ -270,6 +401,34 @@ void genomecoverage_help(void) {
     cerr << "\t\t\tFor BED12 files, this uses the BlockCount, BlockStarts, and BlockEnds" << endl;
     cerr << "\t\t\tfields (i.e., columns 10,11,12)." << endl << endl;
 
+    cerr << "\t-footprint\t" << "Count the whole alignment of each mapped read, deletions and" << endl;
+    cerr << "\t\t\tskipped regions included, like \"bamtobed | sort | genomecov -i\"." << endl;
+    cerr << "\t\t\tThe BAM doesn't have to be sorted." << endl;
+    cerr << "\t\t\tWorks for BAM files only" << endl << endl;
+
+    cerr << "\t-bedpe\t\t" << "Count whole fragments of the read pairs in a BAM grouped by name," << endl;
+    cerr << "\t\t\tfrom the start of the leftmost mate to the end of the other one," << endl;
+    cerr << "\t\t\tlike \"bamtobed -bedpe | cut -f 1,2,6 | sort | genomecov -i\"." << endl;
+    cerr << "\t\t\tPairs with an unmapped mate are skipped." << endl;
+    cerr << "\t\t\tWorks for BAM files only" << endl << endl;
+
+    cerr << "\t-fragments\t" << "Count whole fragments of the read pairs in a BAM sorted by position," << endl;
+    cerr << "\t\t\tas -bedpe does for the same BAM sorted by name. Mates are" << endl;
+    cerr << "\t\t\tpaired up by name as they come; pairs on two chromosomes," << endl;
+    cerr << "\t\t\tsecondary and supplementary alignments are skipped." << endl;
+    cerr << "\t\t\tWorks for BAM files only" << endl << endl;
+
+    cerr << "\t-tracks\t\t" << "Split the coverage into several output files (tracks) in one pass," << endl;
+    cerr << "\t\t\tas set by this tab-delimited file of (key, output file) lines." << endl;
+    cerr << "\t\t\tThe keys are reference names, or prefixes of them ending" << endl;
+    cerr << "\t\t\twith \"*\" (\"*\" alone matches all references). Each track" << endl;
+    cerr << "\t\t\tis reported as if its alignments were the whole BAM, and its" << endl;
+    cerr << "\t\t\treferences the whole genome. Nothing is written to stdout." << endl;
+    cerr << "\t\t\tWorks for BAM files only" << endl << endl;
+
+    cerr << "\t-rg\t\t" << "The keys of -tracks are read groups (the RG tag) instead." << endl;
+    cerr << "\t\t\tEvery track then covers all references." << endl << endl;
+
     cerr << "\t-strand\t\t" << "Calculate coverage of intervals from a specific strand." << endl;
     cerr << "\t\t\tWith BED files, requires at least 6 columns (strand is column 6). " << endl;
     cerr << "\t\t\t- (STRING): can be + or -" << endl << endl;
@@ -298,6 +457,14 @@ void genomecoverage_help(void) {
     cerr << "\t\t\t- Default is 1.0; i.e., unscaled." << endl;
     cerr << "\t\t\t- (FLOAT)" << endl << endl;
 
+    cerr << "\t-threads\t" << "Number of threads used for BAM (-ibam) input." << endl;
+    cerr << "\t\t\tA coordinate-sorted BAM with an index (.bai) is split" << endl;
+    cerr << "\t\t\tby chromosome between the threads (except with -d/-dz, -tracks)." << endl;
+    cerr << "\t\t\tOtherwise, blocks are inflated ahead of the reader." << endl;
+    cerr << "\t\t\tEither way, output is unchanged." << endl;
+    cerr << "\t\t\t- Default is 1." << endl;
+    cerr << "\t\t\t- (INTEGER)" << endl << endl;
+
     cerr << "\t-trackline\t" << "Adds a UCSC/Genome-Browser track line definition in the first line of the output." << endl;
     cerr <<"\t\t\t- See here for more details about track line definition:" << endl;
     cerr <<"\t\t\t      http://genome.ucsc.edu/goldenPath/help/bedgraph.html" << endl;
@@ -0,0 +1,65 @@
+/*****************************************************************************
+pendingMates.cpp
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "pendingMates.h"
+#include <algorithm>
+
+
+const size_t PendingMates::MIN_SWEEP_SIZE;
+
+PendingMates::PendingMates()
+: _sweepSize(MIN_SWEEP_SIZE)
+{
+}
+
+
+void PendingMates::Clear() {
+    mateMap().swap(_mates);
+    _sweepSize = MIN_SWEEP_SIZE;
+}
+
+
+bool PendingMates::AddMate(const string &name, int start, int end, int mateStart, bool isFirstMate,
+                           int &fragStart, int &fragEnd) {
+
+    mateMap::iterator mateItr = _mates.find(name);
+    if (mateItr == _mates.end()) {
+        // the partner comes later (or is gone, if it should have come already)
+        if (mateStart < start)
+            return false;
+        if (_mates.size() >= _sweepSize) {
+            Sweep(start);
+            _sweepSize = max(MIN_SWEEP_SIZE, 2 * _mates.size());
+        }
+        mate &m = _mates[name];
+        m.start = start;
+        m.end = end;
+        m.mateStart = mateStart;
+        m.isFirstMate = isFirstMate;
+        return false;
+    }
+
+    const mate &m = mateItr->second;
+    fragStart = m.start;
+    fragEnd = end;
+    // with both mates at the same start, bamtobed -bedpe on a BAM sorted by
+    // name ends the fragment at the second mate, whichever came first here
+    if (m.start == start && !m.isFirstMate)
+        fragEnd = m.end;
+    _mates.erase(mateItr);
+    return true;
+}
+
+
+// drop the mates whose partner should have shown up before pos
+void PendingMates::Sweep(int pos) {
+    mateMap::iterator mateItr = _mates.begin();
+    while (mateItr != _mates.end()) {
+        if (mateItr->second.mateStart < pos)
+            mateItr = _mates.erase(mateItr);
+        else
+            ++mateItr;
+    }
+}
@@ -0,0 +1,57 @@
+/*****************************************************************************
+pendingMates.h
+
+Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#ifndef PENDINGMATES_H
+#define PENDINGMATES_H
+
+#include <string>
+#include <unordered_map>
+using namespace std;
+
+
+//************************************************
+// Pairs up the mates of a coordinate-sorted BAM
+// into fragments, keyed by read name.
+//
+// The leftmost mate waits here until the other one
+// shows up. Mates whose partner never comes (it was
+// filtered out, say) are swept once the BAM has moved
+// past the partner's position, so the table only holds
+// the pairs that are still open at the current position.
+//************************************************
+class PendingMates {
+
+public:
+
+    PendingMates();
+
+    // forget all waiting mates (e.g. at a new chromosome)
+    void Clear();
+
+    // add one mate, at [start, end), whose partner starts at mateStart.
+    // returns true when this completes a pair: [fragStart, fragEnd) is then
+    // the span from the start of the leftmost mate to the end of the other.
+    bool AddMate(const string &name, int start, int end, int mateStart, bool isFirstMate,
+                 int &fragStart, int &fragEnd);
+
+private:
+
+    static const size_t MIN_SWEEP_SIZE = 1 << 16;
+
+    struct mate {
+        int start;
+        int end;
+        int mateStart;
+        bool isFirstMate;
+    };
+    typedef unordered_map<string, mate> mateMap;
+
+    mateMap _mates;
+    size_t _sweepSize;     // sweep when the table grows to this size
+
+    void Sweep(int pos);
+};
+
+#endif /* PENDINGMATES_H */
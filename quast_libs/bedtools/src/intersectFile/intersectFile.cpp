@@ -13,14 +13,14 @@
 #include "intersectFile.h"
 #include "ContextIntersect.h"
 #include "FileRecordMgr.h"
-#include "BinTree.h"
+#include "IntervalTree.h"
 #include "RecordOutputMgr.h"
 
 
 IntersectFile::IntersectFile(ContextIntersect *context)
 : ToolBase(upCast(context)),
   _sweep(NULL),
-  _binTree(NULL),
+  _intervalTree(NULL),
   _queryFRM(NULL)
 {
 
@@ -30,8 +30,8 @@ IntersectFile::~IntersectFile(void) {
 	delete _sweep;
 	_sweep = NULL;
 
-	delete _binTree;
-	_binTree = NULL;
+	delete _intervalTree;
+	_intervalTree = NULL;
 }
 
 bool IntersectFile::init() {
@@ -42,8 +42,8 @@ bool IntersectFile::init() {
 		 makeSweep();
 		return _sweep->init();
 	 } else {
-		_binTree = new BinTree( upCast(_context));
-		_binTree->loadDB();
+		_intervalTree = new IntervalTree(upCast(_context));
+		_intervalTree->loadDB();
 	 }
 
 	 return true;
@@ -107,7 +107,7 @@ bool IntersectFile::nextUnsortedFind(RecordKeyVector &hits)
 		} else {
 			_context->testNameConventions(queryRecord);
 			hits.setKey(queryRecord);
-			 _binTree->getHits(queryRecord, hits);
+			 _intervalTree->getHits(queryRecord, hits);
 			return true;
 		}
 	}
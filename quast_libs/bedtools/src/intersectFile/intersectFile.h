@@ -18,7 +18,7 @@
 
 
 class BlockMgr;
-class BinTree;
+class IntervalTree;
 
 class IntersectFile : public ToolBase {
 
@@ -35,7 +35,7 @@ public:
 
 protected:
 	NewChromSweep *_sweep;
-	BinTree *_binTree;
+	IntervalTree *_intervalTree;
 	FileRecordMgr *_queryFRM;
 
 	virtual bool nextSortedFind(RecordKeyVector &hits);
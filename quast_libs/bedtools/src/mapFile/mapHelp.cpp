@@ -22,6 +22,7 @@ void map_help(void) {
     KeyListOpsHelp();
 
     IntersectCommonHelp();
+    sortedThreadsHelp();
     allToolsCommonHelp();
 
     cerr << "Notes: " << endl;
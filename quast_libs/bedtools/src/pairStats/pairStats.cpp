@@ -0,0 +1,129 @@
+/*****************************************************************************
+  pairStats.cpp
+
+  Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "pairStats.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+
+// constructor
+PairStats::PairStats(const string &bamFile, size_t sampleSize, bool byRef)
+: _bamFile(bamFile)
+, _sampleSize(sampleSize)
+, _byRef(byRef)
+{
+    if (!_reader.Open(_bamFile)) {
+        cerr << "Error: The BAM file (" << _bamFile << ") could not be opened.  Exiting!" << endl;
+        exit(1);
+    }
+    _refs = _reader.GetReferenceData();
+}
+
+
+// destructor
+PairStats::~PairStats(void) {
+    _reader.Close();
+}
+
+
+void PairStats::Sample() {
+
+    sample genomeSample;
+    genomeSample.numReads = 0;
+    sample refSample;
+    refSample.numReads = 0;
+    int currRefId = -1;
+
+    BamAlignment bam;
+    while (_reader.GetNextAlignmentCore(bam)) {
+
+        // only the mates mapped in the correct orientation, as a proper pair
+        // (the flags 99/147 and 83/163, nothing secondary or duplicated)
+        const uint32_t flag = bam.AlignmentFlag;
+        if (flag != 99 && flag != 147 && flag != 83 && flag != 163)
+            continue;
+
+        if (_byRef && bam.RefID != currRefId) {
+            if (bam.RefID < currRefId) {
+                cerr << "Error: The BAM file (" << _bamFile << ") is not sorted by position, "
+                     << "which -byref requires.  Exiting!" << endl;
+                exit(1);
+            }
+            if (currRefId >= 0)
+                ReportSample(_refs[currRefId].RefName, refSample);
+            refSample.insertSizes.clear();
+            refSample.readLengths.clear();
+            refSample.numReads = 0;
+            currRefId = bam.RefID;
+        }
+
+        int insertSize = abs(bam.InsertSize);
+        AddRead(genomeSample, insertSize, bam.Length);
+        if (_byRef)
+            AddRead(refSample, insertSize, bam.Length);
+    }
+
+    if (_byRef && currRefId >= 0)
+        ReportSample(_refs[currRefId].RefName, refSample);
+    ReportSample("genome", genomeSample);
+}
+
+
+// keep a uniform sample of all the reads seen so far (reservoir sampling)
+void PairStats::AddRead(sample &s, int insertSize, int readLength) const {
+
+    s.numReads++;
+    if (s.insertSizes.size() < _sampleSize) {
+        s.insertSizes.push_back(insertSize);
+        s.readLengths.push_back(readLength);
+        return;
+    }
+
+    // a random number in the range [0, numReads), combining two
+    // calls to rand() as RAND_MAX may be far below the number of reads.
+    size_t idx = ((((long) rand()) << 31) | rand()) % s.numReads;
+    if (idx < _sampleSize) {
+        s.insertSizes[idx] = insertSize;
+        s.readLengths[idx] = readLength;
+    }
+}
+
+
+// name, reads, sampled reads, median and deciles 1-9 of the insert size,
+// mean, min and max read length. the median is the mean of the two middle
+// values for an even sample, the decile i the value at ceil(n*i/10)-1.
+void PairStats::ReportSample(const string &name, sample &s) const {
+
+    size_t n = s.insertSizes.size();
+    cout << name << "\t" << s.numReads << "\t" << n;
+    if (n == 0) {
+        for (int i = 0; i < 13; ++i)
+            cout << "\t.";
+        cout << endl;
+        return;
+    }
+
+    vector<int> &insertSizes = s.insertSizes;
+    sort(insertSizes.begin(), insertSizes.end());
+    int median = (n % 2 == 1) ? insertSizes[(n - 1) / 2] : (insertSizes[n / 2] + insertSizes[n / 2 - 1]) / 2;
+    cout << "\t" << median;
+    for (size_t decile = 1; decile <= 9; ++decile) {
+        size_t idx = (n * decile + 9) / 10;
+        cout << "\t" << insertSizes[idx > 0 ? idx - 1 : 0];
+    }
+
+    double lengthSum = 0;
+    int minLength = s.readLengths[0];
+    int maxLength = s.readLengths[0];
+    for (size_t i = 0; i < n; ++i) {
+        lengthSum += s.readLengths[i];
+        minLength = min(minLength, s.readLengths[i]);
+        maxLength = max(maxLength, s.readLengths[i]);
+    }
+    char meanString[64];
+    snprintf(meanString, sizeof(meanString), "%0.7f", lengthSum / n);
+    cout << "\t" << meanString << "\t" << minLength << "\t" << maxLength << endl;
+}
@@ -0,0 +1,57 @@
+/*****************************************************************************
+  pairStats.h
+
+  Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#ifndef PAIRSTATS_H
+#define PAIRSTATS_H
+
+#include "api/BamReader.h"
+using namespace BamTools;
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <stdlib.h>
+using namespace std;
+
+
+//************************************************
+// Estimates the insert size and read length of the
+// read pairs of a BAM file from a uniform (reservoir)
+// sample over the whole file, optionally also per
+// reference. Only the core of each record is decoded.
+//************************************************
+class PairStats {
+
+public:
+
+    // constructor
+    PairStats(const string &bamFile, size_t sampleSize, bool byRef);
+
+    // destructor
+    ~PairStats(void);
+
+    void Sample();
+
+private:
+
+    // the insert sizes and read lengths of the sampled reads (by index)
+    struct sample {
+        vector<int> insertSizes;
+        vector<int> readLengths;
+        size_t numReads;        // reads seen, sampled or not
+    };
+
+    string _bamFile;
+    size_t _sampleSize;
+    bool _byRef;
+
+    BamReader _reader;
+    RefVector _refs;
+
+    void AddRead(sample &s, int insertSize, int readLength) const;
+    void ReportSample(const string &name, sample &s) const;
+};
+
+#endif /* PAIRSTATS_H */
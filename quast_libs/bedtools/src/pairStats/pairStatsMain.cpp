@@ -0,0 +1,138 @@
+/*****************************************************************************
+  pairStatsMain.cpp
+
+  Licenced under the GNU General Public License 2.0 license.
+******************************************************************************/
+#include "pairStats.h"
+#include "version.h"
+
+using namespace std;
+
+// define our program name
+#define PROGRAM_NAME "bedtools pairstats"
+
+// define our parameter checking macro
+#define PARAMETER_CHECK(param, paramLen, actualLen) (strncmp(argv[i], param, min(actualLen, paramLen))== 0) && (actualLen == paramLen)
+
+// function declarations
+void pairstats_help(void);
+
+int pairstats_main(int argc, char* argv[]) {
+
+    // our configuration variables
+    bool showHelp = false;
+
+    // input files
+    string bamFile;
+
+    // parm flags
+    bool haveBam = false;
+    bool byRef   = false;
+
+    int sampleSize = 1000000;
+    int seed = 1;
+
+    // check to see if we should print out some help
+    if(argc <= 1) showHelp = true;
+
+    for(int i = 1; i < argc; i++) {
+        int parameterLength = (int)strlen(argv[i]);
+
+        if((PARAMETER_CHECK("-h", 2, parameterLength)) ||
+        (PARAMETER_CHECK("--help", 5, parameterLength))) {
+            showHelp = true;
+        }
+    }
+
+    if(showHelp) pairstats_help();
+
+    // do some parsing (all of these parameters require 2 strings)
+    for(int i = 1; i < argc; i++) {
+
+        int parameterLength = (int)strlen(argv[i]);
+
+        if(PARAMETER_CHECK("-ibam", 5, parameterLength)) {
+            if ((i+1) < argc) {
+                haveBam = true;
+                bamFile = argv[i + 1];
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-n", 2, parameterLength)) {
+            if ((i+1) < argc) {
+                sampleSize = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-seed", 5, parameterLength)) {
+            if ((i+1) < argc) {
+                seed = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-byref", 6, parameterLength)) {
+            byRef = true;
+        }
+        else {
+            cerr << endl << "*****ERROR: Unrecognized parameter: " << argv[i] << " *****" << endl << endl;
+            showHelp = true;
+        }
+    }
+
+    // make sure we have the input file
+    if (!haveBam) {
+        cerr << endl << "*****" << endl << "*****ERROR: Need -ibam. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (sampleSize <= 0) {
+        cerr << endl << "*****" << endl << "*****ERROR: -n must be a positive integer. " << endl << "*****" << endl;
+        showHelp = true;
+    }
+
+    if (!showHelp) {
+        srand(seed);
+        PairStats *pairStats = new PairStats(bamFile, (size_t)sampleSize, byRef);
+        pairStats->Sample();
+        delete pairStats;
+    }
+    else {
+        pairstats_help();
+    }
+    return 0;
+}
+
+void pairstats_help(void) {
+
+    cerr << "\nTool:    bedtools pairstats" << endl;
+    cerr << "Version: " << VERSION << "\n";
+    cerr << "Summary: Estimates the insert size and read length of the read pairs" << endl;
+    cerr << "\t in a BAM file, from a random sample over the whole file." << endl << endl;
+
+    cerr << "Usage:   " << PROGRAM_NAME << " [OPTIONS] -ibam <bam>" << endl << endl;
+
+    cerr << "Options: " << endl;
+
+    cerr << "\t-n\t" << "The number of reads to sample." << endl;
+    cerr << "\t\t- Default is 1000000." << endl << endl;
+
+    cerr << "\t-seed\t" << "The seed of the random sampling." << endl;
+    cerr << "\t\t- Default is 1." << endl << endl;
+
+    cerr << "\t-byref\t" << "Also sample each reference on its own, and report it" << endl;
+    cerr << "\t\tbefore the whole file. Requires a BAM sorted by position." << endl << endl;
+
+    cerr << "Output: " << endl;
+    cerr << "\tOne tab-delimited line per reference (with -byref), then one for" << endl;
+    cerr << "\tthe whole file, named \"genome\":" << endl;
+    cerr << "\tname, reads, sampled reads, median insert size, deciles 1-9 of" << endl;
+    cerr << "\tthe insert size, mean, min and max read length (\".\" if no reads)." << endl << endl;
+
+    cerr << "Notes: " << endl;
+    cerr << "\t(1) Only the mates mapped in the expected orientation as a proper pair" << endl;
+    cerr << "\t    are counted: the records with flags 99, 147, 83 and 163." << endl;
+    cerr << "\t(2) The insert size is the absolute TLEN, the read length is the" << endl;
+    cerr << "\t    length of SEQ." << endl << endl;
+
+    // end the program here
+    exit(1);
+}
@@ -16,7 +16,8 @@
 TagBam::TagBam(const string &bamFile, const vector<string> &annoFileNames,
             const vector<string> &annoLables, const string &tag,
             bool useNames, bool useScores, bool useIntervals, 
-            bool sameStrand, bool diffStrand, float overlapFraction):
+            bool sameStrand, bool diffStrand, float overlapFraction,
+            int compressionLevel, int numThreads):
 
     _bamFile(bamFile),
     _annoFileNames(annoFileNames),
@@ -27,7 +28,9 @@ TagBam::TagBam(const string &bamFile, const vector<string> &annoFileNames,
     _useIntervals(useIntervals),
     _sameStrand(sameStrand),
     _diffStrand(diffStrand),
-    _overlapFraction(overlapFraction)
+    _overlapFraction(overlapFraction),
+    _compressionLevel(compressionLevel),
+    _numThreads(numThreads)
 {}
 
 
@@ -76,6 +79,8 @@ void TagBam::Tag() {
     BamWriter::CompressionMode compressionMode = BamWriter::Compressed;
 //    if ( _isUncompressedBam ) compressionMode = BamWriter::Uncompressed;
     writer.SetCompressionMode(compressionMode);
+    writer.SetCompressionLevel(_compressionLevel);
+    writer.SetNumThreads(_numThreads);
     // open our BAM writer
     writer.Open("stdout", bamHeader, refs);
 
@@ -41,7 +41,8 @@ public:
     TagBam(const string &bamFile, const vector<string> &annoFileNames,
                 const vector<string> &annoLabels, const string &tag, 
                 bool useNames, bool useScores, bool useIntervals, bool sameStrand, 
-                bool diffStrand, float overlapFraction);
+                bool diffStrand, float overlapFraction,
+                int compressionLevel, int numThreads);
 
     // destructor
     ~TagBam(void);
@@ -71,6 +72,10 @@ private:
     bool _diffStrand;
     float _overlapFraction;
 
+    // BAM output settings
+    int _compressionLevel;
+    int _numThreads;
+
     // private function for reporting coverage information
     void ReportAnnotations();
 
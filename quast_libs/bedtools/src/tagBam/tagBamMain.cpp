@@ -32,6 +32,8 @@ int tagbam_main(int argc, char* argv[]) {
     string bamFile;
     float overlapFraction = 1E-9;
     string tag = "YB";
+    int compressionLevel = -1;
+    int numThreads = 1;
 
     // parm flags
     bool haveTag          = false;
@@ -133,6 +135,18 @@ int tagbam_main(int argc, char* argv[]) {
                 i++;
             }
         }
+        else if(PARAMETER_CHECK("-bamlevel", 9, parameterLength)) {
+            if ((i+1) < argc) {
+                compressionLevel = atoi(argv[i + 1]);
+                i++;
+            }
+        }
+        else if(PARAMETER_CHECK("-threads", 8, parameterLength)) {
+            if ((i+1) < argc) {
+                numThreads = atoi(argv[i + 1]);
+                i++;
+            }
+        }
         else {
             cerr << endl << "*****ERROR: Unrecognized parameter: " << argv[i] << " *****" << endl << endl;
             showHelp = true;
@@ -180,13 +194,21 @@ int tagbam_main(int argc, char* argv[]) {
         cerr << endl << "*****" << endl << "*****ERROR: -f must be > 0.0" << endl << "*****" << endl;
         showHelp = true;
     }
+    if (compressionLevel < -1 || compressionLevel > 9) {
+        cerr << endl << "*****" << endl << "*****ERROR: -bamlevel must be in range [-1,9] (-1 is the zlib default). " << endl << "*****" << endl;
+        showHelp = true;
+    }
+    if (numThreads < 1) {
+        cerr << endl << "*****" << endl << "*****ERROR: -threads must be at least 1. " << endl << "*****" << endl;
+        showHelp = true;
+    }
 
 
     if (!showHelp) {
         TagBam *ba = new TagBam(bamFile, inputFiles, inputLabels, 
                                 tag, useNames, useScores,  
                                 useIntervals, sameStrand, diffStrand, 
-                                overlapFraction);
+                                overlapFraction, compressionLevel, numThreads);
         ba->Tag();
         delete ba;
         return 0;
@@ -229,6 +251,11 @@ void tagbam_help(void) {
 
     cerr << "\t-intervals\t"    << "Use the full interval (including name, score, and strand) to populate tags." << endl;
     cerr                        << "\t\t\tRequires the -labels option to identify from which file the interval came." << endl << endl;    
+
+    cerr << "\t-bamlevel\t"     << "Compression level (0-9, or -1 for zlib default) for BAM output. Default is -1 (i.e. 6)." << endl;
+    cerr                        << "\t\t- Use 0 or 1 for temporary BAM files." << endl << endl;
+
+    cerr << "\t-threads\t"      << "Number of threads used to compress BAM output. Default is 1." << endl << endl;
     
     exit(1);
 }
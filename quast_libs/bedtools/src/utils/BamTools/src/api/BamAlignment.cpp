@@ -144,28 +144,26 @@ bool BamAlignment::BuildCharData(void) {
     const char* qualData    = ( hasQualData ? (((const char*)allCharData) + qualDataOffset) : (const char*)0 );
           char* tagData     = ( hasTagData  ? (((char*)allCharData) + tagDataOffset)        : (char*)0 );
 
-    // store alignment name (relies on null char in name as terminator)
-    Name.assign((const char*)(allCharData));
+    // store alignment name
+    // (all strings below are overwritten in place, so that an alignment reused
+    //  across records keeps its storage and needs no per-record heap allocation)
+    BuildName();
 
     // save query sequence
-    QueryBases.clear();
     if ( hasSeqData ) {
-        QueryBases.reserve(SupportData.QuerySequenceLength);
-        for ( size_t i = 0; i < SupportData.QuerySequenceLength; ++i ) {
-            const char singleBase = Constants::BAM_DNA_LOOKUP[ ( (seqData[(i/2)] >> (4*(1-(i%2)))) & 0xf ) ];
-            QueryBases.append(1, singleBase);
-        }
-    }
+        QueryBases.resize(SupportData.QuerySequenceLength);
+        for ( size_t i = 0; i < SupportData.QuerySequenceLength; ++i )
+            QueryBases[i] = Constants::BAM_DNA_LOOKUP[ ( (seqData[(i/2)] >> (4*(1-(i%2)))) & 0xf ) ];
+    } else
+        QueryBases.clear();
 
     // save qualities, converting from numeric QV to 'FASTQ-style' ASCII character
-    Qualities.clear();
     if ( hasQualData ) {
-        Qualities.reserve(SupportData.QuerySequenceLength);
-        for ( size_t i = 0; i < SupportData.QuerySequenceLength; ++i ) {
-            const char singleQuality = static_cast<const char>(qualData[i]+33);
-            Qualities.append(1, singleQuality);
-        }
-    }
+        Qualities.resize(SupportData.QuerySequenceLength);
+        for ( size_t i = 0; i < SupportData.QuerySequenceLength; ++i )
+            Qualities[i] = static_cast<const char>(qualData[i]+33);
+    } else
+        Qualities.clear();
 
     // clear previous AlignedBases
     AlignedBases.clear();
@@ -191,7 +189,7 @@ bool BamAlignment::BuildCharData(void) {
                 case (Constants::BAM_CIGAR_INS_CHAR)      :
                 case (Constants::BAM_CIGAR_SEQMATCH_CHAR) :
                 case (Constants::BAM_CIGAR_MISMATCH_CHAR) :
-                    AlignedBases.append(QueryBases.substr(k, op.Length));
+                    AlignedBases.append(QueryBases, k, op.Length);
                     // fall through
 
                 // for 'S' - soft clip, do not write bases
@@ -229,8 +227,9 @@ bool BamAlignment::BuildCharData(void) {
     }
 
     // save tag data
-    TagData.clear();
-    if ( hasTagData ) {
+    if ( !hasTagData )
+        TagData.clear();
+    else {
         if ( IsBigEndian ) {
             size_t i = 0;
             while ( i < tagDataLength ) {
@@ -322,8 +321,7 @@ bool BamAlignment::BuildCharData(void) {
         }
 
         // store tagData in alignment
-        TagData.resize(tagDataLength);
-        memcpy((char*)(TagData.data()), tagData, tagDataLength);
+        TagData.assign(tagData, tagDataLength);
     }
 
     // clear core-only flag & return success
@@ -331,6 +329,22 @@ bool BamAlignment::BuildCharData(void) {
     return true;
 }
 
+/*! \fn void BamAlignment::BuildName(void)
+    \brief Populates only the read name of an alignment retrieved using
+    BamReader::GetNextAlignmentCore().
+
+    Much cheaper than BuildCharData() when the name is all that is needed besides
+    the positional data: bases, qualities and tags are left undecoded, and the
+    alignment stays 'core-only' (BuildCharData() can still be called later).
+*/
+void BamAlignment::BuildName(void) {
+    // the stored length includes the name's null terminator
+    if ( SupportData.QueryNameLength > 0 )
+        Name.assign(SupportData.AllCharData.data(), SupportData.QueryNameLength - 1);
+    else
+        Name.clear();
+}
+
 /*! \fn bool BamAlignment::FindTag(const std::string& tag, char*& pTagData, const unsigned int& tagDataLength, unsigned int& numBytesParsed) const
     \internal
 
@@ -93,6 +93,8 @@ class API_EXPORT BamAlignment {
     public:
         // populates alignment string fields
         bool BuildCharData(void);
+        // populates only the read name field (of a core-only alignment)
+        void BuildName(void);
 
         // calculates alignment end position
         int GetEndPosition(bool usePadded = false, bool closedInterval = false) const;
@@ -315,6 +315,19 @@ void BamReader::SetIndex(BamIndex* index) {
     d->SetIndex(index);
 }
 
+/*! \fn void BamReader::SetNumThreads(const int numThreads)
+    \brief Sets the number of threads used to decompress BAM data.
+
+    With more than one thread, BGZF blocks following the current one are
+    inflated in the background while alignments are read, strictly in file
+    order. Results are identical to single-threaded reading.
+
+    \param[in] numThreads number of decompression threads (1 disables read-ahead)
+*/
+void BamReader::SetNumThreads(const int numThreads) {
+    d->SetNumThreads(numThreads);
+}
+
 /*! \fn bool BamReader::SetRegion(const BamRegion& region)
     \brief Sets a target region of interest
 
@@ -50,6 +50,8 @@ class API_EXPORT BamReader {
 
         // returns internal file pointer to beginning of alignment data
         bool Rewind(void);
+        // sets the number of threads used to decompress BAM data ahead of the reader
+        void SetNumThreads(const int numThreads);
         // sets the target region of interest
         bool SetRegion(const BamRegion& region);
         // sets the target region of interest
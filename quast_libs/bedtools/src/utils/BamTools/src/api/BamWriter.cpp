@@ -150,3 +150,36 @@ bool BamWriter::SaveAlignment(const BamAlignment& alignment) {
 void BamWriter::SetCompressionMode(const BamWriter::CompressionMode& compressionMode) {
     d->SetWriteCompressed( compressionMode == BamWriter::Compressed );
 }
+
+/*! \fn void BamWriter::SetCompressionLevel(const int level)
+    \brief Sets the zlib compression level used for compressed output.
+
+    Level ranges from 0 (store) to 9 (best compression). Default is zlib's own
+    default (6). Has no effect when compression mode is BamWriter::Uncompressed.
+
+    \note Changing the compression level is disabled on open files (i.e. the request will
+    be ignored). Be sure to call this function before opening the BAM file.
+
+    \param[in] level desired zlib compression level
+    \sa SetCompressionMode(), Open()
+*/
+void BamWriter::SetCompressionLevel(const int level) {
+    d->SetCompressionLevel(level);
+}
+
+/*! \fn void BamWriter::SetNumThreads(const int numThreads)
+    \brief Sets the number of threads used to compress BAM data.
+
+    With more than one thread, filled BGZF blocks are handed to a pool of
+    workers and written out strictly in order as they finish, so output is
+    byte-identical to single-threaded writing.
+
+    \note Changing the thread count is disabled on open files (i.e. the request will
+    be ignored). Be sure to call this function before opening the BAM file.
+
+    \param[in] numThreads number of compression threads (1 compresses serially)
+    \sa Open()
+*/
+void BamWriter::SetNumThreads(const int numThreads) {
+    d->SetNumThreads(numThreads);
+}
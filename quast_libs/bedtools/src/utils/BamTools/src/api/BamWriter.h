@@ -58,6 +58,10 @@ class API_EXPORT BamWriter {
         bool SaveAlignment(const BamAlignment& alignment);
         // sets the output compression mode
         void SetCompressionMode(const BamWriter::CompressionMode& compressionMode);
+        // sets the zlib compression level (0-9) for compressed output
+        void SetCompressionLevel(const int level);
+        // sets the number of threads used to compress output
+        void SetNumThreads(const int numThreads);
 
     // private implementation
     private:
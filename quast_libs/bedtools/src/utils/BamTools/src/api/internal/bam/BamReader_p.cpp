@@ -271,14 +271,14 @@ bool BamReaderPrivate::LoadNextAlignment(BamAlignment& alignment) {
     alignment.Length = alignment.SupportData.QuerySequenceLength;
 
     // read in character data - make sure proper data size was read
+    // (read straight into supportData structure, reusing its storage from the
+    //  previous alignment, so that no per-record heap allocation is needed)
     bool readCharDataOK = false;
     const unsigned int dataLength = alignment.SupportData.BlockLength - Constants::BAM_CORE_SIZE;
-    RaiiBuffer allCharData(dataLength);
+    alignment.SupportData.AllCharData.resize(dataLength);
+    char* allCharData = &alignment.SupportData.AllCharData[0];
 
-    if ( m_stream.Read(allCharData.Buffer, dataLength) == dataLength ) {
-
-        // store 'allCharData' in supportData structure
-        alignment.SupportData.AllCharData.assign((const char*)allCharData.Buffer, dataLength);
+    if ( m_stream.Read(allCharData, dataLength) == dataLength ) {
 
         // set success flag
         readCharDataOK = true;
@@ -286,19 +286,19 @@ bool BamReaderPrivate::LoadNextAlignment(BamAlignment& alignment) {
         // save CIGAR ops
         // need to calculate this here so that  BamAlignment::GetEndPosition() performs correctly,
         // even when GetNextAlignmentCore() is called
-        const unsigned int cigarDataOffset = alignment.SupportData.QueryNameLength;
-        uint32_t* cigarData = (uint32_t*)(allCharData.Buffer + cigarDataOffset);
+        const char* cigarData = allCharData + alignment.SupportData.QueryNameLength;
         CigarOp op;
         alignment.CigarData.clear();
         alignment.CigarData.reserve(alignment.SupportData.NumCigarOperations);
         for ( unsigned int i = 0; i < alignment.SupportData.NumCigarOperations; ++i ) {
 
-            // swap endian-ness if necessary
-            if ( m_isBigEndian ) BamTools::SwapEndian_32(cigarData[i]);
+            // swap endian-ness if necessary (on a copy, AllCharData keeps the raw bytes)
+            uint32_t cigarValue = BamTools::UnpackUnsignedInt(&cigarData[i*sizeof(uint32_t)]);
+            if ( m_isBigEndian ) BamTools::SwapEndian_32(cigarValue);
 
             // build CigarOp structure
-            op.Length = (cigarData[i] >> Constants::BAM_CIGAR_SHIFT);
-            op.Type   = Constants::BAM_CIGAR_LOOKUP[ (cigarData[i] & Constants::BAM_CIGAR_MASK) ];
+            op.Length = (cigarValue >> Constants::BAM_CIGAR_SHIFT);
+            op.Type   = Constants::BAM_CIGAR_LOOKUP[ (cigarValue & Constants::BAM_CIGAR_MASK) ];
 
             // save CigarOp
             alignment.CigarData.push_back(op);
@@ -475,6 +475,17 @@ void BamReaderPrivate::SetIndex(BamIndex* index) {
     m_randomAccessController.SetIndex(index);
 }
 
+// sets number of BGZF decompression threads
+void BamReaderPrivate::SetNumThreads(const int numThreads) {
+    try {
+        m_stream.SetNumThreads(numThreads);
+    } catch ( BamException& e ) {
+        const string streamError = e.what();
+        const string message = string("could not set number of threads: \n\t") + streamError;
+        SetErrorString("BamReader::SetNumThreads", message);
+    }
+}
+
 // sets current region & attempts to jump to it
 // returns success/failure
 bool BamReaderPrivate::SetRegion(const BamRegion& region) {
@@ -49,6 +49,7 @@ class BamReaderPrivate {
         bool Open(const std::string& filename);
         bool OpenStream(std::istream* stream);
         bool Rewind(void);
+        void SetNumThreads(const int numThreads);
         bool SetRegion(const BamRegion& region);
 
         // access alignment data
@@ -199,6 +199,18 @@ bool BamWriterPrivate::SaveAlignment(const BamAlignment& al) {
     }
 }
 
+void BamWriterPrivate::SetCompressionLevel(const int level) {
+    // modifying compression is not allowed if BAM file is open
+    if ( !IsOpen() )
+        m_stream.SetCompressionLevel(level);
+}
+
+void BamWriterPrivate::SetNumThreads(const int numThreads) {
+    // modifying thread count is not allowed if BAM file is open
+    if ( !IsOpen() )
+        m_stream.SetNumThreads(numThreads);
+}
+
 void BamWriterPrivate::SetWriteCompressed(bool ok) {
     // modifying compression is not allowed if BAM file is open
     if ( !IsOpen() )
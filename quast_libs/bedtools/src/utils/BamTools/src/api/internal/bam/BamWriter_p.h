@@ -47,6 +47,8 @@ class BamWriterPrivate {
                   const std::string& samHeaderText,
                   const BamTools::RefVector& referenceSequences);
         bool SaveAlignment(const BamAlignment& al);
+        void SetCompressionLevel(const int level);
+        void SetNumThreads(const int numThreads);
         void SetWriteCompressed(bool ok);
 
     // 'internal' methods
@@ -13,6 +13,7 @@
 #include "api/BamConstants.h"
 #include "api/internal/io/BamDeviceFactory_p.h"
 #include "api/internal/io/BgzfStream_p.h"
+#include "api/internal/io/BgzfThreadPool_p.h"
 #include "api/internal/utils/BamException_p.h"
 using namespace BamTools;
 using namespace BamTools::Internal;
@@ -25,6 +26,9 @@ using namespace BamTools::Internal;
 #include <sstream>
 using namespace std;
 
+// number of blocks kept in flight per read-ahead thread
+static const size_t BGZF_READ_AHEAD_PER_THREAD = 4;
+
 // ---------------------------
 // BgzfStream implementation
 // ---------------------------
@@ -35,14 +39,21 @@ BgzfStream::BgzfStream(void)
   , m_blockOffset(0)
   , m_blockAddress(0)
   , m_isWriteCompressed(true)
+  , m_compressionLevel(Z_DEFAULT_COMPRESSION)
   , m_device(0)
   , m_uncompressedBlock(Constants::BGZF_DEFAULT_BLOCK_SIZE)
   , m_compressedBlock(Constants::BGZF_MAX_BLOCK_SIZE)
+  , m_threadPool(0)
+  , m_jobsHead(0)
+  , m_numJobsPending(0)
+  , m_isReadAheadDone(false)
+  , m_nextBlockAddress(0)
 { }
 
 // destructor
 BgzfStream::~BgzfStream(void) {
     Close();
+    SetNumThreads(1);
 }
 
 // checks BGZF block header
@@ -63,14 +74,20 @@ void BgzfStream::Close(void) {
     // skip if no device open
     if ( m_device == 0 ) return;
 
-    // if writing to file, flush the current BGZF block,
+    // if writing to file, flush the current BGZF block (and any still being compressed),
     // then write an empty block (as EOF marker)
     if ( m_device->IsOpen() && (m_device->Mode() == IBamIODevice::WriteOnly) ) {
         FlushBlock();
+        if ( m_threadPool )
+            FlushQueuedBlocks();
         const size_t blockLength = DeflateBlock();
         m_device->Write(m_compressedBlock.Buffer, blockLength);
     }
 
+    // otherwise wait for any blocks still being inflated
+    else if ( m_threadPool )
+        DiscardReadAhead();
+
     // close device
     m_device->Close();
     delete m_device;
@@ -85,13 +102,47 @@ void BgzfStream::Close(void) {
     m_blockOffset = 0;
     m_blockAddress = 0;
     m_isWriteCompressed = true;
+    m_compressionLevel = Z_DEFAULT_COMPRESSION;
 }
 
 // compresses the current block
 size_t BgzfStream::DeflateBlock(void) {
 
+    // set compression level
+    const int compressionLevel = ( m_isWriteCompressed ? m_compressionLevel : 0 );
+
+    // compress as much of the block as fits
+    unsigned int inputLength = m_blockOffset;
+    const size_t compressedLength = DeflateBuffer(m_uncompressedBlock.Buffer,
+                                                  inputLength,
+                                                  m_compressedBlock.Buffer,
+                                                  compressionLevel);
+
+    // ensure that we have less than a block of data left
+    int remaining = m_blockOffset - inputLength;
+    if ( remaining > 0 ) {
+        if ( remaining > (int)inputLength )
+            throw BamException("BgzfStream::DeflateBlock", "after deflate, remainder too large");
+        memcpy(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + inputLength, remaining);
+    }
+
+    // update block data
+    m_blockOffset = remaining;
+
+    // return result
+    return compressedLength;
+}
+
+// compresses up to @inputLength bytes of @uncompressed into a complete BGZF block in @compressed
+// on return, @inputLength holds the number of bytes that actually fit into the block
+// this is a static method, so it is safe to call from worker threads
+size_t BgzfStream::DeflateBuffer(const char* uncompressed,
+                                 unsigned int& inputLength,
+                                 char* compressed,
+                                 const int compressionLevel)
+{
     // initialize the gzip header
-    char* buffer = m_compressedBlock.Buffer;
+    char* buffer = compressed;
     memset(buffer, 0, 18);
     buffer[0]  = Constants::GZIP_ID1;
     buffer[1]  = Constants::GZIP_ID2;
@@ -103,11 +154,8 @@ size_t BgzfStream::DeflateBlock(void) {
     buffer[13] = Constants::BGZF_ID2;
     buffer[14] = Constants::BGZF_LEN;
 
-    // set compression level
-    const int compressionLevel = ( m_isWriteCompressed ? Z_DEFAULT_COMPRESSION : 0 );
-
     // loop to retry for blocks that do not compress enough
-    int inputLength = m_blockOffset;
+    int currentLength = inputLength;
     size_t compressedLength = 0;
     const unsigned int bufferSize = Constants::BGZF_MAX_BLOCK_SIZE;
 
@@ -117,8 +165,8 @@ size_t BgzfStream::DeflateBlock(void) {
         z_stream zs;
         zs.zalloc    = NULL;
         zs.zfree     = NULL;
-        zs.next_in   = (Bytef*)m_uncompressedBlock.Buffer;
-        zs.avail_in  = inputLength;
+        zs.next_in   = (Bytef*)uncompressed;
+        zs.avail_in  = currentLength;
         zs.next_out  = (Bytef*)&buffer[Constants::BGZF_BLOCK_HEADER_LENGTH];
         zs.avail_out = bufferSize -
                        Constants::BGZF_BLOCK_HEADER_LENGTH -
@@ -145,8 +193,8 @@ size_t BgzfStream::DeflateBlock(void) {
             // there was not enough space available in buffer
             // try to reduce the input length & re-start loop
             if ( status == Z_OK ) {
-                inputLength -= 1024;
-                if ( inputLength < 0 )
+                currentLength -= 1024;
+                if ( currentLength < 0 )
                     throw BamException("BgzfStream::DeflateBlock", "input reduction failed");
                 continue;
             }
@@ -175,22 +223,12 @@ size_t BgzfStream::DeflateBlock(void) {
 
     // store the CRC32 checksum
     uint32_t crc = crc32(0, NULL, 0);
-    crc = crc32(crc, (Bytef*)m_uncompressedBlock.Buffer, inputLength);
+    crc = crc32(crc, (Bytef*)uncompressed, currentLength);
     BamTools::PackUnsignedInt(&buffer[compressedLength - 8], crc);
-    BamTools::PackUnsignedInt(&buffer[compressedLength - 4], inputLength);
-
-    // ensure that we have less than a block of data left
-    int remaining = m_blockOffset - inputLength;
-    if ( remaining > 0 ) {
-        if ( remaining > inputLength )
-            throw BamException("BgzfStream::DeflateBlock", "after deflate, remainder too large");
-        memcpy(m_uncompressedBlock.Buffer, m_uncompressedBlock.Buffer + inputLength, remaining);
-    }
-
-    // update block data
-    m_blockOffset = remaining;
+    BamTools::PackUnsignedInt(&buffer[compressedLength - 4], currentLength);
 
     // return result
+    inputLength = currentLength;
     return compressedLength;
 }
 
@@ -199,6 +237,12 @@ void BgzfStream::FlushBlock(void) {
 
     BT_ASSERT_X( m_device, "BgzfStream::FlushBlock() - attempting to flush to null device" );
 
+    // let the pool do the compressing, if we have one
+    if ( m_threadPool ) {
+        QueueWriteBlock();
+        return;
+    }
+
     // flush all of the remaining blocks
     while ( m_blockOffset > 0 ) {
 
@@ -227,16 +271,40 @@ void BgzfStream::FlushBlock(void) {
     }
 }
 
+// waits for in-flight read-ahead blocks & drops them
+void BgzfStream::DiscardReadAhead(void) {
+    for ( ; m_numJobsPending > 0; --m_numJobsPending ) {
+        m_threadPool->Wait(m_jobs[m_jobsHead]);
+        m_jobsHead = (m_jobsHead + 1) % m_jobs.size();
+    }
+    m_jobsHead = 0;
+    m_isReadAheadDone = false;
+}
+
+// writes all blocks still queued for compression, in order
+void BgzfStream::FlushQueuedBlocks(void) {
+    while ( m_numJobsPending > 0 )
+        WriteQueuedBlock();
+}
+
 // decompresses the current block
 size_t BgzfStream::InflateBlock(const size_t& blockLength) {
+    return InflateBuffer(m_compressedBlock.Buffer, blockLength, m_uncompressedBlock.Buffer);
+}
 
+// decompresses a raw BGZF block (header included) into a BGZF_DEFAULT_BLOCK_SIZE buffer
+// this is a static method, so it is safe to call from worker threads
+size_t BgzfStream::InflateBuffer(const char* compressed,
+                                 const size_t& blockLength,
+                                 char* uncompressed)
+{
     // setup zlib stream object
     z_stream zs;
     zs.zalloc    = NULL;
     zs.zfree     = NULL;
-    zs.next_in   = (Bytef*)m_compressedBlock.Buffer + 18;
+    zs.next_in   = (Bytef*)compressed + 18;
     zs.avail_in  = blockLength - 16;
-    zs.next_out  = (Bytef*)m_uncompressedBlock.Buffer;
+    zs.next_out  = (Bytef*)uncompressed;
     zs.avail_out = Constants::BGZF_DEFAULT_BLOCK_SIZE;
 
     // initialize
@@ -308,6 +376,51 @@ void BgzfStream::OpenStream(std::istream* stream, const IBamIODevice::OpenMode m
     }
 }
 
+// hands the current block over to the pool for compression
+void BgzfStream::QueueWriteBlock(void) {
+
+    // skip if nothing to compress
+    if ( m_blockOffset == 0 )
+        return;
+
+    // make room in the ring by writing out the oldest block
+    if ( m_numJobsPending == m_jobs.size() )
+        WriteQueuedBlock();
+
+    // take over the next free slot (buffers are the same size, so just swap them)
+    BgzfBlockJob* job = m_jobs[(m_jobsHead + m_numJobsPending) % m_jobs.size()];
+    std::swap(m_uncompressedBlock.Buffer, job->UncompressedBlock.Buffer);
+    job->UncompressedLength = m_blockOffset;
+    job->CompressionLevel   = ( m_isWriteCompressed ? m_compressionLevel : 0 );
+    job->Type               = BgzfBlockJob::Deflate;
+    m_blockOffset = 0;
+
+    // hand it over to the workers
+    m_threadPool->Submit(job);
+    ++m_numJobsPending;
+}
+
+// keeps the read-ahead ring full of blocks being inflated by the pool
+void BgzfStream::QueueReadAhead(void) {
+
+    while ( !m_isReadAheadDone && m_numJobsPending < m_jobs.size() ) {
+
+        // read raw block into the next free slot
+        BgzfBlockJob* job = m_jobs[(m_jobsHead + m_numJobsPending) % m_jobs.size()];
+        job->BlockAddress = m_device->Tell();
+        if ( !ReadCompressedBlock(job->CompressedBlock.Buffer, job->CompressedLength) ) {
+            m_isReadAheadDone = true;
+            break;
+        }
+        job->NextBlockAddress = m_device->Tell();
+        job->Type = BgzfBlockJob::Inflate;
+
+        // hand it over to the workers
+        m_threadPool->Submit(job);
+        ++m_numJobsPending;
+    }
+}
+
 // reads BGZF data into a byte buffer
 size_t BgzfStream::Read(char* data, const size_t dataLength) {
 
@@ -347,7 +460,7 @@ size_t BgzfStream::Read(char* data, const size_t dataLength) {
 
     // update block data
     if ( m_blockOffset == m_blockLength ) {
-        m_blockAddress = m_device->Tell();
+        m_blockAddress = ( m_threadPool ? m_nextBlockAddress : m_device->Tell() );
         m_blockOffset  = 0;
         m_blockLength  = 0;
 
@@ -362,9 +475,72 @@ void BgzfStream::ReadBlock(void) {
 
     BT_ASSERT_X( m_device, "BgzfStream::ReadBlock() - trying to read from null IO device");
 
+    // let the pool do the inflating, if we have one
+    if ( m_threadPool ) {
+        ReadBlockAhead();
+        return;
+    }
+
     // store block's starting address
     int64_t blockAddress = m_device->Tell();
 
+    // read raw block, if block header empty
+    size_t blockLength = 0;
+    if ( !ReadCompressedBlock(m_compressedBlock.Buffer, blockLength) ) {
+        m_blockLength = 0;
+        return;
+    }
+
+    // decompress block data
+    const size_t newBlockLength = InflateBlock(blockLength);
+
+    // update block data
+    if ( m_blockLength != 0 )
+        m_blockOffset = 0;
+    m_blockAddress = blockAddress;
+    m_blockLength  = newBlockLength;
+}
+
+// takes the next inflated block from the read-ahead ring
+void BgzfStream::ReadBlockAhead(void) {
+
+    // make sure blocks are in flight
+    QueueReadAhead();
+
+    // if no more blocks
+    if ( m_numJobsPending == 0 ) {
+        m_blockLength = 0;
+        return;
+    }
+
+    // wait for the oldest block & release its slot
+    BgzfBlockJob* job = m_jobs[m_jobsHead];
+    m_threadPool->Wait(job);
+    m_jobsHead = (m_jobsHead + 1) % m_jobs.size();
+    --m_numJobsPending;
+
+    // check for worker error
+    if ( !job->ErrorString.empty() )
+        throw BamException("BgzfStream::ReadBlock", job->ErrorString);
+
+    // take over its uncompressed data (buffers are the same size, so just swap them)
+    std::swap(m_uncompressedBlock.Buffer, job->UncompressedBlock.Buffer);
+
+    // update block data
+    if ( m_blockLength != 0 )
+        m_blockOffset = 0;
+    m_blockAddress     = job->BlockAddress;
+    m_blockLength      = job->UncompressedLength;
+    m_nextBlockAddress = job->NextBlockAddress;
+
+    // refill the slot we just freed
+    QueueReadAhead();
+}
+
+// reads the next raw BGZF block (header included) into @buffer
+// returns false if there are no more blocks to read
+bool BgzfStream::ReadCompressedBlock(char* buffer, size_t& blockLength) {
+
     // read block header from file
     char header[Constants::BGZF_BLOCK_HEADER_LENGTH];
     memset(header, 0, Constants::BGZF_BLOCK_HEADER_LENGTH);
@@ -378,10 +554,8 @@ void BgzfStream::ReadBlock(void) {
     }
 
     // if block header empty
-    if ( numBytesRead == 0 ) {
-        m_blockLength = 0;
-        return;
-    }
+    if ( numBytesRead == 0 )
+        return false;
 
     // if block header invalid size
     if ( numBytesRead != static_cast<int8_t>(Constants::BGZF_BLOCK_HEADER_LENGTH) )
@@ -392,12 +566,12 @@ void BgzfStream::ReadBlock(void) {
         throw BamException("BgzfStream::ReadBlock", "invalid block header contents");
 
     // copy header contents to compressed buffer
-    const size_t blockLength = BamTools::UnpackUnsignedShort(&header[16]) + 1;
-    memcpy(m_compressedBlock.Buffer, header, Constants::BGZF_BLOCK_HEADER_LENGTH);
+    blockLength = BamTools::UnpackUnsignedShort(&header[16]) + 1;
+    memcpy(buffer, header, Constants::BGZF_BLOCK_HEADER_LENGTH);
 
     // read remainder of block
     const size_t remaining = blockLength - Constants::BGZF_BLOCK_HEADER_LENGTH;
-    numBytesRead = m_device->Read(&m_compressedBlock.Buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
+    numBytesRead = m_device->Read(&buffer[Constants::BGZF_BLOCK_HEADER_LENGTH], remaining);
 
     // check for device error
     if ( numBytesRead < 0 ) {
@@ -409,14 +583,7 @@ void BgzfStream::ReadBlock(void) {
     if ( numBytesRead != static_cast<int64_t>(remaining) )
         throw BamException("BgzfStream::ReadBlock", "could not read data from block");
 
-    // decompress block data
-    const size_t newBlockLength = InflateBlock(blockLength);
-
-    // update block data
-    if ( m_blockLength != 0 )
-        m_blockOffset = 0;
-    m_blockAddress = blockAddress;
-    m_blockLength  = newBlockLength;
+    return true;
 }
 
 // seek to position in BGZF file
@@ -427,6 +594,10 @@ void BgzfStream::Seek(const int64_t& position) {
     // skip if device is not open
     if ( !IsOpen() ) return;
 
+    // blocks read ahead are useless after a jump
+    if ( m_threadPool )
+        DiscardReadAhead();
+
     // determine adjusted offset & address
     int     blockOffset  = (position & 0xFFFF);
     int64_t blockAddress = (position >> 16) & 0xFFFFFFFFFFFFLL;
@@ -446,6 +617,59 @@ void BgzfStream::Seek(const int64_t& position) {
     }
 }
 
+// sets zlib compression level (0-9) used when writing compressed output
+void BgzfStream::SetCompressionLevel(const int level) {
+    m_compressionLevel = level;
+}
+
+// sets number of threads used to (de)compress blocks
+void BgzfStream::SetNumThreads(const int numThreads) {
+
+    const int currentNumThreads = ( m_threadPool ? m_threadPool->NumThreads() : 1 );
+    if ( numThreads == currentNumThreads || (numThreads <= 1 && currentNumThreads == 1) )
+        return;
+
+    // tear down current pool, after writing out pending blocks (or rewinding
+    // device to the first block not yet handed out to the reader)
+    if ( m_threadPool ) {
+        if ( IsOpen() && (m_device->Mode() == IBamIODevice::WriteOnly) )
+            FlushQueuedBlocks();
+        else {
+            const bool hasUnreadBlocks = ( m_numJobsPending > 0 );
+            const int64_t unreadAddress = ( hasUnreadBlocks ? m_jobs[m_jobsHead]->BlockAddress : 0 );
+            DiscardReadAhead();
+            if ( hasUnreadBlocks && !m_device->Seek(unreadAddress) )
+                throw BamException("BgzfStream::SetNumThreads", "unable to rewind read-ahead blocks");
+        }
+
+        delete m_threadPool;
+        m_threadPool = 0;
+
+        vector<BgzfBlockJob*>::iterator jobIter = m_jobs.begin();
+        vector<BgzfBlockJob*>::iterator jobEnd  = m_jobs.end();
+        for ( ; jobIter != jobEnd; ++jobIter )
+            delete (*jobIter);
+        m_jobs.clear();
+    }
+
+    // single-threaded mode needs no pool
+    if ( numThreads <= 1 )
+        return;
+
+    // set up new pool & its ring of blocks
+    m_threadPool = new BgzfThreadPool(numThreads);
+    m_jobs.resize(numThreads * BGZF_READ_AHEAD_PER_THREAD);
+    for ( size_t i = 0; i < m_jobs.size(); ++i )
+        m_jobs[i] = new BgzfBlockJob;
+    m_jobsHead = 0;
+    m_numJobsPending = 0;
+    m_isReadAheadDone = false;
+
+    // if already reading, the block after the current one starts where the device stands now
+    if ( IsOpen() && (m_device->Mode() == IBamIODevice::ReadOnly) )
+        m_nextBlockAddress = m_device->Tell();
+}
+
 void BgzfStream::SetWriteCompressed(bool ok) {
     m_isWriteCompressed = ok;
 }
@@ -454,7 +678,17 @@ void BgzfStream::SetWriteCompressed(bool ok) {
 int64_t BgzfStream::Tell(void) const {
     if ( !IsOpen() )
         return 0;
-    return ( (m_blockAddress << 16) | (m_blockOffset & 0xFFFF) );
+
+    // when writing through the pool, the current block starts after all blocks still queued
+    uint64_t blockAddress = m_blockAddress;
+    if ( m_threadPool && (m_device->Mode() == IBamIODevice::WriteOnly) ) {
+        for ( size_t i = 0; i < m_numJobsPending; ++i ) {
+            BgzfBlockJob* job = m_jobs[(m_jobsHead + i) % m_jobs.size()];
+            m_threadPool->Wait(job);
+            blockAddress += job->CompressedLength;
+        }
+    }
+    return ( (blockAddress << 16) | (m_blockOffset & 0xFFFF) );
 }
 
 // writes the supplied data into the BGZF buffer
@@ -471,7 +705,7 @@ size_t BgzfStream::Write(const char* data, const size_t dataLength) {
     // write blocks as needed til all data is written
     size_t numBytesWritten = 0;
     const char* input = data;
-    const size_t blockLength = Constants::BGZF_DEFAULT_BLOCK_SIZE;
+    const size_t blockLength = Constants::BGZF_WRITE_BLOCK_SIZE;
     while ( numBytesWritten < dataLength ) {
 
         // copy data contents to uncompressed output buffer
@@ -492,3 +726,38 @@ size_t BgzfStream::Write(const char* data, const size_t dataLength) {
     // return actual number of bytes written
     return numBytesWritten;
 }
+
+// waits for the oldest queued block to be compressed & writes it to device
+void BgzfStream::WriteQueuedBlock(void) {
+
+    // wait for the oldest block & release its slot
+    BgzfBlockJob* job = m_jobs[m_jobsHead];
+    m_threadPool->Wait(job);
+    m_jobsHead = (m_jobsHead + 1) % m_jobs.size();
+    --m_numJobsPending;
+
+    // check for worker error
+    if ( !job->ErrorString.empty() )
+        throw BamException("BgzfStream::FlushBlock", job->ErrorString);
+
+    // flush the data to our output device
+    const size_t blockLength = job->CompressedLength;
+    const int64_t numBytesWritten = m_device->Write(job->CompressedBlock.Buffer, blockLength);
+
+    // check for device error
+    if ( numBytesWritten < 0 ) {
+        const string message = string("device error: ") + m_device->GetErrorString();
+        throw BamException("BgzfStream::FlushBlock", message);
+    }
+
+    // check that we wrote expected numBytes
+    if ( numBytesWritten != static_cast<int64_t>(blockLength) ) {
+        stringstream s("");
+        s << "expected to write " << blockLength
+          << " bytes during flushing, but wrote " << numBytesWritten;
+        throw BamException("BgzfStream::FlushBlock", s.str());
+    }
+
+    // update block data
+    m_blockAddress += blockLength;
+}
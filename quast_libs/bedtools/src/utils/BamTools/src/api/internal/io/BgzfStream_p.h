@@ -26,10 +26,14 @@
 #include "api/BamAux.h"
 #include "api/IBamIODevice.h"
 #include <string>
+#include <vector>
 
 namespace BamTools {
 namespace Internal {
 
+class BgzfThreadPool;
+struct BgzfBlockJob;
+
 class BgzfStream {
 
     // constructor & destructor
@@ -53,6 +57,10 @@ class BgzfStream {
         void Seek(const int64_t& position);
         // sets IO device (closes previous, if any, but does not attempt to open)
         void SetIODevice(IBamIODevice* device);
+        // sets zlib compression level (0-9) used when writing compressed output
+        void SetCompressionLevel(const int level);
+        // sets number of threads used to (de)compress blocks in parallel (1 = serial)
+        void SetNumThreads(const int numThreads);
         // enable/disable compressed output
         void SetWriteCompressed(bool ok);
         // get file position in BGZF file
@@ -70,11 +78,31 @@ class BgzfStream {
         size_t InflateBlock(const size_t& blockLength);
         // reads a BGZF block
         void ReadBlock(void);
+        // reads the next raw (compressed) BGZF block from device into @buffer
+        bool ReadCompressedBlock(char* buffer, size_t& blockLength);
+
+        // read-ahead helpers (used when running with a thread pool)
+        void DiscardReadAhead(void);
+        void QueueReadAhead(void);
+        void ReadBlockAhead(void);
+        // pipelined write helpers (used when running with a thread pool)
+        void FlushQueuedBlocks(void);
+        void QueueWriteBlock(void);
+        void WriteQueuedBlock(void);
 
     // static 'utility' methods
     public:
         // checks BGZF block header
         static bool CheckBlockHeader(char* header);
+        // compresses data into a complete BGZF block, returns compressed length
+        static size_t DeflateBuffer(const char* uncompressed,
+                                    unsigned int& inputLength,
+                                    char* compressed,
+                                    const int compressionLevel);
+        // de-compresses a raw BGZF block into @uncompressed, returns uncompressed length
+        static size_t InflateBuffer(const char* compressed,
+                                    const size_t& blockLength,
+                                    char* uncompressed);
 
     // data members
     public:
@@ -83,10 +111,19 @@ class BgzfStream {
         uint64_t     m_blockAddress;
 
         bool m_isWriteCompressed;
+        int  m_compressionLevel;
         IBamIODevice* m_device;
 
         RaiiBuffer m_uncompressedBlock;
         RaiiBuffer m_compressedBlock;
+
+        // parallel (de)compression state
+        BgzfThreadPool* m_threadPool;
+        std::vector<BgzfBlockJob*> m_jobs;   // ring of blocks in flight
+        size_t  m_jobsHead;
+        size_t  m_numJobsPending;
+        bool    m_isReadAheadDone;
+        int64_t m_nextBlockAddress;
 };
 
 } // namespace Internal
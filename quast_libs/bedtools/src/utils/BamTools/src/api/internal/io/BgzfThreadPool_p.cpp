@@ -0,0 +1,127 @@
+// ***************************************************************************
+// BgzfThreadPool_p.cpp
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that (de)compress BGZF blocks, so that
+// BgzfStream can keep several blocks in flight while the caller consumes
+// them strictly in file order.
+// ***************************************************************************
+
+#include "api/BamConstants.h"
+#include "api/internal/io/BgzfStream_p.h"
+#include "api/internal/io/BgzfThreadPool_p.h"
+#include "api/internal/utils/BamException_p.h"
+using namespace BamTools;
+using namespace BamTools::Internal;
+
+using namespace std;
+
+// ---------------------------
+// BgzfBlockJob implementation
+// ---------------------------
+
+BgzfBlockJob::BgzfBlockJob(void)
+    : Type(Inflate)
+    , CompressionLevel(0)
+    , CompressedBlock(Constants::BGZF_MAX_BLOCK_SIZE)
+    , UncompressedBlock(Constants::BGZF_DEFAULT_BLOCK_SIZE)
+    , CompressedLength(0)
+    , UncompressedLength(0)
+    , BlockAddress(0)
+    , NextBlockAddress(0)
+    , IsDone(true)
+{ }
+
+// -----------------------------
+// BgzfThreadPool implementation
+// -----------------------------
+
+BgzfThreadPool::BgzfThreadPool(const int numThreads)
+    : m_isStopping(false)
+{
+    for ( int i = 0; i < numThreads; ++i )
+        m_threads.push_back( thread(&BgzfThreadPool::Run, this) );
+}
+
+BgzfThreadPool::~BgzfThreadPool(void) {
+
+    // wake up all workers & let them drain
+    {
+        lock_guard<mutex> lock(m_mutex);
+        m_isStopping = true;
+    }
+    m_jobAvailable.notify_all();
+
+    vector<thread>::iterator threadIter = m_threads.begin();
+    vector<thread>::iterator threadEnd  = m_threads.end();
+    for ( ; threadIter != threadEnd; ++threadIter )
+        threadIter->join();
+}
+
+int BgzfThreadPool::NumThreads(void) const {
+    return m_threads.size();
+}
+
+void BgzfThreadPool::ProcessJob(BgzfBlockJob* job) {
+    try {
+        if ( job->Type == BgzfBlockJob::Inflate )
+            job->UncompressedLength = BgzfStream::InflateBuffer(job->CompressedBlock.Buffer,
+                                                                job->CompressedLength,
+                                                                job->UncompressedBlock.Buffer);
+        else {
+            // BgzfStream::Write() never fills more than a single BGZF block can hold
+            unsigned int inputLength = job->UncompressedLength;
+            job->CompressedLength = BgzfStream::DeflateBuffer(job->UncompressedBlock.Buffer,
+                                                              inputLength,
+                                                              job->CompressedBlock.Buffer,
+                                                              job->CompressionLevel);
+            if ( inputLength != job->UncompressedLength )
+                throw BamException("BgzfStream::FlushBlock", "block does not fit into a single BGZF block");
+        }
+    } catch ( BamException& e ) {
+        job->ErrorString = e.what();
+    }
+}
+
+void BgzfThreadPool::Run(void) {
+
+    while ( true ) {
+
+        // wait for work
+        BgzfBlockJob* job = 0;
+        {
+            unique_lock<mutex> lock(m_mutex);
+            while ( m_queue.empty() && !m_isStopping )
+                m_jobAvailable.wait(lock);
+            if ( m_queue.empty() )
+                return;
+            job = m_queue.front();
+            m_queue.pop_front();
+        }
+
+        // do the actual (de)compression outside of the lock
+        ProcessJob(job);
+
+        // mark job as finished
+        {
+            lock_guard<mutex> lock(m_mutex);
+            job->IsDone = true;
+        }
+        m_jobDone.notify_all();
+    }
+}
+
+void BgzfThreadPool::Submit(BgzfBlockJob* job) {
+    {
+        lock_guard<mutex> lock(m_mutex);
+        job->IsDone = false;
+        job->ErrorString.clear();
+        m_queue.push_back(job);
+    }
+    m_jobAvailable.notify_one();
+}
+
+void BgzfThreadPool::Wait(BgzfBlockJob* job) {
+    unique_lock<mutex> lock(m_mutex);
+    while ( !job->IsDone )
+        m_jobDone.wait(lock);
+}
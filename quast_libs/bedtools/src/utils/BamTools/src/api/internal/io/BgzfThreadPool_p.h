@@ -0,0 +1,94 @@
+// ***************************************************************************
+// BgzfThreadPool_p.h
+// ---------------------------------------------------------------------------
+// Provides a pool of worker threads that (de)compress BGZF blocks, so that
+// BgzfStream can keep several blocks in flight while the caller consumes
+// them strictly in file order.
+// ***************************************************************************
+
+#ifndef BGZFTHREADPOOL_P_H
+#define BGZFTHREADPOOL_P_H
+
+//  -------------
+//  W A R N I N G
+//  -------------
+//
+// This file is not part of the BamTools API.  It exists purely as an
+// implementation detail. This header file may change from version to version
+// without notice, or even be removed.
+//
+// We mean it.
+
+#include "api/api_global.h"
+#include "api/BamAux.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace BamTools {
+namespace Internal {
+
+// a single BGZF block travelling between BgzfStream and the worker pool
+struct BgzfBlockJob {
+
+    // enums
+    enum JobType { Inflate = 0
+                 , Deflate
+                 };
+
+    // data members
+    JobType    Type;
+    int        CompressionLevel;
+    RaiiBuffer CompressedBlock;
+    RaiiBuffer UncompressedBlock;
+    size_t     CompressedLength;
+    size_t     UncompressedLength;
+    int64_t    BlockAddress;      // file offset of this block
+    int64_t    NextBlockAddress;  // file offset of the block that follows it
+    bool        IsDone;
+    std::string ErrorString;
+
+    // ctor
+    BgzfBlockJob(void);
+};
+
+class BgzfThreadPool {
+
+    // ctor & dtor
+    public:
+        BgzfThreadPool(const int numThreads);
+        ~BgzfThreadPool(void);
+
+    // BgzfThreadPool interface
+    public:
+        // returns number of worker threads
+        int NumThreads(void) const;
+        // queues @job for processing by the next free worker
+        void Submit(BgzfBlockJob* job);
+        // blocks until @job has been processed
+        void Wait(BgzfBlockJob* job);
+
+    // internal methods
+    private:
+        // processes a single job on the calling (worker) thread
+        static void ProcessJob(BgzfBlockJob* job);
+        // worker thread main loop
+        void Run(void);
+
+    // data members
+    private:
+        std::vector<std::thread>   m_threads;
+        std::deque<BgzfBlockJob*>  m_queue;
+        std::mutex                 m_mutex;
+        std::condition_variable    m_jobAvailable;
+        std::condition_variable    m_jobDone;
+        bool                       m_isStopping;
+};
+
+} // namespace Internal
+} // namespace BamTools
+
+#endif // BGZFTHREADPOOL_P_H
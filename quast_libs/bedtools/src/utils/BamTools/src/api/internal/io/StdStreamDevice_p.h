@@ -36,7 +36,7 @@ class StdStreamDevice : public IBamIODevice {
         bool Open(const IBamIODevice::OpenMode mode) { return true; } //stream is assumed opened by caller.
         int64_t Read(char* data, const unsigned int numBytes) {
         	m_stream->read(data, numBytes);
-        	return (int64_t)(numBytes);
+        	return (int64_t)(m_stream->gcount());
         }
         bool Seek(const int64_t& position, const int origin = SEEK_SET) { return false; }
 
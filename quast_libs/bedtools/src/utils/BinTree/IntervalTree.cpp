@@ -0,0 +1,181 @@
+#include "IntervalTree.h"
+#include "FileRecordMgr.h"
+#include <algorithm>
+
+
+IntervalTree::IntervalTree(ContextIntersect *context)
+:  _context(context),
+   _numLoaded(0)
+{
+}
+
+IntervalTree::~IntervalTree() {
+}
+
+void IntervalTree::loadDB()
+{
+	for (int i=0; i < _context->getNumDatabaseFiles(); i++) {
+		FileRecordMgr *databaseFile = _context->getDatabaseFile(i);
+
+		Record *record = NULL;
+		while (!databaseFile->eof()) {
+			record = databaseFile->getNextRecord();
+			//In addition to NULL records, we also don't want to add unmapped reads.
+			if (record == NULL || record->isUnmapped()) {
+				continue;
+			}
+
+			_context->testNameConventions(record);
+			addRecordToTree(record);
+		}
+	}
+	for (mainMapType::iterator iter = _mainMap.begin(); iter != _mainMap.end(); iter++) {
+		buildTree(iter->second);
+	}
+}
+
+void IntervalTree::getHits(Record *record, RecordKeyVector &hitSet)
+{
+	if (record->isUnmapped()) {
+		return;
+	}
+	mainMapType::iterator mainIter = _mainMap.find(record->getChrName());
+	if (mainIter == _mainMap.end()) {
+		//given chrom not even in map.
+		return;
+	}
+	const vector<nodeType> &nodes = mainIter->second.nodes;
+	int64_t numNodes = (int64_t)nodes.size();
+	int start = record->getStartPos();
+	int end = record->getEndPos();
+
+	//walk down from the root, skipping the subtrees that end before the
+	//query, and stopping at the nodes that start after it.
+	_hits.clear();
+	_stack.clear();
+	int maxLevel = mainIter->second.maxLevel;
+	stackItemType root = { ((int64_t)1 << maxLevel) - 1, maxLevel, false };
+	_stack.push_back(root);
+	while (!_stack.empty()) {
+		stackItemType item = _stack.back();
+		_stack.pop_back();
+
+		if (item.level <= LINEAR_SCAN_LEVEL) {
+			//small subtree: check every node in it.
+			int64_t firstIdx = item.idx >> item.level << item.level;
+			int64_t lastIdx = min(firstIdx + ((int64_t)1 << (item.level + 1)) - 1, numNodes);
+			for (int64_t i = firstIdx; i < lastIdx && nodes[i].start < end; i++) {
+				if (start < nodes[i].end) {
+					_hits.push_back(&nodes[i]);
+				}
+			}
+		} else if (!item.leftDone) {
+			//come back to this node after its left subtree. The left child
+			//may be past the end of the array, in which case it has to be
+			//walked to find the nodes below it that aren't.
+			int64_t leftIdx = item.idx - ((int64_t)1 << (item.level - 1));
+			item.leftDone = true;
+			_stack.push_back(item);
+			if (leftIdx >= numNodes || nodes[leftIdx].maxEnd > start) {
+				stackItemType left = { leftIdx, item.level - 1, false };
+				_stack.push_back(left);
+			}
+		} else if (item.idx < numNodes && nodes[item.idx].start < end) {
+			if (start < nodes[item.idx].end) {
+				_hits.push_back(&nodes[item.idx]);
+			}
+			stackItemType right = { item.idx + ((int64_t)1 << (item.level - 1)), item.level - 1, false };
+			_stack.push_back(right);
+		}
+	}
+
+	//keep the overlaps that meet the user's requests, which include
+	//(a) overlap fraction, (b) strandedness, (c) reciprocal overlap
+	int numHits = 0;
+	for (int i = 0; i < (int)_hits.size(); i++) {
+		if (record->intersects(_hits[i]->record,
+							   _context->getSameStrand(),
+							   _context->getDiffStrand(),
+							   _context->getOverlapFractionA(),
+							   _context->getOverlapFractionB(),
+							   _context->getReciprocalFraction(),
+							   _context->getEitherFraction()
+							  )
+			)
+		{
+			_hits[numHits++] = _hits[i];
+		}
+	}
+	_hits.resize(numHits);
+	if (numHits > 1) {
+		sort(_hits.begin(), _hits.end(), hitOrderLess());
+	}
+	for (int i = 0; i < numHits; i++) {
+		hitSet.push_back(_hits[i]->record);
+	}
+	if (_context->getSortOutput()) {
+		hitSet.sortVector();
+	}
+}
+
+void IntervalTree::addRecordToTree(Record *record)
+{
+	nodeType node;
+	node.start = record->getStartPos();
+	node.end = record->getEndPos();
+	node.maxEnd = node.end;
+	node.binOrder = getBinOrder(node.start, node.end);
+	node.loadIdx = _numLoaded++;
+	node.record = record;
+	_mainMap[record->getChrName()].nodes.push_back(node);
+}
+
+void IntervalTree::buildTree(chromTreeType &tree)
+{
+	vector<nodeType> &nodes = tree.nodes;
+	sort(nodes.begin(), nodes.end(), nodeStartLess());
+	int64_t numNodes = (int64_t)nodes.size();
+
+	//the leaves are the even indices. Nodes past the end of the array are
+	//left out, and a node whose right subtree runs past the end takes the
+	//largest end of the last node actually in it.
+	int64_t lastIdx = 0;
+	int lastMaxEnd = 0;
+	for (int64_t i = 0; i < numNodes; i += 2) {
+		lastIdx = i;
+		lastMaxEnd = nodes[i].maxEnd = nodes[i].end;
+	}
+	int level = 1;
+	for (; ((int64_t)1 << level) <= numNodes; level++) {
+		int64_t childOffset = (int64_t)1 << (level - 1);
+		int64_t firstIdx = (childOffset << 1) - 1;
+		int64_t step = childOffset << 2;
+		for (int64_t i = firstIdx; i < numNodes; i += step) {
+			int leftMaxEnd = nodes[i - childOffset].maxEnd;
+			int rightMaxEnd = i + childOffset < numNodes ? nodes[i + childOffset].maxEnd : lastMaxEnd;
+			nodes[i].maxEnd = max(nodes[i].end, max(leftMaxEnd, rightMaxEnd));
+		}
+		//move the last node up to its parent.
+		lastIdx = ((lastIdx >> level) & 1) ? lastIdx - childOffset : lastIdx + childOffset;
+		if (lastIdx < numNodes && nodes[lastIdx].maxEnd > lastMaxEnd) {
+			lastMaxEnd = nodes[lastIdx].maxEnd;
+		}
+	}
+	tree.maxLevel = level - 1;
+}
+
+//The level and number of the smallest UCSC bin holding the record, as the
+//BinTree stored it. Its queries went through the levels from the finest
+//up, and through each level's bins by position.
+int IntervalTree::getBinOrder(int start, int end)
+{
+	int64_t binStart = max(start, 0);
+	int64_t binEnd = max((int64_t)end - 1, binStart);
+	int level = 0;
+	int shift = _binFirstShift;
+	while ((binStart >> shift) != (binEnd >> shift)) {
+		level++;
+		shift += _binNextShift;
+	}
+	return (level << 18) | (int)(binStart >> shift);
+}
@@ -0,0 +1,96 @@
+/*
+ * IntervalTree.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef INTERVALTREE_H_
+#define INTERVALTREE_H_
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include "RecordKeyVector.h"
+#include "ContextIntersect.h"
+
+using namespace std;
+
+class FileRecordMgr;
+class Record;
+
+//Index of the database records for unsorted input, in place of the BinTree.
+//Each chrom keeps its records in one array sorted by start, laid out as an
+//implicit binary tree: the node at index i is on the level given by the
+//number of trailing 1 bits of i, and stores the largest end in its subtree.
+//A query then visits O(log n + k) nodes of one contiguous array, and works
+//for chroms of any length.
+//
+//Hits are reported in the order the BinTree reported them (by UCSC bin,
+//then load order), so the output doesn't change.
+class IntervalTree {
+public:
+	IntervalTree(ContextIntersect *context);
+
+	~IntervalTree();
+	void loadDB();
+	void getHits(Record *record, RecordKeyVector &hitSet);
+
+private:
+
+	ContextIntersect *_context;
+
+	typedef struct {
+		int start;
+		int end;
+		int maxEnd; //largest end in the subtree of this node
+		int binOrder; //UCSC bin level and number, to order the hits
+		size_t loadIdx;
+		Record *record;
+	} nodeType;
+
+	typedef struct {
+		vector<nodeType> nodes;
+		int maxLevel;
+	} chromTreeType;
+
+	typedef map<string, chromTreeType> mainMapType;
+	mainMapType _mainMap;
+	size_t _numLoaded;
+
+	//a subtree still to be visited by a query.
+	typedef struct {
+		int64_t idx;
+		int level;
+		bool leftDone;
+	} stackItemType;
+	vector<stackItemType> _stack;
+	vector<const nodeType *> _hits;
+
+	//at this level or below, scan the subtree instead of walking it.
+	static const int LINEAR_SCAN_LEVEL = 3;
+
+	//same bins as the BinTree: 16Kbp at the finest level, 8 times larger
+	//for each level up.
+	static const int _binFirstShift = 14;
+	static const int _binNextShift = 3;
+
+	void addRecordToTree(Record *record);
+	void buildTree(chromTreeType &tree);
+	static int getBinOrder(int start, int end);
+
+	struct nodeStartLess {
+		bool operator()(const nodeType &a, const nodeType &b) const {
+			return a.start < b.start || (a.start == b.start && a.loadIdx < b.loadIdx);
+		}
+	};
+	struct hitOrderLess {
+		bool operator()(const nodeType *a, const nodeType *b) const {
+			return a->binOrder < b->binOrder || (a->binOrder == b->binOrder && a->loadIdx < b->loadIdx);
+		}
+	};
+};
+
+
+#endif /* INTERVALTREE_H_ */
@@ -10,6 +10,8 @@
 #include <sys/types.h>
 #include <cctype>
 
+atomic<bool> ContextBase::_nameConventionWarningGiven(false);
+
 ContextBase::ContextBase()
 :
   _program(UNSPECIFIED_PROGRAM),
@@ -21,6 +23,8 @@ ContextBase::ContextBase()
   _showHelp(false),
   _obeySplits(false),
   _uncompressedBam(false),
+  _bamCompressionLevel(-1),
+  _numThreads(1),
   _useBufferedOutput(true),
   _ioBufSize(0),
   _anyHit(false),
@@ -200,6 +204,12 @@ bool ContextBase::parseCmdArgs(int argc, char **argv, int skipFirstArgs) {
         else if (strcmp(_argv[_i], "-ubam") == 0) {
 			if (!handle_ubam()) return false;
         }
+        else if (strcmp(_argv[_i], "-bamlevel") == 0) {
+			if (!handle_bamlevel()) return false;
+        }
+        else if (strcmp(_argv[_i], "-threads") == 0) {
+			if (!handle_threads()) return false;
+        }
         else if (strcmp(_argv[_i], "-fbam") == 0) {
 			if (!handle_fbam()) return false;
         }
@@ -342,7 +352,11 @@ bool ContextBase::openFiles() {
 		frm->setFullBamFlags(_useFullBamTags);
 		frm->setIsSorted(_sortedInput);
 		frm->setIoBufSize(_ioBufSize);
+		frm->setNumThreads(_numThreads);
 		frm->setIsGroupBy(_program == GROUP_BY);
+		if (i < (int)_fileByteRanges.size()) {
+			frm->setByteRange(_fileByteRanges[i].first, _fileByteRanges[i].second);
+		}
 		if (!frm->open(_inheader)) {
 			return false;
 		}
@@ -507,6 +521,40 @@ bool ContextBase::handle_ubam()
 	return true;
 }
 
+bool ContextBase::handle_bamlevel()
+{
+	if (_argc <= _i+1 || !isInteger(_argv[_i+1])) {
+		_errorMsg = "\n***** ERROR: -bamlevel option given, but no compression level (-1 to 9) specified. *****";
+		return false;
+	}
+	_bamCompressionLevel = str2chrPos(_argv[_i+1]);
+	if (_bamCompressionLevel < -1 || _bamCompressionLevel > 9) {
+		_errorMsg = "\n***** ERROR: -bamlevel must be between -1 and 9 (-1 is the zlib default). *****";
+		return false;
+	}
+	markUsed(_i - _skipFirstArgs);
+	_i++;
+	markUsed(_i - _skipFirstArgs);
+	return true;
+}
+
+bool ContextBase::handle_threads()
+{
+	if (_argc <= _i+1 || !isInteger(_argv[_i+1])) {
+		_errorMsg = "\n***** ERROR: -threads option given, but number of threads not specified. *****";
+		return false;
+	}
+	_numThreads = str2chrPos(_argv[_i+1]);
+	if (_numThreads < 1) {
+		_errorMsg = "\n***** ERROR: -threads must be at least 1. *****";
+		return false;
+	}
+	markUsed(_i - _skipFirstArgs);
+	_i++;
+	markUsed(_i - _skipFirstArgs);
+	return true;
+}
+
 
 // Methods specific to column operations.
 // for col ops, -c is the string of columns upon which to operate
@@ -684,7 +732,7 @@ bool ContextBase::parseIoBufSize(string bufStr)
 void ContextBase::testNameConventions(const Record *record) {
 	//Do nothing if using the -nonamecheck option,
 	//warning already given, or record is unmapped BAM record
-	if (getNameCheckDisabled() || _nameConventionWarningTripped || record->isUnmapped()) return;
+	if (getNameCheckDisabled() || _nameConventionWarningTripped || _nameConventionWarningGiven || record->isUnmapped()) return;
 
 	int fileIdx = record->getFileIdx();
 
@@ -774,6 +822,7 @@ void ContextBase::setErrorMsg(string &msg, bool onlyWarn, const Record * record,
 
 void ContextBase::nameConventionWarning(const Record *record, const string &filename, const string &message)
 {
+	 if (_nameConventionWarningGiven.exchange(true)) return;
 	 _nameConventionWarningMsg = "***** WARNING: File ";
 	 _nameConventionWarningMsg.append(filename);
 	 _nameConventionWarningMsg.append(message);
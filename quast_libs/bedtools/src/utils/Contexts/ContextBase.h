@@ -25,6 +25,7 @@
 #include "api/BamReader.h"
 #include "api/BamAux.h"
 #include "KeyListOps.h"
+#include <atomic>
 
 
 class ContextBase {
@@ -93,6 +94,17 @@ public:
     bool getUncompressedBam() const { return _uncompressedBam; }
     void setUncompressedBam(bool val) { _uncompressedBam = val; }
 
+    //zlib level for compressed BAM output, -1 means zlib default.
+    int getBamCompressionLevel() const { return _bamCompressionLevel; }
+    void setBamCompressionLevel(int val) { _bamCompressionLevel = val; }
+
+    int getNumThreads() const { return _numThreads; }
+    void setNumThreads(int val) { _numThreads = val; }
+
+    //read input file i only in the bytes ranges[i] (see FileRecordMgr::setByteRange).
+    //Must be called before testCmdArgs opens the files.
+    void setFileByteRanges(const vector<pair<int64_t, int64_t> > &ranges) { _fileByteRanges = ranges; }
+
     bool getUseBufferedOutput() const { return _useBufferedOutput; }
     void setUseBufferedOutput(bool val) { _useBufferedOutput = val; }
 
@@ -159,6 +171,7 @@ protected:
 
 	vector<string> _fileNames;
 	vector<FileRecordMgr *> _files;
+	vector<pair<int64_t, int64_t> > _fileByteRanges;
 	bool _allFilesOpened;
 	map<string, PROGRAM_TYPE> _programNames;
 	string _origProgramName;
@@ -177,6 +190,8 @@ protected:
 	bool _showHelp;
     bool _obeySplits;
     bool _uncompressedBam;
+    int _bamCompressionLevel;
+    int _numThreads;
     bool _useBufferedOutput;
     int _ioBufSize;
 
@@ -279,6 +294,8 @@ protected:
 	virtual bool handle_split();
 	virtual bool handle_sorted();
 	virtual bool handle_ubam();
+	virtual bool handle_bamlevel();
+	virtual bool handle_threads();
 
 	virtual bool handle_c();
 	virtual bool handle_o();
@@ -296,6 +313,8 @@ protected:
     //Warning messages.
    bool _nameConventionWarningTripped;
    string _nameConventionWarningMsg;
+   //the warning is given once per run, also when several contexts sweep parts of the input.
+   static atomic<bool> _nameConventionWarningGiven;
    void nameConventionWarning(const Record *record, const string &filename, const string &message);
 
     //give warning but continue.
@@ -267,6 +267,10 @@ void FastaReference::open(string reffilename, bool usemmap, bool useFullHeader)
         filesize = sb.st_size;
         // map the whole file
         filemm = mmap(NULL, filesize, PROT_READ, MAP_SHARED, fd, 0);
+        if (filemm == MAP_FAILED) {
+            // fall back to reading the file
+            usingmmap = false;
+        }
     }
 }
 
@@ -316,30 +320,44 @@ string FastaReference::getSubSequence(string seqname, int start, int length) {
         cerr << "Error: cannot construct subsequence with negative offset or length < 1" << endl;
         exit(1);
     }
-    // we have to handle newlines
-    // approach: count newlines before start
-    //           count newlines by end of read
-    //             subtracting newlines before start find count of embedded newlines
-    int newlines_before = start > 0 ? (start - 1) / entry.line_blen : 0;
-    int newlines_by_end = (start + length - 1) / entry.line_blen;
-    int newlines_inside = newlines_by_end - newlines_before;
-    int seqlen = length + newlines_inside;
-    char* seq = (char*) calloc (seqlen + 1, sizeof(char));
+    string s;
+    appendSubSequence(entry, start, length, s);
+    return s;
+}
+
+void FastaReference::appendSubSequence(const FastaIndexEntry& entry, int start, int length, string& seq) const {
+    int end = min(start + length, entry.length);
+    if (start >= end)
+        return;
+    // the bytes from the first base to the last one, newlines included
+    long long firstByte = entry.offset + (long long) (start / entry.line_blen) * entry.line_len + start % entry.line_blen;
+    long long lastByte = entry.offset + (long long) ((end - 1) / entry.line_blen) * entry.line_len + (end - 1) % entry.line_blen;
+    size_t spanLength = lastByte - firstByte + 1;
+    const char* span;
+    vector<char> buffer;
     if (usingmmap) {
-        memcpy(seq, (char*) filemm + entry.offset + newlines_before + start, seqlen);
+        span = (const char*) filemm + firstByte;
     } else {
-        fseek64(file, (off_t) (entry.offset + newlines_before + start), SEEK_SET);
-        fread(seq, sizeof(char), (off_t) seqlen, file);
+        // pread leaves the file position alone, unlike fseek + fread
+        buffer.resize(spanLength);
+        if (pread(fileno(file), &buffer[0], spanLength, (off_t) firstByte) != (ssize_t) spanLength) {
+            cerr << "could not read " << filename << endl;
+            exit(1);
+        }
+        span = &buffer[0];
+    }
+    size_t seqStart = seq.size();
+    seq.resize(seqStart + (end - start));
+    char* out = &seq[seqStart];
+    int lineOffset = start % entry.line_blen;
+    for (int pos = start; pos < end; ) {
+        int chunk = min(entry.line_blen - lineOffset, end - pos);
+        memcpy(out, span, chunk);
+        out += chunk;
+        pos += chunk;
+        span += chunk + (entry.line_len - entry.line_blen);
+        lineOffset = 0;
     }
-    seq[seqlen] = '\0';
-    char* pbegin = seq;
-    char* pend = seq + (seqlen/sizeof(char));
-    pend = remove(pbegin, pend, '\n');
-    pend = remove(pbegin, pend, '\0');
-    string s = seq;
-    free(seq);
-    s.resize((pend - pbegin)/sizeof(char));
-    return s;
 }
 
 long unsigned int FastaReference::sequenceLength(string seqname) {
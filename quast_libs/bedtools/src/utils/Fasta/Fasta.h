@@ -77,6 +77,10 @@ class FastaReference {
         // potentially useful for performance, investigate
         // void getSequence(string seqname, string& sequence);
         string getSubSequence(string seqname, int start, int length);
+        // appends [start, start + length) of the sequence to seq, copying it
+        // line by line from the mapping (or a single read) without the newlines.
+        // safe to call from several threads at once.
+        void appendSubSequence(const FastaIndexEntry& entry, int start, int length, string& seq) const;
         string sequenceNameStartingWith(string seqnameStart);
         long unsigned int sequenceLength(string seqname);
 };
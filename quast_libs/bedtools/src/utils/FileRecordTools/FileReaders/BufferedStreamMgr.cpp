@@ -18,7 +18,10 @@ BufferedStreamMgr::BufferedStreamMgr(const string &filename)
   	_mainBufCurrLen(0),
   	_eof(false),
   	_useBufSize(DEFAULT_MAIN_BUF_READ_SIZE),
-  	_streamFinished(false)
+  	_streamFinished(false),
+  	_rangeStart(-1),
+  	_rangeEnd(-1),
+  	_numThreads(1)
 {
 
 }
@@ -36,6 +39,10 @@ BufferedStreamMgr::~BufferedStreamMgr()
 bool BufferedStreamMgr::init()
 {
 	_inputStreamMgr = new InputStreamMgr(_filename);
+	if (_rangeStart >= 0) {
+		_inputStreamMgr->setByteRange(_rangeStart, _rangeEnd);
+	}
+	_inputStreamMgr->setNumThreads(_numThreads);
 	if (!_inputStreamMgr->init()) {
 		return false;
 	}
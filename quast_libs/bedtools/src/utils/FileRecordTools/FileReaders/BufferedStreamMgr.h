@@ -27,6 +27,8 @@ public:
 	BamTools::BamReader *getBamReader() { return _inputStreamMgr->getBamReader(); }
 	static const int DEFAULT_MAIN_BUF_READ_SIZE = 1023;
 	void setIoBufSize(int val) { _useBufSize = val; }
+	void setByteRange(int64_t start, int64_t end) { _rangeStart = start; _rangeEnd = end; }
+	void setNumThreads(int numThreads) { _numThreads = numThreads; }
 private:
 	InputStreamMgr *_inputStreamMgr;
 	typedef unsigned char bufType;
@@ -41,6 +43,9 @@ private:
 	int _useBufSize;
 	bool _streamFinished;
 	string _currScanBuffer;
+	int64_t _rangeStart;
+	int64_t _rangeEnd;
+	int _numThreads;
 
 	//The minus ones in these constants are for leaving room for a null terminator after reading into buffers.
 	static const int GZIP_LINE_BUF_SIZE = 8191; // 8K
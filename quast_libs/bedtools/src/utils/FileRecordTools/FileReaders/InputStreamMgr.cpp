@@ -18,6 +18,7 @@ InputStreamMgr::InputStreamMgr(const string &filename, bool buildScanBuffer)
  _pushBackStreamBuf(NULL),
  _inputFileStream(NULL),
  _infStreamBuf(NULL),
+ _readAheadStreamBuf(NULL),
  _oldInputStream(NULL),
  _isStdin(false),
  _isGzipped(false),
@@ -29,13 +30,21 @@ InputStreamMgr::InputStreamMgr(const string &filename, bool buildScanBuffer)
  _numBytesInBuffer(0),
  _bamReader(NULL),
  _bgStream(NULL),
- _eofHit(false)
+ _eofHit(false),
+ _rangeStart(-1),
+ _rangeEnd(-1),
+ _rangeLeft(-1),
+ _numThreads(1)
 {
 	_possibleBamCode.resize(4, 0);
 }
 
 
 InputStreamMgr::~InputStreamMgr() {
+	//stop the background inflating before its source goes away.
+	delete _readAheadStreamBuf;
+	_readAheadStreamBuf = NULL;
+
 	delete _pushBackStreamBuf;
 	_pushBackStreamBuf = NULL;
 
@@ -122,7 +131,13 @@ int InputStreamMgr::read(char *data, size_t dataSize)
 	if (_isBgzipped) {
 		return (int)(origRead + _bgStream->Read(data, dataSize));
 	}
+	if (_rangeLeft >= 0 && (int64_t)dataSize > _rangeLeft) {
+		dataSize = _rangeLeft;
+	}
 	_finalInputStream->read(data, dataSize);
+	if (_rangeLeft >= 0) {
+		_rangeLeft -= _finalInputStream->gcount();
+	}
 	return origRead + _finalInputStream->gcount();
 }
 
@@ -216,6 +231,7 @@ bool InputStreamMgr::detectBamOrBgzip(int &numChars, int currChar)
 				//Alter the finalInputSream to become a bgzfReader.
 				_bgStream = new BamTools::Internal::BgzfStream();
 				_bgStream->OpenStream(_finalInputStream, BamTools::IBamIODevice::ReadOnly);
+				_bgStream->SetNumThreads(_numThreads);
 
 				return false;
 			}
@@ -236,7 +252,12 @@ bool InputStreamMgr::detectBamOrBgzip(int &numChars, int currChar)
 			_infStreamBuf = new InflateStreamBuf(_finalInputStream);
 			delete _oldInputStream;
 			_oldInputStream = _finalInputStream;
-			_finalInputStream = new istream(_infStreamBuf);
+			if (_numThreads > 1) {
+				_readAheadStreamBuf = new ReadAheadStreamBuf(_infStreamBuf);
+				_finalInputStream = new istream(_readAheadStreamBuf);
+			} else {
+				_finalInputStream = new istream(_infStreamBuf);
+			}
 			return false;
 		}
 	}
@@ -266,6 +287,10 @@ bool InputStreamMgr::resetStream()
 		//For non-compressed, non-stdin file input, just re-open the file.
 		delete _finalInputStream;
 		_finalInputStream = new ifstream(_filename.c_str());
+		if (_rangeStart >= 0) {
+			_finalInputStream->seekg(_rangeStart);
+			_rangeLeft = _rangeEnd - _rangeStart;
+		}
 		return true;
 	}
 	return false;
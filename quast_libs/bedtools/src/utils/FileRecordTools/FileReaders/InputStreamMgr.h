@@ -10,6 +10,7 @@
 
 #include "PushBackStreamBuf.h"
 #include "InflateStreamBuf.h"
+#include "ReadAheadStreamBuf.h"
 #include "string.h"
 #include "api/BamReader.h"
 #include "api/internal/io/BgzfStream_p.h"
@@ -43,6 +44,14 @@ public:
 	bool resetStream();
 	bool getEofHit() { return _eofHit; }
 
+	//Only read the bytes [start, end) of a plain file once its type is known.
+	//The range must start at a line. Must be called before init.
+	void setByteRange(int64_t start, int64_t end) { _rangeStart = start; _rangeEnd = end; }
+
+	//Threads for compressed input: BGZF blocks are inflated in parallel, and
+	//plain gzip is inflated on a background thread. Must be called before init.
+	void setNumThreads(int numThreads) { _numThreads = numThreads; }
+
 private:
 	string _filename;
 	PushBackStreamBuf *_pushBackStreamBuf;
@@ -50,6 +59,7 @@ private:
 	BTlist<int> _scanBuffer;
 	string _saveDataStr;
 	InflateStreamBuf *_infStreamBuf;
+	ReadAheadStreamBuf *_readAheadStreamBuf;
 	istream * _finalInputStream;
 	istream *_oldInputStream;
 	bool _isStdin;
@@ -67,6 +77,10 @@ private:
 	BamTools::BamReader *_bamReader;
 	BamTools::Internal::BgzfStream *_bgStream;
 	bool _eofHit;
+	int64_t _rangeStart;
+	int64_t _rangeEnd;
+	int64_t _rangeLeft; //bytes left to read in the range, or -1 if the whole file is read.
+	int _numThreads;
 
 	static const char *FIFO_STRING_LITERAL;
 	bool readZipChunk();
@@ -85,9 +85,11 @@ void SingleLineDelimTextFileReader::getField(int fieldNum, string &str) const {
 
 
 void SingleLineDelimTextFileReader::getField(int fieldNum, int &val) const {
-	string temp;
-	getField(fieldNum, temp);
-	val = str2chrPos(temp.c_str());
+	int startPos = _delimPositions[fieldNum] +1;
+	int endPos = _delimPositions[fieldNum+1];
+	//parse in place. str2chrPos takes a zero length as "until the null",
+	//so an empty field is passed as an empty string to get its error.
+	val = endPos > startPos ? str2chrPos(_sLine.c_str() + startPos, endPos - startPos) : str2chrPos("");
 }
 
 void SingleLineDelimTextFileReader::getField(int fieldNum, char &val) const {
@@ -3,6 +3,7 @@
 #include "FreeList.h"
 #include "Record.h"
 #include "NewGenomeFile.h"
+#include "ChromIdLookup.h"
 
 FileRecordMgr::FileRecordMgr(const string &filename)
 : _fileIdx(-1),
@@ -17,6 +18,7 @@ FileRecordMgr::FileRecordMgr(const string &filename)
   _useFullBamTags(false),
   _prevStart(INT_MAX),
   _prevChromId(-1),
+  _prevNameId(-1),
   _mustBeForward(false),
   _mustBeReverse(false),
   _totalRecordLength(0),
@@ -27,7 +29,10 @@ FileRecordMgr::FileRecordMgr(const string &filename)
   _genomeFile(NULL),
   _ioBufSize(0),
   _noEnforceCoordSort(false),
-  _isGroupBy(false)
+  _isGroupBy(false),
+  _byteRangeStart(-1),
+  _byteRangeEnd(-1),
+  _numThreads(1)
  {
 }
 
@@ -43,6 +48,8 @@ bool FileRecordMgr::open(bool inheader){
 	_bufStreamMgr->getTypeChecker().setInHeader(inheader);
 
 	if (_ioBufSize > 0) _bufStreamMgr->setIoBufSize(_ioBufSize);
+	if (_byteRangeStart >= 0) _bufStreamMgr->setByteRange(_byteRangeStart, _byteRangeEnd);
+	_bufStreamMgr->setNumThreads(_numThreads);
 	
 	if (_isGroupBy) {
 		_bufStreamMgr->getTypeChecker().setIsGroupBy(true);
@@ -146,6 +153,12 @@ Record *FileRecordMgr::getNextRecord(RecordKeyVector *keyList)
 
 void FileRecordMgr::assignChromId(Record *record) {
 	const string &currChrom = record->getChrName();
+	if (_prevNameId == -1 || currChrom != _prevNameChrom) {
+		_prevNameChrom = currChrom;
+		_prevNameId = ChromIdLookup::getId(currChrom);
+	}
+	record->setChrNameId(_prevNameId);
+
 	if (currChrom != _prevChrom  && _hasGenomeFile) {
 		_prevChromId = _genomeFile->getChromId(currChrom);
 		record->setChromId(_prevChromId);
@@ -107,6 +107,13 @@ public:
 	void setNoEnforceCoordSort(bool val) { _noEnforceCoordSort = val; }
 	void setIsGroupBy(bool val) { _isGroupBy = val; }
 
+	//Only read the records in the bytes [start, end) of an uncompressed text file,
+	//which must start at a line. Must be called before the file is opened.
+	void setByteRange(int64_t start, int64_t end) { _byteRangeStart = start; _byteRangeEnd = end; }
+	//threads used to inflate compressed text input.
+	void setNumThreads(int numThreads) { _numThreads = numThreads; }
+	char getDelimChar() const { return _bufStreamMgr->getTypeChecker().getDelimChar(); }
+
 protected:
 	int _fileIdx;
 	string _filename;
@@ -126,6 +133,9 @@ protected:
 	int _prevStart;
 	int _prevChromId;
 
+	//last interned chrom name, so sorted input only looks up each chrom once.
+	string _prevNameChrom;
+	int _prevNameId;
 
 	bool _mustBeForward;
 	bool _mustBeReverse;
@@ -141,6 +151,9 @@ protected:
 	int _ioBufSize;
 	bool _noEnforceCoordSort; //only true for GroupBy
 	bool _isGroupBy; //hopefully also only true for GroupBy
+	int64_t _byteRangeStart;
+	int64_t _byteRangeEnd;
+	int _numThreads;
 
 	void allocateFileReader(bool inheader=false);
 	void testInputSortOrder(Record *record);
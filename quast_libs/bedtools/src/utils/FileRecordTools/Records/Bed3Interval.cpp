@@ -33,24 +33,16 @@ bool Bed3Interval::initFromFile(SingleLineDelimTextFileReader *fileReader)
 
 void Bed3Interval::print(string &outBuf) const
 {
-	ostringstream s;
-	s << _chrName;
-	s << "\t";
-	s << _startPos;
-	s << "\t";
-	s << _endPos;
-	outBuf.append(s.str());
+	Bed3Interval::print(outBuf, _startPos, _endPos);
 }
 
 void Bed3Interval::print(string &outBuf, int start, int end) const
 {
-	ostringstream s;
-	s << _chrName;
-	s << "\t";
-	s << start;
-	s << "\t";
-	s << end;
-	outBuf.append(s.str());
+	outBuf.append(_chrName);
+	outBuf.append("\t");
+	int2str(start, outBuf, true);
+	outBuf.append("\t");
+	int2str(end, outBuf, true);
 }
 
 void Bed3Interval::print(string &outBuf, const string & start, const string & end) const
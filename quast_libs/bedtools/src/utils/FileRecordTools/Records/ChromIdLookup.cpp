@@ -0,0 +1,21 @@
+/*
+ * ChromIdLookup.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "ChromIdLookup.h"
+
+map<string, int> ChromIdLookup::_ids;
+mutex ChromIdLookup::_idsMutex;
+
+int ChromIdLookup::getId(const string &chrName) {
+	lock_guard<mutex> lock(_idsMutex);
+	map<string, int>::iterator iter = _ids.find(chrName);
+	if (iter != _ids.end()) {
+		return iter->second;
+	}
+	int id = (int)_ids.size();
+	_ids.insert(pair<string, int>(chrName, id));
+	return id;
+}
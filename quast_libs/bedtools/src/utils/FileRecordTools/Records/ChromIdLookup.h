@@ -0,0 +1,28 @@
+/*
+ * ChromIdLookup.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CHROMIDLOOKUP_H_
+#define CHROMIDLOOKUP_H_
+
+#include <string>
+#include <map>
+#include <mutex>
+
+using namespace std;
+
+//Interns chromosome names into small integer ids shared by every input file,
+//so records without a genome file can compare chromosomes without comparing
+//strings. Ids only tell whether two names are equal, not their sort order.
+class ChromIdLookup {
+public:
+	static int getId(const string &chrName);
+
+private:
+	static map<string, int> _ids;
+	static mutex _idsMutex;
+};
+
+#endif /* CHROMIDLOOKUP_H_ */
@@ -52,35 +52,21 @@ bool GffRecord::initFromFile(SingleLineDelimTextFileReader *fileReader)
 
 void GffRecord::print(string &outBuf) const
 {
-	ostringstream s;	
-	s << _chrName;
-	s << "\t";
-	s << _source;
-	s << "\t";
-	s << _name;
-	s << "\t";
-	s << _startPosStr;
-	s << "\t";
-	s << _endPosStr;
-	s << "\t";
-	outBuf.append(s.str());
-	printRemainingFields(outBuf);
+	GffRecord::print(outBuf, _startPosStr, _endPosStr);
 }
 
 void GffRecord::print(string &outBuf, int start, int end) const
 {
-	ostringstream s;	
-	s << _chrName;
-	s << "\t";
-	s << _source;
-	s << "\t";
-	s << _name;
-	s << "\t";
-	s << start;
-	s << "\t";
-	s << end;
-	s << "\t";
-	outBuf.append(s.str());
+	outBuf.append(_chrName);
+	outBuf.append("\t");
+	outBuf.append(_source);
+	outBuf.append("\t");
+	outBuf.append(_name);
+	outBuf.append("\t");
+	int2str(start, outBuf, true);
+	outBuf.append("\t");
+	int2str(end, outBuf, true);
+	outBuf.append("\t");
 	printRemainingFields(outBuf);
 }
 
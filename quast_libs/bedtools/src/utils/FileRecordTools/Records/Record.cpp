@@ -4,6 +4,7 @@
 Record::Record()
 : _fileIdx(-1),
   _chrId(-1),
+  _chrNameId(-1),
   _startPos(-1),
   _endPos(-1),
   _strandVal(UNKNOWN),
@@ -24,6 +25,7 @@ const Record &Record::operator=(const Record &other)
 	_fileIdx = other._fileIdx;
 	_chrName = other._chrName;
 	_chrId = other._chrId;
+	_chrNameId = other._chrNameId;
 	_startPos = other._startPos;
 	_endPos = other._endPos;
 	_strand = other._strand;
@@ -36,6 +38,7 @@ void Record::clear() {
 	_fileIdx = -1;
 	_chrName.clear();
 	_chrId = -1;
+	_chrNameId = -1;
 	_startPos = -1;
 	_endPos = -1;
 	_name.clear();
@@ -108,7 +111,13 @@ bool Record::greaterThan(const Record *other) const
 }
 
 bool Record::sameChrom(const Record *other) const {
-	return (_chrId == -1 || other->_chrId == -1) ? ( _chrName == other->_chrName) : (_chrId == other->_chrId);
+	if (_chrId == -1 || other->_chrId == -1) {
+		if (_chrNameId != -1 && other->_chrNameId != -1) {
+			return _chrNameId == other->_chrNameId;
+		}
+		return _chrName == other->_chrName;
+	}
+	return _chrId == other->_chrId;
 }
 
 bool Record::chromBefore(const Record *other) const
@@ -17,7 +17,6 @@ using namespace std;
 
 class FileRecordMgr;
 class FileReader;
-class ChromIdLookup;
 
 class Record {
 public:
@@ -47,8 +46,12 @@ public:
 	virtual bool isValid() const { return _isValidHit; }
 
 	virtual const string &getChrName() const { return _chrName; }
-	virtual void setChrName(const string &chr) { _chrName = chr; }
-	virtual void setChrName(const char *chr) { _chrName = chr; }
+	virtual void setChrName(const string &chr) { _chrName = chr; _chrNameId = -1; }
+	virtual void setChrName(const char *chr) { _chrName = chr; _chrNameId = -1; }
+
+	//interned id of the chrom name (see ChromIdLookup), or -1 if not assigned.
+	int getChrNameId() const { return _chrNameId; }
+	void setChrNameId(int id) { _chrNameId = id; }
 
 	virtual int getFileIdx() const { return _fileIdx; }
 	virtual void setFileIdx(int fileIdx) { _fileIdx = fileIdx; }
@@ -165,6 +168,7 @@ protected:
 	int _fileIdx; //associated file the record came from
 	string _chrName;
 	int _chrId;
+	int _chrNameId;
 	int _startPos;
 	int _endPos;
 	//It is actually faster to also store the start and end positions as their original strings than to
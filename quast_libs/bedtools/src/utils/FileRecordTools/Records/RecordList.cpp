@@ -12,17 +12,27 @@ RecordList::RecordList() :
 		_currEnd(NULL),
 		_prevCursor(NULL),
 		_size(0),
+		_spareNodes(NULL),
 		_dontDelete(false)
 {
 }
 
+RecordList::~RecordList() {
+	clear();
+	while (_spareNodes != NULL) {
+		RecordListNode *nextNode = _spareNodes->_next;
+		delete _spareNodes;
+		_spareNodes = nextNode;
+	}
+}
+
 void RecordList::pop_front() {
 	if (empty()) {
 		return;
 	}
 	RecordListNode *killNode = _begin;
 	if (_begin->_next == NULL) { //this is the only item. List size is 1.
-		delete killNode;
+		releaseNode(killNode);
 		_begin = NULL;
 		_currEnd = NULL;
 		_prevCursor = NULL;
@@ -33,7 +43,7 @@ void RecordList::pop_front() {
 		_prevCursor = _begin->_next;
 	}
 	_begin = _begin->next();
-	delete killNode;
+	releaseNode(killNode);
 	_size--;
 }
 
@@ -67,22 +77,22 @@ RecordListNode *RecordList::deleteCurrent() {
 		//deleting last item in list
 		_currEnd = _prevCursor; //back up the current end.
 	}
-	delete killNode;
+	releaseNode(killNode);
 	_size--;
 
 	return returnNode;
 }
 
 void RecordList::push_back(Record * &val) {
-	RecordListNode *newNode = new RecordListNode(val);
+	RecordListNode *node = newNode(val);
 	if (empty()) {
-		_begin = newNode;
-		_currEnd = newNode;
+		_begin = node;
+		_currEnd = node;
 		_prevCursor = NULL;
 	} else {
-		_currEnd->_next = newNode;
+		_currEnd->_next = node;
 		_prevCursor = _currEnd;
-		_currEnd = newNode;
+		_currEnd = node;
 	}
 	_size++;
 }
@@ -93,12 +103,10 @@ void RecordList::clear() {
 	if (_dontDelete) {
 		return;
 	}
-	//delete all nodes, set cursors to NULL, set size to 0.
-	RecordListNode *killNode = _begin;
-	while (killNode != NULL) {
-		RecordListNode *nextNode = killNode->_next;
-		delete killNode;
-		killNode = nextNode;
+	//hand all nodes to the spares in one go, set cursors to NULL, set size to 0.
+	if (_begin != NULL) {
+		_currEnd->_next = _spareNodes;
+		_spareNodes = _begin;
 	}
 	_begin = NULL;
 	_currEnd = NULL;
@@ -125,6 +133,33 @@ void RecordList::assignNoCopy(RecordList &other) {
 	_dontDelete = true;
 }
 
+void RecordList::sort() {
+	mergeSort(&_begin);
+
+	//the last node has most likely moved.
+	_currEnd = _begin;
+	while (_currEnd != NULL && _currEnd->_next != NULL) {
+		_currEnd = _currEnd->_next;
+	}
+	_prevCursor = NULL;
+}
+
+RecordListNode *RecordList::newNode(Record *val) {
+	if (_spareNodes == NULL) {
+		return new RecordListNode(val);
+	}
+	RecordListNode *node = _spareNodes;
+	_spareNodes = node->_next;
+	node->_val = val;
+	node->_next = NULL;
+	return node;
+}
+
+void RecordList::releaseNode(RecordListNode *node) {
+	node->_next = _spareNodes;
+	_spareNodes = node;
+}
+
 
 void RecordList::mergeSort(RecordListNode **headRef) {
 	RecordListNode *head = *headRef;
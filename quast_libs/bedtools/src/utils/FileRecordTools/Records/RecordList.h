@@ -56,7 +56,7 @@ class RecordList {
 public:
 	RecordList();
 
-	~RecordList() { clear(); }
+	~RecordList();
 
 	typedef const RecordListNode * const_iterator_type;
 
@@ -82,7 +82,7 @@ public:
 	RecordList &operator=(const RecordList &other);
 	void assignNoCopy(RecordList &other);
 
-	void sort() { mergeSort(&_begin); }
+	void sort();
 
 private:
 	RecordListNode *_begin;
@@ -90,11 +90,16 @@ private:
 	RecordListNode *_currEnd;
 	RecordListNode *_prevCursor;
 	size_t _size;
+	//nodes taken out of the list, kept to be used again by push_back.
+	//Clearing the list moves all its nodes here at once.
+	RecordListNode *_spareNodes;
 
 	bool _dontDelete; //this will usally be false, but set to true when
 	//calling assignNoCopy, as our list will actually just be a pointer
 	//to another list.
 
+	RecordListNode *newNode(Record *val);
+	void releaseNode(RecordListNode *node);
 
 
 	// The rest of this is just helper methods for sorting.
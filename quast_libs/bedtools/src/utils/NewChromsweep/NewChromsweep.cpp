@@ -50,6 +50,7 @@ bool NewChromSweep::init() {
     if (!_context->hasGenomeFile()) 
     {
         _fileTracks.resize(_numFiles, NULL);
+        _filePrevChromId.resize(_numFiles, -1);
         for (int i=0; i < _numFiles; i++) 
         {
             _fileTracks[i] = new _orderTrackType;
@@ -333,6 +334,11 @@ void NewChromSweep::testChromOrder(const Record *rec)
 
     int fileIdx = rec->getFileIdx();
 
+    //same chrom as the last record tested for this file: nothing changes.
+    int chromId = rec->getChrNameId();
+    if (chromId != -1 && chromId == _filePrevChromId[fileIdx]) return;
+    _filePrevChromId[fileIdx] = chromId;
+
     const string &chrom = rec->getChrName();
 
     findChromOrder(rec);
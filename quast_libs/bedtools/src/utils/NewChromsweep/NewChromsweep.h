@@ -116,6 +116,7 @@ protected:
     typedef map<string, int> _orderTrackType;
     vector<_orderTrackType *> _fileTracks;
     map<int, string> _filePrevChrom;
+    vector<int> _filePrevChromId; //interned id of the chrom in _filePrevChrom, or -1
     bool _lexicoDisproven; //whether we've established that any file ISN'T in lexicographical order
     bool _lexicoAssumed; //whether we've had to try to guess that any file might be in lexicographical order.
     string _lexicoAssumedChromName; //which chromosome we had to make that guess for. Used in error reporting.
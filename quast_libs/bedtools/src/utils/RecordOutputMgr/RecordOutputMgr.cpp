@@ -33,7 +33,8 @@ RecordOutputMgr::RecordOutputMgr()
   _printable(true),
   _bamWriter(NULL),
   _currBamBlockList(NULL),
-  _bamBlockMgr(NULL)
+  _bamBlockMgr(NULL),
+  _outputString(NULL)
 {
 	_bamBlockMgr = new BlockMgr();
 }
@@ -63,6 +64,8 @@ void RecordOutputMgr::init(ContextBase *context) {
 		//set-up BAM writer.
 		_bamWriter = new BamTools::BamWriter();
 		_bamWriter->SetCompressionMode(_context->getUncompressedBam() ?  BamTools::BamWriter::Uncompressed : BamTools::BamWriter::Compressed);
+		_bamWriter->SetCompressionLevel(_context->getBamCompressionLevel());
+		_bamWriter->SetNumThreads(_context->getNumThreads());
 
 		int bamFileIdx = _context->getBamHeaderAndRefIdx();
 		_bamWriter->Open("stdout", _context->getFile(bamFileIdx)->getHeader().c_str(), _context->getFile(bamFileIdx)->getBamReferences());
@@ -171,9 +174,7 @@ void RecordOutputMgr::printClosest(RecordKeyVector &keyList, const vector<int> *
 				int dist = (*dists)[distCount];
 				//if not using sign distance, use absolute value instead.
 				dist = context->signDistance() ? dist : abs(dist);
-				ostringstream s;
-				s << dist;
-				_outBuf.append(s.str());
+				int2str(dist, _outBuf, true);
 				distCount++;
 			}
 			newline();
@@ -437,16 +438,14 @@ void RecordOutputMgr::reportOverlapSummary(RecordKeyVector &keyList)
 }
 
 void RecordOutputMgr::addDbFileId(int fileId) {
-	ostringstream s;
 	if ((static_cast<ContextIntersect *>(_context))->getNumDatabaseFiles()  == 1) return;
 	if (!_context->getUseDBnameTags() && (!_context->getUseDBfileNames())) {
-		s << fileId;
+		int2str(fileId, _outBuf, true);
 	} else if (_context->getUseDBnameTags()){
-		s << (static_cast<ContextIntersect *>(_context))->getDatabaseNameTag((static_cast<ContextIntersect *>(_context))->getDbIdx(fileId));
+		_outBuf.append((static_cast<ContextIntersect *>(_context))->getDatabaseNameTag((static_cast<ContextIntersect *>(_context))->getDbIdx(fileId)));
 	} else {
-		s << _context->getInputFileName(fileId);
+		_outBuf.append(_context->getInputFileName(fileId));
 	}
-	_outBuf.append(s.str());
 	tab();
 }
 
@@ -543,6 +542,10 @@ void RecordOutputMgr::printKey(const Record *key)
 }
 
 void RecordOutputMgr::flush() {
-	fwrite(_outBuf.c_str(), 1, _outBuf.size(), stdout);
+	if (_outputString != NULL) {
+		_outputString->append(_outBuf);
+	} else {
+		fwrite(_outBuf.c_str(), 1, _outBuf.size(), stdout);
+	}
 	_outBuf.clear();
 }
@@ -24,6 +24,9 @@ public:
 	//The init method must be called after all the input files are open.
 	void init(ContextBase *context);
 
+	//Collect non-BAM output in a string instead of writing it to stdout.
+	void setOutputString(string *output) { _outputString = output; }
+
 	void printRecord(Record *record);
 	void printRecord(RecordKeyVector &keyList);
 	void printRecord(Record *record, const string & value);
@@ -45,6 +48,7 @@ private:
 	string _outBuf;
 
 	BlockMgr *_bamBlockMgr;
+	string *_outputString;
 	string _afterVal; //to store values to be printed after record, such as column operations.
 	//some helper functions to neaten the code.
 	void null(bool queryType, bool dbType);
@@ -1,5 +1,6 @@
 #include "BedtoolsDriver.h"
 #include <iostream>
+#include <algorithm>
 #include "RecordOutputMgr.h"
 //contexts
 #include "ContextIntersect.h"
@@ -62,6 +63,15 @@ bool BedtoolsDriver::subMain(int argc, char **argv)
 		return false;
 	}
 
+	//sorted sweeps over plain text files can run a few chromosomes at a time.
+	ChromSplitter splitter;
+	if (canSplitByChrom(context, splitter)) {
+		int numThreads = context->getNumThreads();
+		delete context;
+		runByChrom(argc, argv, splitter, numThreads);
+		return true;
+	}
+
 	//establish which tool we're using (intersect, map, closest, etc).
 	//initialize it.
 	ToolBase *tool = getTool(context);
@@ -89,6 +99,140 @@ bool BedtoolsDriver::subMain(int argc, char **argv)
 }
 
 
+bool BedtoolsDriver::canSplitByChrom(ContextBase *context, ChromSplitter &splitter)
+{
+	if (context->getNumThreads() < 2 || !context->getSortedInput()) {
+		return false;
+	}
+	ContextBase::PROGRAM_TYPE program = context->getProgram();
+	if (program != ContextBase::INTERSECT && program != ContextBase::COVERAGE &&
+		program != ContextBase::MAP && program != ContextBase::CLOSEST) {
+		return false;
+	}
+	if (context->getOutputFileType() == FileRecordTypeChecker::BAM_FILE_TYPE) {
+		return false;
+	}
+	//the histogram sums up all chromosomes at the end, and per base output
+	//is too big to hold for a whole chunk.
+	if (program == ContextBase::COVERAGE) {
+		ContextCoverage::coverageType coverageType = static_cast<ContextCoverage *>(context)->getCoverageType();
+		if (coverageType == ContextCoverage::HIST || coverageType == ContextCoverage::PER_BASE) {
+			return false;
+		}
+	}
+	for (int fileIdx = 0; fileIdx < context->getNumInputFiles(); fileIdx++) {
+		ContextBase::ContextFileType fileType = context->getInputFileType(fileIdx);
+		if (fileType != FileRecordTypeChecker::SINGLE_LINE_DELIM_TEXT_FILE_TYPE &&
+			fileType != FileRecordTypeChecker::GFF_FILE_TYPE &&
+			fileType != FileRecordTypeChecker::VCF_FILE_TYPE) {
+			return false;
+		}
+		if (!splitter.addFile(context->getInputFileName(fileIdx), context->getFile(fileIdx)->getDelimChar())) {
+			return false;
+		}
+	}
+	int queryIdx = static_cast<ContextIntersect *>(context)->getQueryFileIdx();
+	return splitter.split(queryIdx, 8 * context->getNumThreads(), context->hasGenomeFile());
+}
+
+void BedtoolsDriver::runByChrom(int argc, char **argv, const ChromSplitter &splitter, int numThreads)
+{
+	int numChunks = splitter.getNumChunks();
+	int numWorkers = min(numThreads, numChunks);
+
+	chunkResultType result;
+	result.isDone = false;
+	_chunkResults.assign(numChunks, result);
+	_nextChunk = 0;
+	_numChunksPrinted = 0;
+	_maxChunksAhead = 2 * numWorkers;
+
+	vector<thread> workers;
+	for (int i = 0; i < numWorkers; i++) {
+		workers.push_back(thread(&BedtoolsDriver::chunkWorker, this, argc, argv, &splitter));
+	}
+
+	//print the chunks in file order, which is the order the serial sweep
+	//prints them in. The first chunk also carries the header.
+	for (int chunk = 0; chunk < numChunks; chunk++) {
+		chunkResultType &chunkResult = _chunkResults[chunk];
+		{
+			unique_lock<mutex> lock(_chunkResultsMutex);
+			while (!chunkResult.isDone) {
+				_chunkResultDone.wait(lock);
+			}
+		}
+		fwrite(chunkResult.output.c_str(), 1, chunkResult.output.size(), stdout);
+		string().swap(chunkResult.output);
+		{
+			lock_guard<mutex> lock(_chunkResultsMutex);
+			_numChunksPrinted++;
+		}
+		_chunkResultDone.notify_all();
+	}
+
+	for (int i = 0; i < numWorkers; i++) {
+		workers[i].join();
+	}
+	vector<chunkResultType>().swap(_chunkResults);
+}
+
+void BedtoolsDriver::chunkWorker(int argc, char **argv, const ChromSplitter *splitter)
+{
+	int numChunks = splitter->getNumChunks();
+	while (true) {
+		//grab the next chunk, but don't get too far ahead of the printer.
+		int chunk;
+		{
+			unique_lock<mutex> lock(_chunkResultsMutex);
+			while (_nextChunk < numChunks && _nextChunk >= _numChunksPrinted + _maxChunksAhead) {
+				_chunkResultDone.wait(lock);
+			}
+			if (_nextChunk >= numChunks) {
+				return;
+			}
+			chunk = _nextChunk++;
+		}
+		chunkResultType &result = _chunkResults[chunk];
+
+		//every chunk gets its own context, tool and output, reading only
+		//its own byte range of each file.
+		ContextBase *context = getContext();
+		context->setFileByteRanges(splitter->getRanges(chunk));
+		if (!context->testCmdArgs(argc - 1, argv + 1)) {
+			cerr << context->getErrorMessages() << endl;
+			exit(1);
+		}
+		if (chunk > 0) {
+			context->setPrintHeader(false);
+		}
+		ToolBase *tool = getTool(context);
+		if (!tool->init()) {
+			exit(1);
+		}
+		RecordOutputMgr *outputMgr = new RecordOutputMgr();
+		outputMgr->setOutputString(&result.output);
+		outputMgr->init(context);
+
+		RecordKeyVector hits;
+		while (tool->findNext(hits)) {
+			tool->processHits(outputMgr, hits);
+			tool->cleanupHits(hits);
+		}
+		tool->finalizeCalculations();
+		tool->giveFinalReport(outputMgr);
+		delete outputMgr;
+		delete tool;
+		delete context;
+
+		{
+			lock_guard<mutex> lock(_chunkResultsMutex);
+			result.isDone = true;
+		}
+		_chunkResultDone.notify_all();
+	}
+}
+
 ContextBase *BedtoolsDriver::getContext()
 {
 	ContextBase *context = NULL;
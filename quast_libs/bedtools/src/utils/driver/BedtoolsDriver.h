@@ -1,5 +1,9 @@
 #include "ContextBase.h"
 #include "ToolBase.h"
+#include "ChromSplitter.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 class BedtoolsDriver {
 public:
@@ -16,4 +20,20 @@ protected:
 	supportType _supported;
 	bool _hadError;
 	string _errors;
+
+	//output of one chunk of the -threads path, in file order
+	typedef struct {
+		bool isDone;
+		string output;
+	} chunkResultType;
+	vector<chunkResultType> _chunkResults;
+	int _nextChunk;
+	int _numChunksPrinted;
+	int _maxChunksAhead;
+	mutex _chunkResultsMutex;
+	condition_variable _chunkResultDone;
+
+	bool canSplitByChrom(ContextBase *context, ChromSplitter &splitter);
+	void runByChrom(int argc, char **argv, const ChromSplitter &splitter, int numThreads);
+	void chunkWorker(int argc, char **argv, const ChromSplitter *splitter);
 };
@@ -0,0 +1,200 @@
+/*
+ * ChromSplitter.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "ChromSplitter.h"
+#include "ParseTools.h"
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+ChromSplitter::ChromSplitter()
+{
+}
+
+bool ChromSplitter::addFile(const string &fileName, char delimChar)
+{
+	if (fileName == "-" || fileName == "stdin" || fileName.compare(0, 8, "/dev/fd/") == 0) {
+		return false;
+	}
+	int fd = open(fileName.c_str(), O_RDONLY);
+	if (fd == -1) {
+		return false;
+	}
+	struct stat sb;
+	if (fstat(fd, &sb) == -1 || !S_ISREG(sb.st_mode) || sb.st_size < 2) {
+		close(fd);
+		return false;
+	}
+	int64_t fileSize = sb.st_size;
+	void *fileMap = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (fileMap == MAP_FAILED) {
+		return false;
+	}
+	const char *data = (const char *)fileMap;
+
+	//gzip and BGZF files can only be read from the start.
+	bool isValid = !((unsigned char)data[0] == 0x1f && (unsigned char)data[1] == 0x8b);
+
+	vector<chromSpanType> spans;
+	map<string, int> spanIdxs;
+	const char *currChrom = NULL;
+	size_t currChromLen = 0;
+	int64_t pos = 0;
+	while (isValid && pos < fileSize) {
+		const char *line = data + pos;
+		size_t lineLen = fileSize - pos;
+		const char *lineEnd = (const char *)memchr(line, '\n', lineLen);
+		if (lineEnd != NULL) {
+			lineLen = lineEnd - line;
+		}
+		int64_t nextPos = pos + lineLen + 1;
+
+		//most lines are on the same chrom as the one before.
+		if (currChrom != NULL && lineLen > currChromLen && line[currChromLen] == delimChar &&
+			memcmp(line, currChrom, currChromLen) == 0) {
+			pos = nextPos;
+			continue;
+		}
+		if (lineLen == 0 || (lineLen == 1 && line[0] == '\r')) {
+			isValid = false;
+			break;
+		}
+		if (isHeaderLine(string(line, lineLen))) {
+			pos = nextPos;
+			continue;
+		}
+		const char *delim = (const char *)memchr(line, delimChar, lineLen);
+		if (delim == NULL) {
+			isValid = false;
+			break;
+		}
+		string chrom(line, delim - line);
+		if (spanIdxs.find(chrom) != spanIdxs.end()) {
+			//not grouped by chrom, let the sweep report it.
+			isValid = false;
+			break;
+		}
+		if (!spans.empty()) {
+			spans.back().end = pos;
+		}
+		spanIdxs[chrom] = (int)spans.size();
+		chromSpanType span;
+		span.name = chrom;
+		span.start = pos;
+		span.end = fileSize;
+		spans.push_back(span);
+		currChrom = line;
+		currChromLen = chrom.size();
+		pos = nextPos;
+	}
+	munmap(fileMap, fileSize);
+
+	if (!isValid || spans.empty()) {
+		return false;
+	}
+	_spans.push_back(spans);
+	_spanIdxs.push_back(spanIdxs);
+	_fileSizes.push_back(fileSize);
+	return true;
+}
+
+bool ChromSplitter::split(int queryFileIdx, int numChunks, bool allowDbOnlyChroms)
+{
+	_ranges.clear();
+	int numFiles = (int)_spans.size();
+	const vector<chromSpanType> &querySpans = _spans[queryFileIdx];
+	int numChroms = (int)querySpans.size();
+	if (numChunks < 2 || numChroms < 2) {
+		return false;
+	}
+	if (!allowDbOnlyChroms) {
+		const map<string, int> &querySpanIdxs = _spanIdxs[queryFileIdx];
+		for (int fileIdx = 0; fileIdx < numFiles; fileIdx++) {
+			const vector<chromSpanType> &spans = _spans[fileIdx];
+			for (int spanIdx = 0; spanIdx < (int)spans.size(); spanIdx++) {
+				if (querySpanIdxs.find(spans[spanIdx].name) == querySpanIdxs.end()) {
+					return false;
+				}
+			}
+		}
+	}
+
+	//weigh each query chrom by its bytes in all files, and find where the
+	//chroms from each one onwards start in every file.
+	vector<int64_t> chromBytes(numChroms, 0);
+	vector<vector<int64_t> > nextStarts(numFiles, vector<int64_t>(numChroms + 1));
+	int64_t totalBytes = 0;
+	for (int fileIdx = 0; fileIdx < numFiles; fileIdx++) {
+		const vector<chromSpanType> &spans = _spans[fileIdx];
+		const map<string, int> &spanIdxs = _spanIdxs[fileIdx];
+		vector<int64_t> &nextStart = nextStarts[fileIdx];
+		nextStart[numChroms] = _fileSizes[fileIdx];
+		int nextSpanIdx = (int)spans.size();
+		for (int chromIdx = numChroms - 1; chromIdx >= 0; chromIdx--) {
+			nextStart[chromIdx] = nextStart[chromIdx + 1];
+			map<string, int>::const_iterator iter = spanIdxs.find(querySpans[chromIdx].name);
+			if (iter == spanIdxs.end()) {
+				continue;
+			}
+			//shared chroms must come in the same order as in the query.
+			if (iter->second > nextSpanIdx) {
+				return false;
+			}
+			nextSpanIdx = iter->second;
+			const chromSpanType &span = spans[nextSpanIdx];
+			nextStart[chromIdx] = span.start;
+			chromBytes[chromIdx] += span.end - span.start;
+			totalBytes += span.end - span.start;
+		}
+	}
+
+	//cut when the running total passes the next share of the bytes, but
+	//only where every file gets at least one record on each side.
+	vector<int64_t> prevBounds(numFiles);
+	for (int fileIdx = 0; fileIdx < numFiles; fileIdx++) {
+		prevBounds[fileIdx] = _spans[fileIdx][0].start;
+	}
+	vector<int> cuts;
+	int64_t bytesSoFar = 0;
+	for (int chromIdx = 0; chromIdx < numChroms - 1; chromIdx++) {
+		bytesSoFar += chromBytes[chromIdx];
+		if (bytesSoFar * numChunks < totalBytes * (int64_t)(cuts.size() + 1)) {
+			continue;
+		}
+		bool canCut = true;
+		for (int fileIdx = 0; fileIdx < numFiles && canCut; fileIdx++) {
+			int64_t bound = nextStarts[fileIdx][chromIdx + 1];
+			canCut = bound > prevBounds[fileIdx] && bound < _fileSizes[fileIdx];
+		}
+		if (!canCut) {
+			continue;
+		}
+		cuts.push_back(chromIdx + 1);
+		for (int fileIdx = 0; fileIdx < numFiles; fileIdx++) {
+			prevBounds[fileIdx] = nextStarts[fileIdx][chromIdx + 1];
+		}
+	}
+	if (cuts.empty()) {
+		return false;
+	}
+
+	//the first chunk keeps any header lines, the last one runs to the end.
+	cuts.push_back(numChroms);
+	vector<int64_t> starts(numFiles, 0);
+	for (int chunk = 0; chunk < (int)cuts.size(); chunk++) {
+		vector<pair<int64_t, int64_t> > ranges(numFiles);
+		for (int fileIdx = 0; fileIdx < numFiles; fileIdx++) {
+			int64_t end = nextStarts[fileIdx][cuts[chunk]];
+			ranges[fileIdx] = pair<int64_t, int64_t>(starts[fileIdx], end);
+			starts[fileIdx] = end;
+		}
+		_ranges.push_back(ranges);
+	}
+	return true;
+}
@@ -0,0 +1,56 @@
+/*
+ * ChromSplitter.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef CHROMSPLITTER_H_
+#define CHROMSPLITTER_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+
+using namespace std;
+
+//Cuts sorted, uncompressed text inputs into byte ranges that each hold
+//whole chromosomes, so the chunks can be swept independently. Chunk k
+//of every file holds the same run of query chromosomes, and the chunks
+//concatenate back to the whole file.
+class ChromSplitter {
+public:
+	ChromSplitter();
+
+	//Find where each chromosome starts and ends in the file. Returns false
+	//if the file can't be split, e.g. it isn't a regular file, is
+	//compressed, has blank lines, or has a chromosome in two places.
+	bool addFile(const string &fileName, char delimChar);
+
+	//Group the query file's chromosomes into at most numChunks chunks of
+	//about the same size, keeping every chunk non-empty in every file.
+	//Returns false if the files don't list their chromosomes in the same
+	//order, or if everything ends up in a single chunk. Without a genome
+	//file the sweep orders chroms missing from the query by name, so those
+	//are only allowed when allowDbOnlyChroms is set.
+	bool split(int queryFileIdx, int numChunks, bool allowDbOnlyChroms);
+
+	int getNumChunks() const { return (int)_ranges.size(); }
+
+	//Byte range of each file, in the order they were added.
+	const vector<pair<int64_t, int64_t> > &getRanges(int chunk) const { return _ranges[chunk]; }
+
+private:
+	typedef struct {
+		string name;
+		int64_t start;
+		int64_t end;
+	} chromSpanType;
+
+	vector<vector<chromSpanType> > _spans; //by file, in file order
+	vector<map<string, int> > _spanIdxs; //by file, chrom name to span
+	vector<int64_t> _fileSizes;
+	vector<vector<pair<int64_t, int64_t> > > _ranges; //by chunk, then file
+};
+
+#endif /* CHROMSPLITTER_H_ */
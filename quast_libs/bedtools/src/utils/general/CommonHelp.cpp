@@ -40,12 +40,25 @@ void IntersectOutputHelp() {
 
     cerr << "\t-ubam\t"         << "Write uncompressed BAM output. Default writes compressed BAM." << endl << endl;
 
+    cerr << "\t-bamlevel\t"     << "Compression level (0-9, or -1 for zlib default) for BAM output. Default is -1 (i.e. 6)." << endl;
+    cerr                        << "\t\t- Use 0 or 1 for temporary BAM files." << endl << endl;
+
+    cerr << "\t-threads\t"      << "Number of threads used to compress BAM output, to inflate gzipped" << endl;
+    cerr                        << "\t\tinput, and to sweep sorted (-sorted) text files a few chromosomes" << endl;
+    cerr                        << "\t\tat a time. Default is 1." << endl << endl;
+
 }
 
 void sortedHelp() {
     cerr << "\t-sorted\t"       << "Use the \"chromsweep\" algorithm for sorted (-k1,1 -k2,2n) input." << endl << endl;
 }
 
+void sortedThreadsHelp() {
+    cerr << "\t-threads\t"      << "Number of threads sweeping sorted, uncompressed text files" << endl;
+    cerr                        << "\t\ta few chromosomes at a time, or inflating gzipped input." << endl;
+    cerr                        << "\t\tDefault is 1." << endl << endl;
+}
+
 
 void IntersectCommonHelp() {
     cerr << "\t-s\t"            << "Require same strandedness.  That is, only report hits in B" << endl;
@@ -18,6 +18,7 @@ extern void allToolsCommonHelp();
 extern void IntersectCommonHelp();
 extern void IntersectOutputHelp();
 extern void sortedHelp();
+extern void sortedThreadsHelp();
 extern void multiDbOutputHelp();
 
 #endif /* COMMONHELPFILE_H_ */
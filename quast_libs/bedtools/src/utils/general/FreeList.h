@@ -25,8 +25,8 @@ public:
 	}
 
 	~FreeList() {
-		for (int i=0; i < (int)_buffer.size(); i++) {
-			delete _buffer[i];
+		for (int i=0; i < (int)_slabs.size(); i++) {
+			delete [] _slabs[i];
 		}
 	}
 
@@ -64,12 +64,15 @@ public:
 
 private:
 	deque<T *> _buffer;
+	vector<T *> _slabs; //each holds blockSize objects, next to each other in memory.
 	vector<T *> _freeList;
 	int _nextPos;
 	int _blockSize;
 	void growBuffer() {
+		T *slab = new T[_blockSize];
+		_slabs.push_back(slab);
 		for (int i=0; i < _blockSize; ++i) {
-			_buffer.push_back(new T());
+			_buffer.push_back(slab + i);
 		}
 	}
 
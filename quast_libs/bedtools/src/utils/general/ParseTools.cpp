@@ -45,6 +45,23 @@ int str2chrPos(const char *str, size_t ulen) {
 		ulen = strlen(str);
 	}
 
+	//fast path: a plain, optionally signed integer of at most 10 characters, parsed in one pass.
+	//Anything else falls through to the checks below.
+	if (ulen >= 1 && ulen <= 10) {
+		size_t i = (str[0] == '-' || str[0] == '+') ? 1 : 0;
+		unsigned int sum = 0;
+		for (; i < ulen && isdigit(str[i]); i++) {
+			sum = sum * 10 + (str[i] - '0');
+		}
+		if (i == ulen) {
+			return str[0] == '-' ? 0 - (int)sum : (int)sum;
+		}
+	}
+
+	//the value may not be null-terminated at ulen, e.g. a field in a line.
+	string val(str, ulen);
+	str = val.c_str();
+
 	//first test for exponents / scientific notation
 	for (size_t i=0; i < ulen; i++) {
 		if (str[i] == 'e' || str[i] == 'E' || str[i] == '.') {
@@ -150,24 +167,29 @@ bool isHeaderLine(const string &line) {
 		return true;
 	}
 	
-	string tmp = line;
-	transform(tmp.begin(), tmp.end(), tmp.begin(), ::tolower);
+	//only the first few characters decide, so don't lowercase the whole line.
+	char tmp[16];
+	memset(tmp, 0, sizeof(tmp));
+	size_t len = min(line.size(), sizeof(tmp) - 1);
+	for (size_t i=0; i < len; i++) {
+		tmp[i] = tolower(line[i]);
+	}
 	//allow chr chrom to start a header line
-	if (memcmp(tmp.c_str(), "chrom", 5) == 0 && isspace(tmp[5]) && ! isdigit(tmp[6])) {
+	if (memcmp(tmp, "chrom", 5) == 0 && isspace(tmp[5]) && ! isdigit(tmp[6])) {
 		return true;
 	}
 	//allow chr chrom to start a header line
-	if (memcmp(tmp.c_str(), "chr", 3) == 0 && isspace(tmp[3]) && ! isdigit(tmp[4])) {
+	if (memcmp(tmp, "chr", 3) == 0 && isspace(tmp[3]) && ! isdigit(tmp[4])) {
 		return true;
 	}
 	//UCSC file headers can also start with the words "browser" or "track", followed by a whitespace character.
-	if (memcmp(tmp.c_str(), "browser", 7) == 0) {
+	if (memcmp(tmp, "browser", 7) == 0) {
 		return true;
 	}
-	if (memcmp(tmp.c_str(), "track", 5) == 0) {
+	if (memcmp(tmp, "track", 5) == 0) {
 		return true;
 	}
-	if (memcmp(tmp.c_str(), "visibility", 10) == 0) {
+	if (memcmp(tmp, "visibility", 10) == 0) {
 		return true;
 	}
 	return false;
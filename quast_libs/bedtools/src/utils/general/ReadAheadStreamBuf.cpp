@@ -0,0 +1,87 @@
+/*
+ * ReadAheadStreamBuf.cpp
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "ReadAheadStreamBuf.h"
+
+ReadAheadStreamBuf::ReadAheadStreamBuf(streambuf *source)
+: streambuf(),
+  _source(source),
+  _sourceDone(false),
+  _stopReading(false)
+{
+	_sourceReader = thread(&ReadAheadStreamBuf::readSource, this);
+}
+
+ReadAheadStreamBuf::~ReadAheadStreamBuf()
+{
+	{
+		lock_guard<mutex> lock(_chunksMutex);
+		_stopReading = true;
+	}
+	_chunkTaken.notify_all();
+	_sourceReader.join();
+}
+
+int ReadAheadStreamBuf::underflow()
+{
+	{
+		unique_lock<mutex> lock(_chunksMutex);
+		while (_chunks.empty() && !_sourceDone) {
+			_chunkAdded.wait(lock);
+		}
+		if (_chunks.empty()) {
+			if (_sourceError) {
+				rethrow_exception(_sourceError);
+			}
+			return EOF;
+		}
+		_currChunk.swap(_chunks.front());
+		_chunks.pop_front();
+	}
+	_chunkTaken.notify_one();
+
+	char *chunkStart = &_currChunk[0];
+	setg(chunkStart, chunkStart, chunkStart + _currChunk.size());
+	return traits_type::to_int_type(*chunkStart);
+}
+
+void ReadAheadStreamBuf::readSource()
+{
+	try {
+		while (true) {
+			string chunk(CHUNK_SIZE, '\0');
+			streamsize numRead = _source->sgetn(&chunk[0], CHUNK_SIZE);
+			chunk.resize(numRead);
+
+			unique_lock<mutex> lock(_chunksMutex);
+			while (!_stopReading && (int)_chunks.size() >= MAX_CHUNKS_AHEAD) {
+				_chunkTaken.wait(lock);
+			}
+			if (_stopReading) {
+				return;
+			}
+			if (numRead > 0) {
+				_chunks.push_back(string());
+				_chunks.back().swap(chunk);
+			}
+			if (numRead < CHUNK_SIZE) {
+				_sourceDone = true;
+			}
+			lock.unlock();
+			_chunkAdded.notify_one();
+			if (numRead < CHUNK_SIZE) {
+				return;
+			}
+		}
+	} catch (...) {
+		{
+			lock_guard<mutex> lock(_chunksMutex);
+			_sourceError = current_exception();
+			_sourceDone = true;
+		}
+		_chunkAdded.notify_one();
+	}
+}
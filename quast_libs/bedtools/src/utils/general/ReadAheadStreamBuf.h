@@ -0,0 +1,51 @@
+/*
+ * ReadAheadStreamBuf.h
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef READAHEADSTREAMBUF_H_
+#define READAHEADSTREAMBUF_H_
+
+#include <iostream>
+#include <string>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+
+using namespace std;
+
+//Reads another streambuf on a background thread, a few chunks ahead of
+//the reader. Used to inflate gzipped text input while the records are
+//parsed. Errors thrown by the source are rethrown on the reading thread.
+//The source must not be touched by anyone else while this buffer exists.
+class ReadAheadStreamBuf: public std::streambuf {
+public:
+	ReadAheadStreamBuf(streambuf *source);
+	~ReadAheadStreamBuf();
+
+protected:
+	int underflow();
+
+private:
+	streambuf *_source;
+	thread _sourceReader;
+	mutex _chunksMutex;
+	condition_variable _chunkAdded;
+	condition_variable _chunkTaken;
+	deque<string> _chunks; //read from the source, not yet handed out
+	string _currChunk; //the get area
+	bool _sourceDone;
+	bool _stopReading;
+	exception_ptr _sourceError;
+
+	static const int CHUNK_SIZE = 1 << 20; // 1M
+	static const int MAX_CHUNKS_AHEAD = 4;
+
+	void readSource();
+};
+
+
+#endif /* READAHEADSTREAMBUF_H_ */
@@ -10,12 +10,15 @@ from __future__ import with_statement
 
 import re
 import os
-from os.path import isfile
+import shutil
+import tempfile
+import time
+from os.path import isfile, join
 import datetime
 
 from quast_libs import qconfig, qutils
 from quast_libs.ca_utils.analyze_misassemblies import Mapping
-from quast_libs.ca_utils.misc import minimap_fpath, parse_cs_tag
+from quast_libs.ca_utils.misc import minimap_fpath, parse_cs_tag, is_bundled_minimap, create_minimap_output_dir
 
 from quast_libs.log import get_logger
 from quast_libs.qconfig import SPLIT_ALIGN_THRESHOLD
@@ -23,6 +26,10 @@ from quast_libs.qutils import md5, is_non_empty_file
 
 logger = get_logger(qconfig.LOGGER_DEFAULT_NAME)
 
+ref_index_fpaths = dict()  # reference fpath -> prebuilt minimap2 index of it
+tmp_ref_index_fpaths = set()  # indexes built in the output dir for this run only
+batch_aligned_fpaths = set()  # raw minimap2 outputs already written by run_minimap_batch
+
 
 class AlignerStatus:
     FAILED = 0
@@ -51,30 +58,140 @@ def check_successful_check(fpath, contigs_fpath, ref_fpath):
     return True
 
 
-def run_minimap_agb(out_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, max_threads):  # run minimap2 for AGB
-    mask_level = '1' if qconfig.min_IDY < 95 else '0.9'
-    cmdline = [minimap_fpath(), '-cx', 'asm20', '--mask-level', mask_level, '-N', '100',
-               '--score-N', '0', '-E', '1,0', '-f', '200', '--cs', '-t', str(max_threads), ref_fpath, contigs_fpath]
-    return_code = qutils.call_subprocess(cmdline, stdout=open(out_fpath, 'w'), stderr=open(log_err_fpath, 'a'),
-                                         indent='  ' + qutils.index_to_str(index))
-    return return_code
-
-
-def run_minimap(out_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, max_threads):
+def get_minimap_preset():
     if qconfig.is_agb_mode:
-        return run_minimap_agb(out_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, max_threads)
+        return 'asm20'
 
     # NOTE: the difference between presets is in options -w, -B, -O, -E:
     # asm5:  -w19 -B19 -O39,81 -E3,1   (Only use this preset if the average divergence is far below 5%)
     # asm10: -w19 -B9  -O16,41 -E2,1
     # asm20: -w10 -B4   -O6,26 -E2,1
-    # BUT we use our own settings for -B and -O unless "--large" (QUAST-LG) is used: '-B5', '-O4,16' (see below)
+    # BUT we use our own settings for -B and -O unless "--large" (QUAST-LG) is used: '-B5', '-O4,16' (see get_minimap_cmdline)
     if qconfig.min_IDY < 90:
-        preset = 'asm20'
+        return 'asm20'
     elif qconfig.min_IDY < 99:
-        preset = 'asm10'
+        return 'asm10'
     else:
-        preset = 'asm5'
+        return 'asm5'
+
+
+def get_index_cache_dirpath():
+    if not qconfig.minimap_index_cache_dirpath:
+        return None
+    cache_dirpath = os.path.abspath(os.path.expanduser(qconfig.minimap_index_cache_dirpath))
+    try:
+        if not os.path.isdir(cache_dirpath):
+            os.makedirs(cache_dirpath)
+    except OSError:
+        logger.warning('  Cannot create ' + cache_dirpath + ', the reference index will not be cached.')
+        return None
+    if not qutils.check_write_permission(cache_dirpath):
+        logger.warning('  No write permission for ' + cache_dirpath + ', the reference index will not be cached.')
+        return None
+    return cache_dirpath
+
+
+def clean_index_cache(cache_dirpath, used_index_fpath):
+    # temporary files of runs killed while indexing, then the least recently used indexes above the size limit
+    now = time.time()
+    indexes = []
+    for fname in os.listdir(cache_dirpath):
+        fpath = join(cache_dirpath, fname)
+        try:
+            if fname.endswith('.mmi'):
+                if fpath != used_index_fpath:
+                    indexes.append((os.path.getmtime(fpath), os.path.getsize(fpath), fpath))
+            elif '.mmi.' in fname and now - os.path.getmtime(fpath) > qconfig.minimap_index_cache_tmp_max_age:
+                os.remove(fpath)
+        except OSError:  # removed by a concurrent run
+            pass
+    total_size = sum(size for _, size, _ in indexes) + os.path.getsize(used_index_fpath)
+    for _, size, fpath in sorted(indexes):
+        if total_size <= qconfig.minimap_index_cache_max_size:
+            break
+        try:
+            os.remove(fpath)
+            logger.info('  Removed the least recently used reference index from the cache: ' + fpath)
+        except OSError:
+            pass
+        total_size -= size
+
+
+def build_ref_index(ref_fpath, index_fpath, preset, use_mmap, log_err_fpath, max_threads):
+    logger.info('  Indexing the reference...')
+    tmp_fd, tmp_index_fpath = tempfile.mkstemp(prefix=os.path.basename(index_fpath) + '.',
+                                               dir=os.path.dirname(index_fpath))
+    os.close(tmp_fd)
+    cmdline = [minimap_fpath(), '-x', preset] + (['--idx-mmap'] if use_mmap else []) + \
+              ['-t', str(max_threads), '-d', tmp_index_fpath, ref_fpath]
+    return_code = qutils.call_subprocess(cmdline, stderr=open(log_err_fpath, 'a'), indent='    ')
+    if return_code != 0 or not is_non_empty_file(tmp_index_fpath):
+        if isfile(tmp_index_fpath):
+            os.remove(tmp_index_fpath)
+        return False
+    # renaming is atomic, so concurrent runs never pick up a partially written index
+    os.chmod(tmp_index_fpath, 0o644)
+    os.rename(tmp_index_fpath, index_fpath)
+    return True
+
+
+def prepare_ref_index(ref_fpath, output_dir, log_err_fpath, max_threads, num_minimap_runs):
+    # Indexing options (-k, -w) come from the preset only, so one index serves all minimap2 runs on the reference.
+    # With --ref-index-cache, the index is kept there by reference checksum and preset for later QUAST runs.
+    # Otherwise, it is built in the output dir, and only if more than one minimap2 run would index the reference.
+    if not num_minimap_runs:
+        return None
+    cache_dirpath = get_index_cache_dirpath()
+    if not cache_dirpath and num_minimap_runs < 2:
+        return None
+    preset = get_minimap_preset()
+    use_mmap = is_bundled_minimap()
+    index_fname_suffix = '.' + preset + ('.mmap' if use_mmap else '') + '.mmi'
+    if cache_dirpath:
+        index_fpath = join(cache_dirpath, md5(ref_fpath) + index_fname_suffix)
+        if is_non_empty_file(index_fpath):
+            logger.info('  Using the cached reference index: ' + index_fpath)
+            os.utime(index_fpath, None)  # recently used, see clean_index_cache
+        elif not build_ref_index(ref_fpath, index_fpath, preset, use_mmap, log_err_fpath, max_threads):
+            return None
+        clean_index_cache(cache_dirpath, index_fpath)
+    else:
+        index_fpath = join(create_minimap_output_dir(output_dir),
+                           qutils.name_from_fpath(ref_fpath) + index_fname_suffix)
+        if not build_ref_index(ref_fpath, index_fpath, preset, use_mmap, log_err_fpath, max_threads):
+            return None
+        tmp_ref_index_fpaths.add(index_fpath)
+    ref_index_fpaths[ref_fpath] = index_fpath
+    return index_fpath
+
+
+def remove_tmp_ref_index(ref_fpath):
+    index_fpath = ref_index_fpaths.get(ref_fpath)
+    if index_fpath in tmp_ref_index_fpaths:
+        del ref_index_fpaths[ref_fpath]
+        tmp_ref_index_fpaths.remove(index_fpath)
+        if not qconfig.debug and isfile(index_fpath):
+            os.remove(index_fpath)
+
+
+def get_minimap_agb_cmdline(ref_fpath, max_threads):  # minimap2 for AGB
+    mask_level = '1' if qconfig.min_IDY < 95 else '0.9'
+    return [minimap_fpath(), '-cx', 'asm20', '--mask-level', mask_level, '-N', '100',
+            '--score-N', '0', '-E', '1,0', '-f', '200', '--cs', '-t', str(max_threads), ref_fpath]
+
+
+def get_minimap_coords_option():
+    # QUAST's copy of minimap2 writes .coords itself (same filtering and splitting as parse_minimap_output)
+    return ['--coords=%s,%d,%d' % (qconfig.min_IDY, qconfig.min_alignment, SPLIT_ALIGN_THRESHOLD)] \
+        if is_bundled_minimap() else []
+
+
+def get_minimap_cmdline(ref_fpath, max_threads):  # all but the query files
+    ref_fpath = ref_index_fpaths.get(ref_fpath, ref_fpath)
+    if qconfig.is_agb_mode:
+        return get_minimap_agb_cmdline(ref_fpath, max_threads) + get_minimap_coords_option()
+
+    preset = get_minimap_preset()
 
     # -s -- min CIGAR score, -z -- affects how often to stop alignment extension, -B -- mismatch penalty
     # -O -- gap penalty, -r -- max gap size
@@ -82,14 +199,31 @@ def run_minimap(out_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, max_t
     num_alignments = '100' if qconfig.is_combined_ref else '50'
     additional_options = ['-B5', '-O4,16', '--no-long-join', '-r', str(qconfig.local_misassembly_min_length),
                           '-N', num_alignments, '-s', str(qconfig.min_alignment), '-z', '200']
-    cmdline = [minimap_fpath(), '-c', '-x', preset] + (additional_options if not qconfig.large_genome else []) + \
-              ['--mask-level', mask_level, '--min-occ', '200', '-g', '2500', '--score-N', '2', '--cs', '-t', str(max_threads), ref_fpath, contigs_fpath]
+    return [minimap_fpath(), '-c', '-x', preset] + (additional_options if not qconfig.large_genome else []) + \
+           ['--mask-level', mask_level, '--min-occ', '200', '-g', '2500', '--score-N', '2', '--cs', '-t', str(max_threads)] + \
+           get_minimap_coords_option() + [ref_fpath]
+
+
+def run_minimap(out_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, max_threads):
+    cmdline = get_minimap_cmdline(ref_fpath, max_threads) + [contigs_fpath]
     return_code = qutils.call_subprocess(cmdline, stdout=open(out_fpath, 'w'), stderr=open(log_err_fpath, 'a'),
                                          indent='  ' + qutils.index_to_str(index))
 
     return return_code
 
 
+def run_minimap_batch(out_fpaths, ref_fpath, contigs_fpaths, log_err_fpath, max_threads):
+    # All assemblies go through one minimap2 process (needs QUAST's copy of minimap2 for --query-out),
+    # so that small assemblies don't leave threads idle. align_contigs then reuses the outputs.
+    cmdline = get_minimap_cmdline(ref_fpath, max_threads) + contigs_fpaths
+    for out_fpath in out_fpaths:
+        cmdline += ['--query-out', out_fpath]
+    return_code = qutils.call_subprocess(cmdline, stderr=open(log_err_fpath, 'a'), indent='  ')
+    if return_code == 0:
+        batch_aligned_fpaths.update(out_fpaths)
+    return return_code
+
+
 def get_aux_out_fpaths(fname):
     coords_fpath = fname + '.coords'
     coords_filtered_fpath = fname + '.coords.filtered'
@@ -238,7 +372,11 @@ def align_contigs(output_fpath, out_basename, ref_fpath, contigs_fpath, old_cont
     logger.info('  ' + qutils.index_to_str(index) + 'Aligning contigs to the reference')
 
     tmp_output_fpath = output_fpath + '_tmp'
-    exit_code = run_minimap(tmp_output_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, threads)
+    if tmp_output_fpath in batch_aligned_fpaths:
+        log_out_f.write('\tUsing alignments from the joint minimap2 run...\n')
+        exit_code = 0
+    else:
+        exit_code = run_minimap(tmp_output_fpath, ref_fpath, contigs_fpath, log_err_fpath, index, threads)
     if exit_code != 0:
         return AlignerStatus.ERROR
 
@@ -249,6 +387,9 @@ def align_contigs(output_fpath, out_basename, ref_fpath, contigs_fpath, old_cont
 
     create_successful_check(successful_check_fpath, old_contigs_fpath, ref_fpath)
     log_out_f.write('Filtering alignments...\n')
-    parse_minimap_output(tmp_output_fpath, output_fpath)
+    if is_bundled_minimap():
+        shutil.move(tmp_output_fpath, output_fpath)
+    else:
+        parse_minimap_output(tmp_output_fpath, output_fpath)
     return AlignerStatus.OK
 
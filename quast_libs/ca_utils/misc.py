@@ -48,6 +48,11 @@ def minimap_fpath(just_check=False):
     return minimap_fpath
 
 
+def is_bundled_minimap():
+    # options added to QUAST's copy of minimap2 (e.g. --idx-mmap) are unknown to other installations
+    return minimap_fpath(just_check=True) == bin_fpath('minimap2')
+
+
 def compile_minimap(logger, only_clean=False):
     if (minimap_fpath(just_check=True) and not only_clean) or \
             compile_tool('Minimap2', contig_aligner_dirpath, ['minimap2'], just_notice=False, logger=logger, only_clean=only_clean):
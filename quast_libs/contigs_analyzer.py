@@ -22,16 +22,17 @@ import os
 import sys
 import re
 from collections import defaultdict
-from os.path import join, dirname
+from os.path import join, dirname, isfile
 
 from quast_libs import reporting, qconfig, qutils, fastaparser
 from quast_libs.ca_utils import misc
 from quast_libs.ca_utils.analyze_contigs import analyze_contigs
 from quast_libs.ca_utils.analyze_misassemblies import Mapping, IndelsInfo
 from quast_libs.ca_utils.misc import ref_labels_by_chromosomes, compile_aligner, \
-    create_minimap_output_dir, close_handlers, parse_cs_tag
+    create_minimap_output_dir, close_handlers, parse_cs_tag, is_bundled_minimap
 
-from quast_libs.ca_utils.align_contigs import align_contigs, get_aux_out_fpaths, AlignerStatus
+from quast_libs.ca_utils.align_contigs import align_contigs, get_aux_out_fpaths, prepare_ref_index, run_minimap_batch, \
+    remove_tmp_ref_index, check_successful_check, AlignerStatus
 from quast_libs.ca_utils.save_results import print_results, save_result, save_result_for_unaligned, \
     save_combined_ref_stats
 from quast_libs.fastaparser import get_genome_stats
@@ -253,6 +254,29 @@ def align_and_analyze(is_cyclic, index, contigs_fpath, output_dirpath, ref_fpath
         return AlignerStatus.OK, result, aligned_lengths, misassemblies_in_contigs, aligned_lengths_by_contigs
 
 
+def get_contigs_to_align(reference, contigs_fpaths, old_contigs_fpaths, output_dir):
+    # the assemblies and raw minimap2 outputs of those without alignments to reuse
+    if qconfig.alignments_for_reuse_dirpath is not None:
+        return [], []
+    tmp_output_dirpath = create_minimap_output_dir(output_dir)
+    out_fpaths, to_align_contigs_fpaths = [], []
+    for contigs_fpath, old_contigs_fpath in zip(contigs_fpaths, old_contigs_fpaths):
+        out_basename = join(tmp_output_dirpath, qutils.label_from_fpath_for_fname(contigs_fpath))
+        coords_fpath = get_aux_out_fpaths(out_basename)[0]
+        successful_check_fpath = out_basename + '.sf'
+        if isfile(successful_check_fpath) and isfile(coords_fpath) and \
+                check_successful_check(successful_check_fpath, old_contigs_fpath, reference):
+            continue  # align_contigs will use the existing alignments
+        out_fpaths.append(coords_fpath + '_tmp')
+        to_align_contigs_fpaths.append(contigs_fpath)
+    return out_fpaths, to_align_contigs_fpaths
+
+
+def align_in_batch(reference, out_fpaths, contigs_fpaths, log_err_fpath):
+    logger.info('  Aligning all assemblies to the reference in one minimap2 run...')
+    run_minimap_batch(out_fpaths, reference, contigs_fpaths, log_err_fpath, qconfig.max_threads)
+
+
 def do(reference, contigs_fpaths, is_cyclic, output_dir, old_contigs_fpaths, bed_fpath=None):
     if not os.path.isdir(output_dir):
         os.mkdir(output_dir)
@@ -271,10 +295,18 @@ def do(reference, contigs_fpaths, is_cyclic, output_dir, old_contigs_fpaths, bed
 
     genome_size, reference_chromosomes, ns_by_chromosomes = get_genome_stats(reference, skip_ns=True)
     threads = qconfig.max_threads if qconfig.memory_efficient else threads
+    aligner_log_fpath = join(output_dir, 'minimap2.stderr') if not qconfig.space_efficient else '/dev/null'
+    out_fpaths, to_align_contigs_fpaths = get_contigs_to_align(reference, contigs_fpaths, old_contigs_fpaths, output_dir)
+    is_batch = is_bundled_minimap() and len(to_align_contigs_fpaths) > 1
+    prepare_ref_index(reference, output_dir, aligner_log_fpath, qconfig.max_threads,
+                      num_minimap_runs=1 if is_batch else len(to_align_contigs_fpaths))
+    if is_batch:
+        align_in_batch(reference, out_fpaths, to_align_contigs_fpaths, aligner_log_fpath)
     args = [(is_cyclic, i, contigs_fpath, output_dir, reference, reference_chromosomes, ns_by_chromosomes,
             old_contigs_fpath, bed_fpath, threads)
             for i, (contigs_fpath, old_contigs_fpath) in enumerate(zip(contigs_fpaths, old_contigs_fpaths))]
     statuses, results, aligned_lengths, misassemblies_in_contigs, aligned_lengths_by_contigs = run_parallel(align_and_analyze, args, n_jobs)
+    remove_tmp_ref_index(reference)
     reports = []
 
     aligner_statuses = dict(zip(contigs_fpaths, statuses))
@@ -403,6 +403,128 @@ void mm_write_paf(kstring_t *s, const mm_idx_t *mi, const mm_bseq1_t *t, const m
 	mm_write_paf3(s, mi, t, r, km, opt_flag, -1);
 }
 
+/**************************
+ * QUAST's .coords output *
+ **************************/
+
+// one piece of a low-identity alignment, split at long indels and mismatch stretches
+typedef struct {
+	int s1, s2, len1, len2, dir, matched;
+	const char *cs_st, *cs_en; // cs of the piece, within the cs of the whole alignment
+} coords_piece_t;
+
+static inline int is_cs_base(int c)
+{
+	return c == 'a' || c == 'c' || c == 'g' || c == 't' || c == 'n';
+}
+
+static void coords_write_line(kstring_t *s, const mm_idx_t *mi, const mm_bseq1_t *t, const mm_reg1_t *r, int s1, int e1, int s2, int e2,
+							  int len1, int len2, const char *idy, const char *cs, int l_cs)
+{
+	if (s->l > 0) mm_sprintf_lite(s, "\n");
+	mm_sprintf_lite(s, "%d %d | %d %d | %d %d | %s | ", s1, e1, s2, e2, len1, len2, idy);
+	if (mi->seq[r->rid].name) mm_sprintf_lite(s, "%s", mi->seq[r->rid].name);
+	else mm_sprintf_lite(s, "%d", r->rid);
+	mm_sprintf_lite(s, " %s | ", t->name);
+	str_copy(s, cs, cs + l_cs);
+	s->s[s->l] = 0;
+}
+
+// format the identity as QUAST reports it; return 1 if the rounded identity passes the threshold
+static int coords_idy(char *buf, double idy, double min_idy)
+{
+	snprintf(buf, 32, "%.2f", idy);
+	return strtod(buf, 0) >= min_idy;
+}
+
+static void coords_write_piece(kstring_t *s, const mm_idx_t *mi, const mm_bseq1_t *t, const mm_reg1_t *r, const coords_piece_t *a, const mm_mapopt_t *opt)
+{
+	char idy[32];
+	if (a->len2 < opt->coords_min_len || a->len1 == 0 || a->cs_en == a->cs_st) return;
+	if (!coords_idy(idy, a->matched * 100.0 / (a->len1 > a->len2? a->len1 : a->len2), opt->coords_min_idy)) return;
+	coords_write_line(s, mi, t, r, a->s1, a->s1 + a->len1 - 1, a->s2, a->s2 + (a->len2 - 1) * a->dir, a->len1, a->len2, idy, a->cs_st, a->cs_en - a->cs_st);
+}
+
+// add an indel or a mismatch stretch [op_st,op_en) to the piece; a long one ends the piece
+static void coords_add_gap(kstring_t *s, const mm_idx_t *mi, const mm_bseq1_t *t, const mm_reg1_t *r, coords_piece_t *a, const mm_mapopt_t *opt,
+						   const char *op_en, int n_ref, int n_query)
+{
+	if (n_query > opt->coords_split_gap || n_ref > opt->coords_split_gap) {
+		coords_write_piece(s, mi, t, r, a, opt);
+		a->s1 += a->len1 + n_ref;
+		a->s2 += (a->len2 + n_query) * a->dir;
+		a->len1 = a->len2 = a->matched = 0;
+		a->cs_st = a->cs_en = op_en;
+	} else {
+		a->len1 += n_ref, a->len2 += n_query;
+		a->cs_en = op_en;
+	}
+}
+
+static void coords_split(kstring_t *s, const mm_idx_t *mi, const mm_bseq1_t *t, const mm_reg1_t *r, int s1, int s2, int dir, const char *cs, const mm_mapopt_t *opt)
+{
+	const char *p = cs, *q, *mm_en = 0;
+	int n_mm = 0;
+	coords_piece_t a;
+	a.s1 = s1, a.s2 = s2, a.dir = dir, a.len1 = a.len2 = a.matched = 0;
+	a.cs_st = a.cs_en = cs;
+	while (*p) {
+		if (*p == '*' && is_cs_base(p[1])) { // mismatches are only added once the stretch is over
+			for (q = p + 1; is_cs_base(*q); ++q) {}
+			++n_mm, mm_en = p = q;
+			continue;
+		}
+		if (*p == ':' && p[1] >= '0' && p[1] <= '9') {
+			for (q = p + 1; *q >= '0' && *q <= '9'; ++q) {}
+		} else if ((*p == '+' || *p == '-') && is_cs_base(p[1])) {
+			for (q = p + 1; is_cs_base(*q); ++q) {}
+		} else { // not an operation QUAST knows about
+			++p;
+			continue;
+		}
+		if (n_mm > 0) coords_add_gap(s, mi, t, r, &a, opt, mm_en, n_mm, n_mm);
+		n_mm = 0;
+		if (*p == ':') {
+			int n = atoi(p + 1);
+			a.len1 += n, a.len2 += n, a.matched += n;
+			a.cs_en = q;
+		} else if (*p == '+') {
+			coords_add_gap(s, mi, t, r, &a, opt, q, 0, q - p - 1);
+		} else {
+			coords_add_gap(s, mi, t, r, &a, opt, q, q - p - 1, 0);
+		}
+		p = q;
+	}
+	coords_write_piece(s, mi, t, r, &a, opt); // a trailing mismatch stretch is dropped
+}
+
+void mm_write_coords(kstring_t *s, const mm_idx_t *mi, const mm_bseq1_t *t, const mm_reg1_t *r, void *km, const mm_mapopt_t *opt)
+{
+	kstring_t cs = {0,0,0};
+	const char *cs_tag = "";
+	char idy[32];
+	int s1 = r->rs + 1, s2 = r->qs + 1, dir = 1, len1 = 0, len2 = 0;
+	uint32_t k;
+
+	s->l = 0;
+	if (r->p) {
+		write_cs_ds_or_MD(km, &cs, mi, t, r, 1, 0, 0, 1, !!(opt->flag&MM_F_QSTRAND));
+		cs_tag = cs.s + 1; // skip the leading TAB
+		if (r->rev) s2 = r->qe, dir = -1;
+		for (k = 0; k < r->p->n_cigar; ++k) {
+			int op = r->p->cigar[k]&0xf, len = r->p->cigar[k]>>4;
+			if (op == MM_CIGAR_MATCH || op == MM_CIGAR_EQ_MATCH || op == MM_CIGAR_X_MISMATCH) len1 += len, len2 += len;
+			else if (op == MM_CIGAR_DEL) len1 += len;
+			else if (op == MM_CIGAR_INS) len2 += len;
+		}
+	} else if (r->rev) s2 = r->qe, dir = -1;
+	if (coords_idy(idy, r->mlen * 100.0 / r->blen, opt->coords_min_idy))
+		coords_write_line(s, mi, t, r, s1, s1 + len1 - 1, s2, s2 + (len2 - 1) * dir, len1, len2, idy, cs_tag, strlen(cs_tag));
+	else if (r->p)
+		coords_split(s, mi, t, r, s1, s2, dir, cs_tag + 5, opt);
+	free(cs.s);
+}
+
 static void sam_write_sq(kstring_t *s, char *seq, int l, int rev, int comp)
 {
 	extern unsigned char seq_comp_table[256];
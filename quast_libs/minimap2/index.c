@@ -4,6 +4,9 @@
 #include <io.h> // for open(2)
 #else
 #include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#define MM_HAVE_MMAP
 #endif
 #include <fcntl.h>
 #include <stdio.h>
@@ -29,8 +32,18 @@ typedef struct mm_idx_bucket_s {
 	int32_t n;   // size of the _p_ array
 	uint64_t *p; // position array for minimizers appearing >1 times
 	void *h;     // hash table indexing _p_ and minimizers appearing once
+	uint32_t n_keys, n_slots; // for a mapped index: number of minimizers and size of _t_
+	const uint64_t *t;        // for a mapped index: open-addressed (key, value) table used instead of _h_
 } mm_idx_bucket_t;
 
+typedef struct mm_idx_map_s {
+	void *addr;  // start of the mapping, or of a malloc'ed copy of the part
+	size_t len;
+	int is_mmap;
+} mm_idx_map_t;
+
+#define MM_IDX_MAP_EMPTY ((uint64_t)-1) // never a valid key: keys have at most 57 significant bits
+
 typedef struct {
 	int32_t st, en, max; // max is not used for now
 	int32_t score:30, strand:2;
@@ -60,7 +73,7 @@ void mm_idx_destroy(mm_idx_t *mi)
 	if (mi->h) kh_destroy(str, (khash_t(str)*)mi->h);
 	if (mi->B) {
 		for (i = 0; i < 1U<<mi->b; ++i) {
-			free(mi->B[i].p);
+			if (!mi->map) free(mi->B[i].p);
 			free(mi->B[i].a.a);
 			kh_destroy(idx, (idxhash_t*)mi->B[i].h);
 		}
@@ -71,11 +84,59 @@ void mm_idx_destroy(mm_idx_t *mi)
 		free(mi->I);
 	}
 	if (!mi->km) {
-		for (i = 0; i < mi->n_seq; ++i)
-			free(mi->seq[i].name);
+		if (!mi->map)
+			for (i = 0; i < mi->n_seq; ++i)
+				free(mi->seq[i].name);
 		free(mi->seq);
 	} else km_destroy(mi->km);
-	free(mi->B); free(mi->S); free(mi);
+	if (mi->map) { // names, _p_ and _S_ all live in the mapping
+#ifdef MM_HAVE_MMAP
+		if (mi->map->is_mmap) munmap(mi->map->addr, mi->map->len);
+		else free(mi->map->addr);
+#else
+		free(mi->map->addr);
+#endif
+		free(mi->map);
+	} else free(mi->S);
+	free(mi->B); free(mi);
+}
+
+static inline const uint64_t *mm_idx_map_get(const mm_idx_bucket_t *b, uint64_t key)
+{
+	uint32_t mask = b->n_slots - 1, i = (uint32_t)(key>>1) & mask;
+	while (b->t[i<<1] != MM_IDX_MAP_EMPTY) { // linear probing; tables always have an empty slot
+		if (b->t[i<<1]>>1 == key>>1) return &b->t[i<<1];
+		i = (i + 1) & mask;
+	}
+	return 0;
+}
+
+// number of minimizers in a bucket
+static inline uint32_t mm_idx_bucket_size(const mm_idx_bucket_t *b)
+{
+	if (b->h) return kh_size((idxhash_t*)b->h);
+	return b->t? b->n_keys : 0;
+}
+
+// number of hash table slots in a bucket, occupied or not
+static inline uint32_t mm_idx_bucket_end(const mm_idx_bucket_t *b)
+{
+	if (b->h) return kh_end((idxhash_t*)b->h);
+	return b->t? b->n_slots : 0;
+}
+
+// get the key and the value in slot _i_; return 0 if the slot is empty
+static inline int mm_idx_bucket_slot(const mm_idx_bucket_t *b, uint32_t i, uint64_t *key, uint64_t *val)
+{
+	if (b->h) {
+		idxhash_t *h = (idxhash_t*)b->h;
+		if (!kh_exist(h, i)) return 0;
+		*key = kh_key(h, i), *val = kh_val(h, i);
+	} else {
+		if (b->t[i<<1] == MM_IDX_MAP_EMPTY) return 0;
+		*key = b->t[i<<1], *val = b->t[i<<1|1];
+	}
+	return 1;
 }
 
 const uint64_t *mm_idx_get(const mm_idx_t *mi, uint64_t minier, int *n)
@@ -85,7 +146,17 @@ const uint64_t *mm_idx_get(const mm_idx_t *mi, uint64_t minier, int *n)
 	mm_idx_bucket_t *b = &mi->B[minier&mask];
 	idxhash_t *h = (idxhash_t*)b->h;
 	*n = 0;
-	if (h == 0) return 0;
+	if (h == 0) {
+		const uint64_t *e;
+		if (b->t == 0 || (e = mm_idx_map_get(b, minier>>mi->b<<1)) == 0) return 0;
+		if (e[0]&1) {
+			*n = 1;
+			return &e[1];
+		} else {
+			*n = (uint32_t)e[1];
+			return &b->p[e[1]>>32];
+		}
+	}
 	k = kh_get(idx, h, minier>>mi->b<<1);
 	if (k == kh_end(h)) return 0;
 	if (kh_key(h, k)&1) { // special casing when there is only one k-mer
@@ -106,15 +177,15 @@ void mm_idx_stat(const mm_idx_t *mi)
 	for (i = 0; i < mi->n_seq; ++i)
 		len += mi->seq[i].len;
 	for (i = 0; i < 1U<<mi->b; ++i)
-		if (mi->B[i].h) n += kh_size((idxhash_t*)mi->B[i].h);
+		n += mm_idx_bucket_size(&mi->B[i]);
 	for (i = 0; i < 1U<<mi->b; ++i) {
-		idxhash_t *h = (idxhash_t*)mi->B[i].h;
-		khint_t k;
-		if (h == 0) continue;
-		for (k = 0; k < kh_end(h); ++k)
-			if (kh_exist(h, k)) {
-				sum += kh_key(h, k)&1? 1 : (uint32_t)kh_val(h, k);
-				if (kh_key(h, k)&1) ++n1;
+		const mm_idx_bucket_t *b = &mi->B[i];
+		uint32_t k, end = mm_idx_bucket_end(b);
+		uint64_t key, val;
+		for (k = 0; k < end; ++k)
+			if (mm_idx_bucket_slot(b, k, &key, &val)) {
+				sum += key&1? 1 : (uint32_t)val;
+				if (key&1) ++n1;
 			}
 	}
 	fprintf(stderr, "[M::%s::%.3f*%.2f] distinct minimizers: %d (%.2f%% are singletons); average occurrences: %.3lf; average spacing: %.3lf; total length: %ld\n",
@@ -187,20 +258,19 @@ int32_t mm_idx_cal_max_occ(const mm_idx_t *mi, float f)
 {
 	int i;
 	size_t n = 0;
-	uint32_t thres;
-	khint_t *a, k;
+	uint32_t thres, *a, k;
 	if (f <= 0.) return INT32_MAX;
 	for (i = 0; i < 1<<mi->b; ++i)
-		if (mi->B[i].h) n += kh_size((idxhash_t*)mi->B[i].h);
+		n += mm_idx_bucket_size(&mi->B[i]);
 	if (n == 0) return INT32_MAX;
 	a = (uint32_t*)malloc(n * 4);
 	for (i = n = 0; i < 1<<mi->b; ++i) {
-		idxhash_t *h = (idxhash_t*)mi->B[i].h;
-		if (h == 0) continue;
-		for (k = 0; k < kh_end(h); ++k) {
-			if (!kh_exist(h, k)) continue;
-			a[n++] = kh_key(h, k)&1? 1 : (uint32_t)kh_val(h, k);
-		}
+		const mm_idx_bucket_t *b = &mi->B[i];
+		uint32_t end = mm_idx_bucket_end(b);
+		uint64_t key, val;
+		for (k = 0; k < end; ++k)
+			if (mm_idx_bucket_slot(b, k, &key, &val))
+				a[n++] = key&1? 1 : (uint32_t)val;
 	}
 	thres = ks_ksmall_uint32_t(n, a, (uint32_t)((1. - f) * n)) + 1;
 	free(a);
@@ -482,18 +552,15 @@ void mm_idx_dump(FILE *fp, const mm_idx_t *mi)
 	}
 	for (i = 0; i < 1<<mi->b; ++i) {
 		mm_idx_bucket_t *b = &mi->B[i];
-		khint_t k;
-		idxhash_t *h = (idxhash_t*)b->h;
-		uint32_t size = h? h->size : 0;
+		uint32_t k, size = mm_idx_bucket_size(b), end = mm_idx_bucket_end(b);
 		fwrite(&b->n, 4, 1, fp);
 		fwrite(b->p, 8, b->n, fp);
 		fwrite(&size, 4, 1, fp);
 		if (size == 0) continue;
-		for (k = 0; k < kh_end(h); ++k) {
+		for (k = 0; k < end; ++k) {
 			uint64_t x[2];
-			if (!kh_exist(h, k)) continue;
-			x[0] = kh_key(h, k), x[1] = kh_val(h, k);
-			fwrite(x, 8, 2, fp);
+			if (mm_idx_bucket_slot(b, k, &x[0], &x[1]))
+				fwrite(x, 8, 2, fp);
 		}
 	}
 	if (!(mi->flag & MM_I_NO_SEQ))
@@ -501,6 +568,231 @@ void mm_idx_dump(FILE *fp, const mm_idx_t *mi)
 	fflush(fp);
 }
 
+/*
+ * Layout of one part of a mapped index (MM_IDX_MAGIC_MMAP). Everything is
+ * 8-byte aligned relative to the start of the part, so that the part can be
+ * used in place once the file is mmap'ed:
+ *
+ *   magic[4], uint32_t {w, k, b, n_seq, flag}
+ *   uint64_t {part_len, sum_len, names_off, dir_off, S_off}
+ *   uint32_t len[n_seq]
+ *   names, each NUL-terminated; an empty name stands for no name
+ *   mm_idx_map_bucket_t dir[1<<b]
+ *   for each bucket: uint64_t p[n], then uint64_t t[n_slots*2]
+ *   uint32_t S[(sum_len+7)/8] unless MM_I_NO_SEQ
+ *
+ * t[] is an open-addressed hash table with linear probing over n_slots (a
+ * power of 2) slots. Each slot holds a key and a value with the same meaning
+ * as in the khash of a regular index; empty slots have MM_IDX_MAP_EMPTY as key.
+ */
+
+typedef struct {
+	uint64_t p_off, t_off;
+	uint32_t n, n_keys, n_slots, dummy;
+} mm_idx_map_bucket_t;
+
+#define MM_IDX_MAP_HDR 64
+
+static void mm_idx_dump_pad(FILE *fp, uint64_t *off)
+{
+	static const char zero[8] = {0,0,0,0,0,0,0,0};
+	uint64_t l = (8 - (*off & 7)) & 7;
+	fwrite(zero, 1, l, fp);
+	*off += l;
+}
+
+void mm_idx_dump_mmap(FILE *fp, const mm_idx_t *mi)
+{
+	uint64_t h[5], sum_len = 0, off, max_slots = 0;
+	uint32_t x[5], i, n_b = 1U<<mi->b;
+	mm_idx_map_bucket_t *dir;
+	uint64_t *t;
+
+	// work out the layout first; the header needs all offsets
+	for (i = 0, off = MM_IDX_MAP_HDR + mi->n_seq * 4; i < mi->n_seq; ++i) {
+		sum_len += mi->seq[i].len;
+		off += (mi->seq[i].name? strlen(mi->seq[i].name) : 0) + 1;
+	}
+	off = (off + 7) & ~7ULL;
+	h[2] = MM_IDX_MAP_HDR + mi->n_seq * 4, h[3] = off, h[1] = sum_len;
+	off += n_b * sizeof(mm_idx_map_bucket_t);
+	dir = (mm_idx_map_bucket_t*)calloc(n_b, sizeof(mm_idx_map_bucket_t));
+	for (i = 0; i < n_b; ++i) {
+		mm_idx_map_bucket_t *d = &dir[i];
+		d->n = mi->B[i].n, d->n_keys = mm_idx_bucket_size(&mi->B[i]);
+		if (d->n_keys > 0) {
+			uint64_t n_slots = (uint64_t)d->n_keys + (d->n_keys>>1) + 1; // load factor below 2/3
+			kroundup64(n_slots);
+			d->n_slots = n_slots;
+			if (n_slots > max_slots) max_slots = n_slots;
+		}
+		d->p_off = off, off += (uint64_t)d->n * 8;
+		d->t_off = off, off += (uint64_t)d->n_slots * 16;
+	}
+	h[4] = off;
+	if (!(mi->flag & MM_I_NO_SEQ))
+		off += (sum_len + 7) / 8 * 4;
+	h[0] = (off + 7) & ~7ULL;
+
+	// write the part
+	x[0] = mi->w, x[1] = mi->k, x[2] = mi->b, x[3] = mi->n_seq, x[4] = mi->flag & ~MM_I_MMAP;
+	fwrite(MM_IDX_MAGIC_MMAP, 1, 4, fp);
+	fwrite(x, 4, 5, fp);
+	fwrite(h, 8, 5, fp);
+	off = MM_IDX_MAP_HDR;
+	for (i = 0; i < mi->n_seq; ++i)
+		fwrite(&mi->seq[i].len, 4, 1, fp);
+	off += mi->n_seq * 4;
+	for (i = 0; i < mi->n_seq; ++i) {
+		const char *name = mi->seq[i].name? mi->seq[i].name : "";
+		uint64_t l = strlen(name) + 1;
+		fwrite(name, 1, l, fp);
+		off += l;
+	}
+	mm_idx_dump_pad(fp, &off);
+	fwrite(dir, sizeof(mm_idx_map_bucket_t), n_b, fp);
+	off += n_b * sizeof(mm_idx_map_bucket_t);
+	t = (uint64_t*)malloc(max_slots * 16);
+	for (i = 0; i < n_b; ++i) {
+		const mm_idx_bucket_t *b = &mi->B[i];
+		const mm_idx_map_bucket_t *d = &dir[i];
+		uint32_t k, end = mm_idx_bucket_end(b), mask = d->n_slots - 1;
+		uint64_t key, val;
+		assert(off == d->p_off);
+		fwrite(b->p, 8, d->n, fp);
+		off += (uint64_t)d->n * 8;
+		if (d->n_slots == 0) continue;
+		memset(t, 0xff, (uint64_t)d->n_slots * 16);
+		for (k = 0; k < end; ++k) {
+			uint32_t j;
+			if (!mm_idx_bucket_slot(b, k, &key, &val)) continue;
+			for (j = (uint32_t)(key>>1) & mask; t[j<<1] != MM_IDX_MAP_EMPTY; j = (j + 1) & mask) {}
+			t[j<<1] = key, t[j<<1|1] = val;
+		}
+		fwrite(t, 16, d->n_slots, fp);
+		off += (uint64_t)d->n_slots * 16;
+	}
+	free(t); free(dir);
+	if (!(mi->flag & MM_I_NO_SEQ)) {
+		fwrite(mi->S, 4, (sum_len + 7) / 8, fp);
+		off += (sum_len + 7) / 8 * 4;
+	}
+	mm_idx_dump_pad(fp, &off);
+	assert(off == h[0]);
+	fflush(fp);
+}
+
+// checks that all offsets stored in a part point inside it
+static int mm_idx_map_check(const uint8_t *base, const uint32_t *x, const uint64_t *h)
+{
+	const mm_idx_map_bucket_t *dir = (const mm_idx_map_bucket_t*)(base + h[3]);
+	uint64_t i, off, sum_len = 0;
+	for (i = 0, off = h[2]; i < x[3]; ++i) {
+		const uint8_t *end = (const uint8_t*)memchr(base + off, 0, h[3] - off);
+		if (end == 0) return 0;
+		off = end - base + 1;
+		sum_len += ((const uint32_t*)(base + MM_IDX_MAP_HDR))[i];
+	}
+	if (sum_len != h[1]) return 0;
+	for (i = 0; i < 1ULL<<x[2]; ++i) {
+		const mm_idx_map_bucket_t *d = &dir[i];
+		if (d->n_slots & (d->n_slots - 1) || d->n_keys > d->n_slots) return 0;
+		if (d->p_off < h[3] || d->p_off > h[4] || (uint64_t)d->n > (h[4] - d->p_off) / 8) return 0;
+		if (d->t_off < h[3] || d->t_off > h[4] || (uint64_t)d->n_slots > (h[4] - d->t_off) / 16) return 0;
+		if ((d->p_off | d->t_off) & 7) return 0;
+	}
+	if (!(x[4] & MM_I_NO_SEQ) && (h[1] + 7) / 8 * 4 > h[0] - h[4]) return 0;
+	return 1;
+}
+
+// the magic has been consumed by mm_idx_load()
+static mm_idx_t *mm_idx_load_mmap(FILE *fp)
+{
+	int64_t st;
+	uint32_t x[5], i;
+	uint64_t h[5], sum_len, off;
+	const mm_idx_map_bucket_t *dir;
+	mm_idx_map_t *map;
+	mm_idx_t *mi;
+	uint8_t *base = 0;
+
+	st = ftell(fp) - 4;
+	if (fread(x, 4, 5, fp) != 5 || fread(h, 8, 5, fp) != 5) return 0;
+	if (x[2] > 30 || h[0] < MM_IDX_MAP_HDR || h[2] != MM_IDX_MAP_HDR + (uint64_t)x[3] * 4 || h[2] > h[3] || (h[3] & 7)
+		|| h[3] > h[4] || ((uint64_t)sizeof(mm_idx_map_bucket_t)<<x[2]) > h[4] - h[3] || h[4] > h[0])
+		return 0;
+	map = (mm_idx_map_t*)calloc(1, sizeof(mm_idx_map_t));
+#ifdef MM_HAVE_MMAP
+	{ // map only the pages holding this part; it is used in place
+		struct stat s;
+		if (fstat(fileno(fp), &s) == 0) {
+			if ((uint64_t)s.st_size < (uint64_t)st || h[0] > (uint64_t)s.st_size - st) {
+				if (mm_verbose >= 1)
+					fprintf(stderr, "[ERROR] truncated index part at offset %ld\n", (long)st);
+				free(map);
+				return 0;
+			}
+			if ((st & 7) == 0) {
+				int64_t start = st & ~((int64_t)sysconf(_SC_PAGESIZE) - 1);
+				map->len = st + h[0] - start;
+				map->addr = mmap(0, map->len, PROT_READ, MAP_SHARED, fileno(fp), start);
+				if (map->addr != MAP_FAILED) map->is_mmap = 1, base = (uint8_t*)map->addr + (st - start);
+				else map->addr = 0;
+			}
+		}
+	}
+#endif
+	if (base == 0) { // no mmap() or a misaligned part: read the part into memory instead
+		map->len = h[0];
+		map->addr = malloc(map->len);
+		if (map->addr == 0 || fseek(fp, st, SEEK_SET) != 0 || fread(map->addr, 1, map->len, fp) != map->len) {
+			if (mm_verbose >= 1)
+				fprintf(stderr, "[ERROR] truncated index part at offset %ld\n", (long)st);
+			free(map->addr); free(map);
+			return 0;
+		}
+		base = (uint8_t*)map->addr;
+	}
+	if (!mm_idx_map_check(base, x, h)) {
+		if (mm_verbose >= 1)
+			fprintf(stderr, "[ERROR] corrupted index part at offset %ld\n", (long)st);
+#ifdef MM_HAVE_MMAP
+		if (map->is_mmap) munmap(map->addr, map->len);
+		else free(map->addr);
+#else
+		free(map->addr);
+#endif
+		free(map);
+		return 0;
+	}
+	fseek(fp, st + h[0], SEEK_SET);
+
+	mi = mm_idx_init(x[0], x[1], x[2], x[4]);
+	mi->map = map;
+	mi->n_seq = x[3];
+	mi->seq = (mm_idx_seq_t*)kcalloc(mi->km, mi->n_seq, sizeof(mm_idx_seq_t));
+	for (i = 0, sum_len = 0, off = h[2]; i < mi->n_seq; ++i) {
+		mm_idx_seq_t *s = &mi->seq[i];
+		s->len = ((const uint32_t*)(base + MM_IDX_MAP_HDR))[i];
+		s->name = base[off]? (char*)base + off : 0;
+		off += strlen((char*)base + off) + 1;
+		s->offset = sum_len;
+		s->is_alt = 0;
+		sum_len += s->len;
+	}
+	dir = (const mm_idx_map_bucket_t*)(base + h[3]);
+	for (i = 0; i < 1U<<mi->b; ++i) {
+		mm_idx_bucket_t *b = &mi->B[i];
+		b->n = dir[i].n;
+		b->p = (uint64_t*)(base + dir[i].p_off);
+		b->n_keys = dir[i].n_keys, b->n_slots = dir[i].n_slots;
+		b->t = b->n_slots? (const uint64_t*)(base + dir[i].t_off) : 0;
+	}
+	if (!(mi->flag & MM_I_NO_SEQ))
+		mi->S = (uint32_t*)(base + h[4]);
+	return mi;
+}
+
 mm_idx_t *mm_idx_load(FILE *fp)
 {
 	char magic[4];
@@ -509,6 +801,7 @@ mm_idx_t *mm_idx_load(FILE *fp)
 	mm_idx_t *mi;
 
 	if (fread(magic, 1, 4, fp) != 4) return 0;
+	if (strncmp(magic, MM_IDX_MAGIC_MMAP, 4) == 0) return mm_idx_load_mmap(fp);
 	if (strncmp(magic, MM_IDX_MAGIC, 4) != 0) return 0;
 	if (fread(x, 4, 5, fp) != 5) return 0;
 	mi = mm_idx_init(x[0], x[1], x[2], x[4]);
@@ -573,7 +866,7 @@ int64_t mm_idx_is_idx(const char *fn)
 		lseek(fd, 0, SEEK_SET);
 #endif // WIN32
 		ret = read(fd, magic, 4);
-		if (ret == 4 && strncmp(magic, MM_IDX_MAGIC, 4) == 0)
+		if (ret == 4 && (strncmp(magic, MM_IDX_MAGIC, 4) == 0 || strncmp(magic, MM_IDX_MAGIC_MMAP, 4) == 0))
 			is_idx = 1;
 	}
 	close(fd);
@@ -616,7 +909,10 @@ mm_idx_t *mm_idx_reader_read(mm_idx_reader_t *r, int n_threads)
 	} else
 		mi = mm_idx_gen(r->fp.seq, r->opt.w, r->opt.k, r->opt.bucket_bits, r->opt.flag, r->opt.mini_batch_size, n_threads, r->opt.batch_size);
 	if (mi) {
-		if (r->fp_out) mm_idx_dump(r->fp_out, mi);
+		if (r->fp_out) {
+			if (r->opt.flag & MM_I_MMAP) mm_idx_dump_mmap(r->fp_out, mi);
+			else mm_idx_dump(r->fp_out, mi);
+		}
 		mi->index = r->n_parts++;
 	}
 	return mi;
@@ -79,6 +79,9 @@ static ko_longopt_t long_options[] = {
 	{ "secondary-seq",  ko_no_argument,       354 },
 	{ "ds",             ko_no_argument,       355 },
 	{ "rmq-inner",      ko_required_argument, 356 },
+	{ "idx-mmap",       ko_no_argument,       357 },
+	{ "query-out",      ko_required_argument, 358 },
+	{ "coords",         ko_required_argument, 359 },
 	{ "dbg-seed-occ",   ko_no_argument,       501 },
 	{ "help",           ko_no_argument,       'h' },
 	{ "max-intron-len", ko_required_argument, 'G' },
@@ -129,7 +132,9 @@ int main(int argc, char *argv[])
 	mm_idxopt_t ipt;
 	int i, c, n_threads = 3, n_parts, old_best_n = -1;
 	char *fnw = 0, *rg = 0, *junc_bed = 0, *s, *alt_list = 0;
-	FILE *fp_help = stderr;
+	int n_query_out = 0;
+	char **query_out = 0;
+	FILE *fp_help = stderr, **fp_query_out = 0;
 	mm_idx_reader_t *idx_rdr;
 	mm_idx_t *mi;
 
@@ -218,6 +223,16 @@ int main(int argc, char *argv[])
 		else if (c == 317) opt.end_bonus = atoi(o.arg); // --end-bonus
 		else if (c == 318) opt.flag |= MM_F_INDEPEND_SEG; // --no-pairing
 		else if (c == 320) ipt.flag |= MM_I_NO_SEQ; // --idx-no-seq
+		else if (c == 357) ipt.flag |= MM_I_MMAP; // --idx-mmap
+		else if (c == 359) { // --coords
+			opt.flag |= MM_F_OUT_COORDS | MM_F_CIGAR;
+			opt.coords_min_idy = strtod(o.arg, &s);
+			if (*s == ',') opt.coords_min_len = strtol(s + 1, &s, 10);
+			if (*s == ',') opt.coords_split_gap = strtol(s + 1, &s, 10);
+		} else if (c == 358) { // --query-out
+			query_out = (char**)realloc(query_out, (n_query_out + 1) * sizeof(char*));
+			query_out[n_query_out++] = o.arg;
+		}
 		else if (c == 321) opt.anchor_ext_shift = atoi(o.arg); // --end-seed-pen
 		else if (c == 322) opt.flag |= MM_F_FOR_ONLY; // --for-only
 		else if (c == 323) opt.flag |= MM_F_REV_ONLY; // --rev-only
@@ -337,6 +352,7 @@ int main(int argc, char *argv[])
 		fprintf(fp_help, "    -w INT       minimizer window size [%d]\n", ipt.w);
 		fprintf(fp_help, "    -I NUM       split index for every ~NUM input bases [8G]\n");
 		fprintf(fp_help, "    -d FILE      dump index to FILE []\n");
+		fprintf(fp_help, "    --idx-mmap   with -d, dump an index that is mmap'ed rather than read when loaded\n");
 		fprintf(fp_help, "  Mapping:\n");
 		fprintf(fp_help, "    -f FLOAT     filter out top FLOAT fraction of repetitive minimizers [%g]\n", opt.mid_occ_frac);
 		fprintf(fp_help, "    -g NUM       stop chain enlongation if there are no minimizers in INT-bp [%d]\n", opt.max_gap);
@@ -361,6 +377,9 @@ int main(int argc, char *argv[])
 		fprintf(fp_help, "  Input/Output:\n");
 		fprintf(fp_help, "    -a           output in the SAM format (PAF by default)\n");
 		fprintf(fp_help, "    -o FILE      output alignments to FILE [stdout]\n");
+		fprintf(fp_help, "    --query-out FILE  output alignments of the i-th query file to the i-th FILE (PAF only; repeat per query file)\n");
+		fprintf(fp_help, "    --coords=FLOAT[,INT[,INT]]  output QUAST's .coords instead of PAF: min identity, min length\n");
+		fprintf(fp_help, "                 and indel length to split low-identity alignments at [0,0,%d]\n", opt.coords_split_gap);
 		fprintf(fp_help, "    -L           write CIGAR with >65535 ops at the CG tag\n");
 		fprintf(fp_help, "    -R STR       SAM read group line in a format like '@RG\\tID:foo\\tSM:bar' []\n");
 		fprintf(fp_help, "    -c           output CIGAR in PAF\n");
@@ -389,6 +408,23 @@ int main(int argc, char *argv[])
 		fprintf(stderr, "[ERROR] incorrect input: in the sr mode, please specify no more than two query files.\n");
 		return 1;
 	}
+	if (n_query_out > 0) {
+		if (n_query_out != argc - (o.ind + 1)) {
+			fprintf(stderr, "[ERROR] incorrect input: option --query-out is given %d time(s) for %d query file(s).\n", n_query_out, argc - (o.ind + 1));
+			return 1;
+		}
+		if ((opt.flag & (MM_F_OUT_SAM|MM_F_FRAG_MODE)) || opt.split_prefix) {
+			fprintf(stderr, "[ERROR] option --query-out doesn't work with -a, --split-prefix or the fragment mode.\n");
+			return 1;
+		}
+		fp_query_out = (FILE**)calloc(n_query_out, sizeof(FILE*));
+		for (i = 0; i < n_query_out; ++i) {
+			if ((fp_query_out[i] = fopen(query_out[i], "wb")) == 0) {
+				fprintf(stderr, "[ERROR]\033[1;31m failed to write the output to file '%s'\033[0m: %s\n", query_out[i], strerror(errno));
+				return 1;
+			}
+		}
+	}
 	idx_rdr = mm_idx_reader_open(argv[o.ind], &ipt, fnw);
 	if (idx_rdr == 0) {
 		fprintf(stderr, "[ERROR] failed to open file '%s': %s\n", argv[o.ind], strerror(errno));
@@ -438,7 +474,9 @@ int main(int argc, char *argv[])
 			continue; // no query files
 		}
 		ret = 0;
-		if (!(opt.flag & MM_F_FRAG_MODE)) {
+		if (fp_query_out) {
+			ret = mm_map_file_multi(mi, n_query_out, (const char**)&argv[o.ind + 1], fp_query_out, &opt, n_threads);
+		} else if (!(opt.flag & MM_F_FRAG_MODE)) {
 			for (i = o.ind + 1; i < argc; ++i) {
 				ret = mm_map_file(mi, argv[i], &opt, n_threads);
 				if (ret < 0) break;
@@ -452,6 +490,11 @@ int main(int argc, char *argv[])
 			exit(EXIT_FAILURE);
 		}
 	}
+	if (idx_rdr->is_idx && !mm_idx_reader_eof(idx_rdr)) {
+		fprintf(stderr, "[ERROR] failed to load the prebuilt index\n");
+		mm_idx_reader_close(idx_rdr);
+		return 1;
+	}
 	n_parts = idx_rdr->n_parts;
 	mm_idx_reader_close(idx_rdr);
 
@@ -462,6 +505,13 @@ int main(int argc, char *argv[])
 		perror("[ERROR] failed to write the results");
 		exit(EXIT_FAILURE);
 	}
+	for (i = 0; i < n_query_out; ++i) {
+		if (fclose(fp_query_out[i]) == EOF) {
+			perror("[ERROR] failed to write the results");
+			exit(EXIT_FAILURE);
+		}
+	}
+	free(fp_query_out); free(query_out);
 
 	if (mm_verbose >= 3) {
 		fprintf(stderr, "[M::%s] Version: %s\n", __func__, MM_VERSION);
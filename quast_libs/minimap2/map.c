@@ -395,10 +395,15 @@ typedef struct {
 	int n_parts;
 	uint32_t *rid_shift;
 	FILE *fp_split, **fp_parts;
+
+	int n_fn, i_fn;     // multi-query mode: number of query files and the one being read
+	const char **fn;
+	FILE **fp_out;      // multi-query mode: output of each query file
 } pipeline_t;
 
 typedef struct {
 	const pipeline_t *p;
+	int i_fn;           // multi-query mode: query file the sequences come from
     int n_seq, n_frag;
 	mm_bseq1_t *seq;
 	int *n_reg, *seg_off, *n_seg, *rep_len, *frag_gap;
@@ -518,6 +523,20 @@ static void merge_hits(step_t *s)
 	km_destroy(km);
 }
 
+static void write_hits(const pipeline_t *p, const step_t *s, const char *str)
+{
+	FILE *fp;
+	if (p->fp_out == 0) {
+		mm_err_puts(str);
+		return;
+	}
+	fp = p->fp_out[s->i_fn];
+	if (fputs(str, fp) == EOF || fputc('\n', fp) == EOF) {
+		perror("[ERROR] failed to write the results");
+		exit(EXIT_FAILURE);
+	}
+}
+
 static void *worker_pipeline(void *shared, int step, void *in)
 {
 	int i, j, k;
@@ -529,9 +548,19 @@ static void *worker_pipeline(void *shared, int step, void *in)
         step_t *s;
         s = (step_t*)calloc(1, sizeof(step_t));
 		if (p->n_fp > 1) s->seq = mm_bseq_read_frag2(p->n_fp, p->fp, p->mini_batch_size, with_qual, with_comment, &s->n_seq);
-		else s->seq = mm_bseq_read3(p->fp[0], p->mini_batch_size, with_qual, with_comment, frag_mode, &s->n_seq);
+		else if (p->fp[0]) s->seq = mm_bseq_read3(p->fp[0], p->mini_batch_size, with_qual, with_comment, frag_mode, &s->n_seq);
+		while (s->seq == 0 && p->fp[0] && p->i_fn + 1 < p->n_fn) { // multi-query mode: move on to the next file; batches never span two files
+			mm_bseq_close(p->fp[0]);
+			if ((p->fp[0] = mm_bseq_open(p->fn[++p->i_fn])) == 0) {
+				if (mm_verbose >= 1)
+					fprintf(stderr, "ERROR: failed to open file '%s': %s\n", p->fn[p->i_fn], strerror(errno));
+				break;
+			}
+			s->seq = mm_bseq_read3(p->fp[0], p->mini_batch_size, with_qual, with_comment, frag_mode, &s->n_seq);
+		}
 		if (s->seq) {
 			s->p = p;
+			s->i_fn = p->i_fn;
 			for (i = 0; i < s->n_seq; ++i)
 				s->seq[i].rid = p->n_processed++;
 			s->buf = (mm_tbuf_t**)calloc(p->n_threads, sizeof(mm_tbuf_t*));
@@ -561,7 +590,7 @@ static void *worker_pipeline(void *shared, int step, void *in)
 		const mm_idx_t *mi = p->mi;
 		for (i = 0; i < p->n_threads; ++i) mm_tbuf_destroy(s->buf[i]);
 		free(s->buf);
-		if ((p->opt->flag & MM_F_OUT_CS) && !(mm_dbg_flag & MM_DBG_NO_KALLOC)) km = km_init();
+		if ((p->opt->flag & (MM_F_OUT_CS|MM_F_OUT_COORDS)) && !(mm_dbg_flag & MM_DBG_NO_KALLOC)) km = km_init();
 		for (k = 0; k < s->n_frag; ++k) {
 			int seg_st = s->seg_off[k], seg_en = s->seg_off[k] + s->n_seg[k];
 			for (i = seg_st; i < seg_en; ++i) {
@@ -586,16 +615,18 @@ static void *worker_pipeline(void *shared, int step, void *in)
 							continue;
 						if (p->opt->flag & MM_F_OUT_SAM)
 							mm_write_sam3(&p->str, mi, t, i - seg_st, j, s->n_seg[k], &s->n_reg[seg_st], (const mm_reg1_t*const*)&s->reg[seg_st], km, p->opt->flag, s->rep_len[i]);
+						else if (p->opt->flag & MM_F_OUT_COORDS)
+							mm_write_coords(&p->str, mi, t, r, km, p->opt);
 						else
 							mm_write_paf3(&p->str, mi, t, r, km, p->opt->flag, s->rep_len[i]);
-						mm_err_puts(p->str.s);
+						if (p->str.l > 0) write_hits(p, s, p->str.s); // a hit may leave no .coords lines
 					}
-				} else if ((p->opt->flag & MM_F_PAF_NO_HIT) || ((p->opt->flag & MM_F_OUT_SAM) && !(p->opt->flag & MM_F_SAM_HIT_ONLY))) { // output an empty hit, if requested
+				} else if (((p->opt->flag & MM_F_PAF_NO_HIT) && !(p->opt->flag & MM_F_OUT_COORDS)) || ((p->opt->flag & MM_F_OUT_SAM) && !(p->opt->flag & MM_F_SAM_HIT_ONLY))) { // output an empty hit, if requested
 					if (p->opt->flag & MM_F_OUT_SAM)
 						mm_write_sam3(&p->str, mi, t, i - seg_st, -1, s->n_seg[k], &s->n_reg[seg_st], (const mm_reg1_t*const*)&s->reg[seg_st], km, p->opt->flag, s->rep_len[i]);
 					else
 						mm_write_paf3(&p->str, mi, t, 0, 0, p->opt->flag, s->rep_len[i]);
-					mm_err_puts(p->str.s);
+					write_hits(p, s, p->str.s);
 				}
 			}
 			for (i = seg_st; i < seg_en; ++i) {
@@ -663,6 +694,29 @@ int mm_map_file(const mm_idx_t *idx, const char *fn, const mm_mapopt_t *opt, int
 	return mm_map_file_frag(idx, 1, &fn, opt, n_threads);
 }
 
+int mm_map_file_multi(const mm_idx_t *idx, int n_fn, const char **fn, FILE **fp_out, const mm_mapopt_t *opt, int n_threads)
+{
+	int pl_threads, ret;
+	pipeline_t pl;
+	if (n_fn < 1) return -1;
+	memset(&pl, 0, sizeof(pipeline_t));
+	pl.n_fp = 1;
+	pl.fp = open_bseqs(pl.n_fp, fn);
+	if (pl.fp == 0) return -1;
+	pl.n_fn = n_fn, pl.fn = fn, pl.fp_out = fp_out;
+	pl.opt = opt, pl.mi = idx;
+	pl.n_threads = n_threads > 1? n_threads : 1;
+	pl.mini_batch_size = opt->mini_batch_size;
+	pl_threads = n_threads == 1? 1 : (opt->flag&MM_F_2_IO_THREADS)? 3 : 2;
+	kt_pipeline(pl_threads, worker_pipeline, &pl, 3);
+
+	free(pl.str.s);
+	ret = pl.fp[0]? 0 : -1; // the file that couldn't be opened
+	if (pl.fp[0]) mm_bseq_close(pl.fp[0]);
+	free(pl.fp);
+	return ret;
+}
+
 int mm_split_merge(int n_segs, const char **fn, const mm_mapopt_t *opt, int n_split_idx)
 {
 	int i;
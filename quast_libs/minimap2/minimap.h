@@ -45,12 +45,15 @@
 #define MM_F_SPLICE_OLD    (0x800000000LL)
 #define MM_F_SECONDARY_SEQ (0x1000000000LL)	//output SEQ field for seqondary alignments using hard clipping
 #define MM_F_OUT_DS        (0x2000000000LL)
+#define MM_F_OUT_COORDS    (0x4000000000LL)	// output QUAST's .coords instead of PAF
 
 #define MM_I_HPC          0x1
 #define MM_I_NO_SEQ       0x2
 #define MM_I_NO_NAME      0x4
+#define MM_I_MMAP         0x8 // dump the index in the mmap-able layout
 
 #define MM_IDX_MAGIC   "MMI\2"
+#define MM_IDX_MAGIC_MMAP "MMI\3"
 
 #define MM_MAX_SEG       255
 
@@ -92,6 +95,7 @@ typedef struct {
 	struct mm_idx_bucket_s *B; // index (hidden)
 	struct mm_idx_intv_s *I;   // intervals (hidden)
 	void *km, *h;
+	struct mm_idx_map_s *map;  // memory-mapped index file (hidden)
 } mm_idx_t;
 
 // minimap2 alignment
@@ -181,6 +185,9 @@ typedef struct {
 	int64_t cap_kalloc;
 
 	const char *split_prefix;
+
+	double coords_min_idy; // with MM_F_OUT_COORDS: drop alignments below this identity, or split them at long indels
+	int coords_min_len, coords_split_gap;
 } mm_mapopt_t;
 
 // index reader
@@ -284,7 +291,8 @@ int64_t mm_idx_is_idx(const char *fn);
  *
  * Given a uni-part index, this function loads the entire index into memory.
  * Given a multi-part index, it loads one part only and places the file pointer
- * at the end of that part.
+ * at the end of that part. An index written by mm_idx_dump_mmap() is mapped
+ * into memory rather than read.
  *
  * @param fp         pointer to FILE object
  *
@@ -300,6 +308,18 @@ mm_idx_t *mm_idx_load(FILE *fp);
  */
 void mm_idx_dump(FILE *fp, const mm_idx_t *mi);
 
+/**
+ * Append an index (or one part of a full index) to file in a layout that
+ * mm_idx_load() maps into memory instead of deserializing
+ *
+ * Hash tables, positions and sequences of such an index are used directly from
+ * the mapped file, so that processes loading the same index share its pages.
+ *
+ * @param fp         pointer to FILE object
+ * @param mi         minimap2 index
+ */
+void mm_idx_dump_mmap(FILE *fp, const mm_idx_t *mi);
+
 /**
  * Create an index from strings in memory
  *
@@ -386,6 +406,23 @@ int mm_map_file(const mm_idx_t *idx, const char *fn, const mm_mapopt_t *opt, int
 
 int mm_map_file_frag(const mm_idx_t *idx, int n_segs, const char **fn, const mm_mapopt_t *opt, int n_threads);
 
+/**
+ * Map query sequences from several files, writing the hits of each file to its own stream
+ *
+ * All files go through one pipeline in turn, so that the threads are kept busy
+ * across file boundaries. Only PAF output is supported.
+ *
+ * @param idx        minimap2 index
+ * @param n_fn       number of query files
+ * @param fn         fasta/fastq file names
+ * @param fp_out     output streams; hits of fn[i] are written to fp_out[i]
+ * @param opt        mapping parameters
+ * @param n_threads  number of threads
+ *
+ * @return 0 on success; -1 if one of _fn_ can't be read
+ */
+int mm_map_file_multi(const mm_idx_t *idx, int n_fn, const char **fn, FILE **fp_out, const mm_mapopt_t *opt, int n_threads);
+
 /**
  * Generate the cs tag (new in 2.12)
  *
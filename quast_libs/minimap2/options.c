@@ -56,6 +56,7 @@ void mm_mapopt_init(mm_mapopt_t *opt)
 	opt->mini_batch_size = 500000000;
 	opt->max_sw_mat = 100000000;
 	opt->cap_kalloc = 500000000;
+	opt->coords_split_gap = 20;
 
 	opt->rank_min_len = 500;
 	opt->rank_frac = 0.9f;
@@ -191,9 +192,14 @@ int mm_check_opt(const mm_idxopt_t *io, const mm_mapopt_t *mo)
 			fprintf(stderr, "[ERROR]\033[1;31m --rmq doesn't work with --sr or --splice\033[0m\n");
 		return -7;
 	}
-	if (mo->split_prefix && (mo->flag & (MM_F_OUT_CS|MM_F_OUT_MD))) {
+	if (mo->split_prefix && (mo->flag & (MM_F_OUT_CS|MM_F_OUT_MD|MM_F_OUT_COORDS))) {
 		if (mm_verbose >= 1)
-			fprintf(stderr, "[ERROR]\033[1;31m --cs or --MD doesn't work with --split-prefix\033[0m\n");
+			fprintf(stderr, "[ERROR]\033[1;31m --cs, --MD or --coords doesn't work with --split-prefix\033[0m\n");
+		return -6;
+	}
+	if ((mo->flag & MM_F_OUT_COORDS) && (mo->flag & MM_F_OUT_SAM)) {
+		if (mm_verbose >= 1)
+			fprintf(stderr, "[ERROR]\033[1;31m --coords doesn't work with -a\033[0m\n");
 		return -6;
 	}
 	if (io->k <= 0 || io->w <= 0) {
@@ -18,7 +18,8 @@ from quast_libs.ca_utils.misc import minimap_fpath
 from quast_libs.log import get_logger
 from quast_libs.qutils import splitext_for_fasta_file, is_non_empty_file, download_external_tool, \
     add_suffix, get_dir_for_download
-from quast_libs.ra_utils.misc import sort_bam, bam_to_bed, bedtools_fpath, sambamba_view, calculate_read_len
+from quast_libs.ra_utils.misc import sort_bam, bam_to_bed, bedtools_fpath, sambamba_view, calculate_read_len, \
+    is_bundled_bedtools
 from quast_libs.reads_analyzer import calculate_insert_size
 
 logger = get_logger(qconfig.LOGGER_DEFAULT_NAME)
@@ -107,7 +108,8 @@ def get_joiners(ref_name, sam_fpath, bam_fpath, output_dirpath, err_fpath, using
     bed_fpath = bam_to_bed(output_dirpath, using_reads, bam_sorted_fpath, err_fpath, logger, bedpe=using_reads == 'mp')
     intervals = defaultdict(list)
     if using_reads == 'mp':
-        _, min_is, max_is = calculate_insert_size(sam_fpath, output_dirpath, ref_name, reads_suffix='mp')
+        _, min_is, max_is = calculate_insert_size(sam_fpath, output_dirpath, ref_name, err_fpath, reads_suffix='mp',
+                                                  bam_fpath=bam_fpath)
     with open(bed_fpath) as bed:
         for l in bed:
             fs = l.split()
@@ -389,9 +391,10 @@ def get_unique_covered_regions(ref_fpath, tmp_dir, log_fpath, binary_fpath, inse
             fasta_index_fpath = ref_fpath + '.fai'
             if exists(fasta_index_fpath):
                 os.remove(fasta_index_fpath)
-            qutils.call_subprocess([bedtools_fpath('bedtools'), 'getfasta', '-fi', ref_fpath, '-bed',
-                                    long_repeats_fpath, '-fo', repeats_fasta_fpath],
-                                    stderr=open(log_fpath, 'w'), indent='    ')
+            cmdline = [bedtools_fpath('bedtools'), 'getfasta', '-fi', ref_fpath, '-bed', long_repeats_fpath, '-fo', repeats_fasta_fpath]
+            if is_bundled_bedtools():  # only QUAST's copy of bedtools extracts the sequences in parallel
+                cmdline += ['-threads', str(qconfig.max_threads)]
+            qutils.call_subprocess(cmdline, stderr=open(log_fpath, 'w'), indent='    ')
             cmdline = [minimap_fpath(), '-c', '-x', 'asm10', '-N', '50', '--mask-level', '1', '--no-long-join', '-r', '100',
                        '-t', str(qconfig.max_threads), '-z', '200', ref_fpath, repeats_fasta_fpath]
             qutils.call_subprocess(cmdline, stdout=open(coords_fpath, 'w'), stderr=open(log_fpath, 'a'))
@@ -489,7 +492,7 @@ def do(ref_fpath, original_ref_fpath, output_dirpath):
         sam_fpath, bam_fpath, _ = reads_analyzer.align_reference(ref_fpath, reads_analyzer_dir, using_reads=join_reads)
         joiners = get_joiners(qutils.name_from_fpath(ref_fpath), sam_fpath, bam_fpath, tmp_dir, log_fpath, join_reads)
         uncovered_regions = parse_bed(uncovered_fpath) if join_reads == 'mp' else defaultdict(list)
-        mp_len = calculate_read_len(sam_fpath) if join_reads == 'mp' else None
+        mp_len = calculate_read_len(sam_fpath, log_fpath, logger, bam_fpath=bam_fpath) if join_reads == 'mp' else None
         for chrom, seq in reference:
             region_pairing = get_regions_pairing(unique_covered_regions[chrom], joiners[chrom], mp_len)
             ref_coords_to_output = scaffolding(unique_covered_regions[chrom], region_pairing)
@@ -713,6 +713,10 @@ def parse_options(logger, quast_args):
              callback_kwargs={'store_true_values': ['space_efficient'],
                               'store_false_values': ['show_snps', 'create_icarus_html']},)
          ),
+        (['--ref-index-cache'], dict(
+             dest='minimap_index_cache_dirpath',
+             type='string')
+         ),
         (['--silent'], dict(
              dest='silent',
              action='store_true')
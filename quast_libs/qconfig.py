@@ -88,6 +88,9 @@ all_labels_from_dirs = False
 run_busco = False
 large_genome = False
 use_kmc = False
+minimap_index_cache_dirpath = None  # --ref-index-cache: reference indexes shared between QUAST runs
+minimap_index_cache_max_size = 20 * 1024 ** 3  # bytes; the least recently used indexes are removed above it
+minimap_index_cache_tmp_max_age = 24 * 60 * 60  # seconds; older temporary files are left from killed runs
 report_all_metrics = False
 
 # ideal assembly section
@@ -507,6 +510,8 @@ def usage(show_hidden=False, mode=None, short=True, stream=sys.stdout):
         stream.write("                                      This may significantly reduce memory consumption on large genomes\n")
         stream.write("    --space-efficient                 Create only reports and plots files. Aux files including .stdout, .stderr, .coords will not be created.\n")
         stream.write("                                      This may significantly reduce space consumption on large genomes. Icarus viewers also will not be built\n")
+        stream.write("    --ref-index-cache  <dirpath>      Keep the minimap2 indexes of the references in this directory and reuse them in later runs.\n")
+        stream.write("                                      The least recently used indexes are removed when they take more than %d GB\n" % (minimap_index_cache_max_size // 1024 ** 3))
         stream.write("-1  --pe1     <filename>              File with forward paired-end reads (in FASTQ format, may be gzipped)\n")
         stream.write("-2  --pe2     <filename>              File with reverse paired-end reads (in FASTQ format, may be gzipped)\n")
         stream.write("    --pe12    <filename>              File with interlaced forward and reverse paired-end reads. (in FASTQ format, may be gzipped)\n")
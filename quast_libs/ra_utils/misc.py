@@ -56,6 +56,11 @@ def bedtools_fpath(fname):
     return get_path_to_program(fname, bedtools_bin_dirpath)
 
 
+def is_bundled_bedtools():
+    # options added to QUAST's copy of bedtools (e.g. genomecov -threads) are unknown to other installations
+    return bedtools_fpath('bedtools') == join(bedtools_bin_dirpath, 'bedtools')
+
+
 def get_gridss_fpath():
     if not gridss_dirpath:
         return None
@@ -365,7 +370,33 @@ def bam_to_bed(output_dirpath, name, bam_fpath, err_path, logger, bedpe=False):
     return sorted_bed_fpath
 
 
-def calculate_read_len(sam_fpath):
+def get_pair_stats(bam_fpath, err_fpath, logger, sample_size=1000000):
+    # QUAST's copy of bedtools samples the correctly oriented pairs over the whole BAM (pairstats), decoding
+    # only the core of each record, while the SAM-based estimates below only look at the first lines of the file
+    stats_fpath = os.path.splitext(bam_fpath)[0] + '.pairstats'
+    if is_non_empty_file(stats_fpath) and os.path.getmtime(stats_fpath) >= os.path.getmtime(bam_fpath):
+        logger.info('    Using existing file: ' + stats_fpath)
+    else:
+        tmp_stats_fpath = stats_fpath + '.tmp'
+        return_code = qutils.call_subprocess([bedtools_fpath('bedtools'), 'pairstats', '-ibam', bam_fpath, '-n', str(sample_size)],
+                                             stdout=open(tmp_stats_fpath, 'w'), stderr=open(err_fpath, 'a'), logger=logger)
+        if return_code != 0:
+            os.remove(tmp_stats_fpath)
+            return None
+        shutil.move(tmp_stats_fpath, stats_fpath)
+    with open(stats_fpath) as f:
+        for line in f:
+            fs = line.split('\t')
+            if fs[0] == 'genome' and int(fs[2]) > 0:
+                return {'median_is': int(fs[3]), 'is_deciles': [int(v) for v in fs[4:13]],
+                        'mean_read_len': float(fs[13]), 'min_read_len': int(fs[14]), 'max_read_len': int(fs[15])}
+    return None
+
+
+def calculate_read_len(sam_fpath, err_fpath, logger, bam_fpath=None):
+    if bam_fpath and is_non_empty_file(bam_fpath) and is_bundled_bedtools():
+        pair_stats = get_pair_stats(bam_fpath, err_fpath, logger)
+        return pair_stats['mean_read_len'] if pair_stats else None
     read_lengths = []
     mapped_flags = ['99', '147', '83', '163']  # reads mapped in correct order
     with open(sam_fpath) as sam_in:
@@ -382,13 +413,49 @@ def calculate_read_len(sam_fpath):
     return sum(read_lengths) * 1.0 / len(read_lengths)
 
 
-def calculate_genome_cov(in_fpath, out_fpath, chr_len_fpath, err_fpath, logger, print_all_positions=True):
+def calculate_genome_cov(in_fpath, out_fpath, chr_len_fpath, err_fpath, logger, print_all_positions=True, max_threads=None,
+                         window=None, summary_thresholds=None, bam_mode=None, tracks=None):
     cmd = [bedtools_fpath('bedtools'), 'genomecov', '-ibam' if in_fpath.endswith('.bam') else '-i', in_fpath, '-g', chr_len_fpath]
-    if print_all_positions:
+    # -window, -summary, -footprint, -bedpe and -fragments are only known to QUAST's copy of bedtools
+    if bam_mode:  # 'footprint', 'bedpe' or 'fragments': what to count for each BAM read, see genomecov -h
+        cmd += ['-' + bam_mode]
+    if window:  # mean depth per window
+        cmd += ['-window', str(window)]
+    elif summary_thresholds:  # mean depth and fraction of bases with depth >= each threshold, instead of the histogram
+        cmd += ['-summary', ','.join(str(threshold) for threshold in summary_thresholds)]
+    elif print_all_positions:
         cmd += ['-bga']
+    if max_threads and max_threads > 1 and in_fpath.endswith('.bam') and is_bundled_bedtools():
+        cmd += ['-threads', str(max_threads)]
+    if tracks:  # {chromosome: output file}: the coverage of these chromosomes is also written there, in the same pass
+        tracks_fpath = out_fpath + '_tracks'
+        with open(tracks_fpath, 'w') as out_f:
+            out_f.write('*\t' + out_fpath + '\n')
+            for chr_name, track_fpath in tracks.items():
+                out_f.write(chr_name + '\t' + track_fpath + '\n')
+        cmd += ['-tracks', tracks_fpath]
+        qutils.call_subprocess(cmd, stderr=open(err_fpath, 'a'), logger=logger)
+        if not qconfig.debug:
+            os.remove(tracks_fpath)
+        return
     qutils.call_subprocess(cmd, stdout=open(out_fpath, 'w'), stderr=open(err_fpath, 'a'), logger=logger)
 
 
+def find_bam_gaps(bam_fpath, err_fpath, logger, zero_cov_fpath=None, deletions_fpath=None, min_gap=None,
+                  min_map_quality=None, max_conf_interval=None, labels_fpath=None, split_prefix=None):
+    # bamgaps is only known to QUAST's copy of bedtools: one pass over the position-sorted BAM for
+    # the zero-covered regions, the trivial deletions and the reads of each reference, as requested
+    cmd = [bedtools_fpath('bedtools'), 'bamgaps', '-ibam', bam_fpath]
+    if zero_cov_fpath:
+        cmd += ['-zero', zero_cov_fpath]
+    if deletions_fpath:
+        cmd += ['-del', deletions_fpath, '-mingap', str(min_gap), '-mapq', str(min_map_quality),
+                '-maxci', str(max_conf_interval)]
+    if labels_fpath:
+        cmd += ['-split', labels_fpath, '-prefix', split_prefix]
+    return qutils.call_subprocess(cmd, stderr=open(err_fpath, 'a'), logger=logger)
+
+
 def sambamba_view(in_fpath, out_fpath, max_threads, err_fpath, logger, filter_rule=None):
     cmd = [sambamba_fpath('sambamba'), 'view', '-t', str(max_threads), '-h']
     if in_fpath.endswith('.sam'):
@@ -110,7 +110,7 @@ class QuastDeletion(object):
 def process_one_ref(cur_ref_fpath, output_dirpath, err_fpath, max_threads, bam_fpath=None, bed_fpath=None):
     ref_name = qutils.name_from_fpath(cur_ref_fpath)
     if not bam_fpath:
-        sam_fpath = join(output_dirpath, ref_name + '.sam')
+        sam_fpath = get_split_reads_fpath(output_dirpath, ref_name)
         bam_fpath = join(output_dirpath, ref_name + '.bam')
         bam_sorted_fpath = join(output_dirpath, ref_name + '.sorted.bam')
     else:
@@ -261,6 +261,108 @@ def search_trivial_deletions(temp_output_dir, sam_sorted_fpath, ref_files, ref_l
     return trivial_deletions_fpath
 
 
+def search_trivial_deletions_in_sam(temp_output_dir, sam_fpath, sam_sorted_fpath, meta_ref_fpaths, ref_labels):
+    # splits the reads by references into SAM files along the way
+    if meta_ref_fpaths:
+        logger.info('  Splitting SAM-file by references...')
+    headers = []
+    seq_lengths = {}
+    with open(sam_fpath) as sam_file:
+        for line in sam_file:
+            if not line.startswith('@'):
+                break
+            if line.startswith('@SQ') and 'SN:' in line and 'LN:' in line:
+                seq_name = line.split('\tSN:')[1].split('\t')[0]
+                seq_length = int(line.split('\tLN:')[1].split('\t')[0])
+                seq_lengths[seq_name] = seq_length
+            headers.append(line.strip())
+    need_ref_splitting = False
+    ref_files = {}
+    if meta_ref_fpaths:
+        global ref_sam_fpaths
+        for cur_ref_fpath in meta_ref_fpaths:
+            cur_ref_name = qutils.name_from_fpath(cur_ref_fpath)
+            ref_sam_fpath = join(temp_output_dir, cur_ref_name + '.sam')
+            ref_sam_fpaths[cur_ref_fpath] = ref_sam_fpath
+            if is_non_empty_file(ref_sam_fpath):
+                logger.info('    Using existing split SAM-file for %s: %s' % (cur_ref_name, ref_sam_fpath))
+                ref_files[cur_ref_name] = None
+            else:
+                ref_sam_file = open(ref_sam_fpath, 'w')
+                if not headers[0].startswith('@SQ'):
+                    ref_sam_file.write(headers[0] + '\n')
+                for h in (h for h in headers if h.startswith('@SQ') and 'SN:' in h):
+                    seq_name = h.split('\tSN:')[1].split('\t')[0]
+                    if seq_name in ref_labels and ref_labels[seq_name] == cur_ref_name:
+                        ref_sam_file.write(h + '\n')
+                ref_sam_file.write(headers[-1] + '\n')
+                ref_files[cur_ref_name] = ref_sam_file
+                need_ref_splitting = True
+
+    return search_trivial_deletions(temp_output_dir, sam_sorted_fpath, ref_files, ref_labels, seq_lengths, need_ref_splitting)
+
+
+def get_split_reads_fpath(output_dirpath, ref_name):
+    # QUAST's copy of bedtools splits the reads by references into BAM files (bamgaps -split)
+    # (unless it failed, and the reads were split into SAM files, see search_trivial_deletions_in_sam)
+    split_bam_fpath = join(output_dirpath, 'split_reads', ref_name + '.bam')
+    split_sam_fpath = join(output_dirpath, ref_name + '.sam')
+    if is_bundled_bedtools() and (isfile(split_bam_fpath) or not isfile(split_sam_fpath)):
+        return split_bam_fpath
+    return split_sam_fpath
+
+
+def search_trivial_deletions_in_bam(temp_output_dir, bam_sorted_fpath, meta_ref_fpaths, ref_labels, err_fpath):
+    # the same as search_trivial_deletions, but in a single pass of QUAST's bedtools over the sorted BAM
+    trivial_deletions_fpath = join(temp_output_dir, qconfig.trivial_deletions_fname)
+    logger.info('  Looking for trivial deletions (long zero-covered fragments)...')
+    need_trivial_deletions = True
+    if isfile(trivial_deletions_fpath):
+        need_trivial_deletions = False
+        logger.info('    Using existing file: ' + trivial_deletions_fpath)
+    split_ref_names = set()
+    if meta_ref_fpaths:
+        global ref_sam_fpaths
+        for cur_ref_fpath in meta_ref_fpaths:
+            cur_ref_name = qutils.name_from_fpath(cur_ref_fpath)
+            ref_split_fpath = get_split_reads_fpath(temp_output_dir, cur_ref_name)
+            ref_sam_fpaths[cur_ref_fpath] = ref_split_fpath
+            if is_non_empty_file(ref_split_fpath):
+                logger.info('    Using existing split BAM-file for %s: %s' % (cur_ref_name, ref_split_fpath))
+            else:
+                split_ref_names.add(cur_ref_name)
+    labels_fpath, split_dirpath = None, join(temp_output_dir, 'split_reads')
+    if split_ref_names:
+        if not isdir(split_dirpath):
+            os.makedirs(split_dirpath)
+        labels_fpath = join(split_dirpath, 'ref_labels.txt')
+        with open(labels_fpath, 'w') as out_f:
+            for seq_name, cur_ref_name in ref_labels.items():
+                if cur_ref_name in split_ref_names:
+                    out_f.write(seq_name + '\t' + cur_ref_name + '\n')
+    if need_trivial_deletions or labels_fpath:
+        return_code = find_bam_gaps(bam_sorted_fpath, err_fpath, logger,
+                                    deletions_fpath=trivial_deletions_fpath if need_trivial_deletions else None,
+                                    min_gap=QuastDeletion.MIN_GAP, min_map_quality=Mapping.MIN_MAP_QUALITY,
+                                    max_conf_interval=QuastDeletion.MAX_CONFIDENCE_INTERVAL,
+                                    labels_fpath=labels_fpath, split_prefix=join(split_dirpath, ''))
+        if return_code != 0:
+            # remove what bedtools may have written, the caller searches the SAM-file instead
+            if need_trivial_deletions and isfile(trivial_deletions_fpath):
+                os.remove(trivial_deletions_fpath)
+            for cur_ref_name in split_ref_names:
+                split_bam_fpath = join(split_dirpath, cur_ref_name + '.bam')
+                if isfile(split_bam_fpath):
+                    os.remove(split_bam_fpath)
+            return None
+    if need_trivial_deletions and isfile(trivial_deletions_fpath):
+        with open(trivial_deletions_fpath) as f:
+            deletions_count = sum(1 for line in f)
+        logger.info('  Trivial deletions: %d found' % deletions_count)
+        logger.info('    Saving to: ' + trivial_deletions_fpath)
+    return trivial_deletions_fpath
+
+
 def align_reference(ref_fpath, output_dir, using_reads='all', calculate_coverage=False):
     required_files = []
     ref_name = qutils.name_from_fpath(ref_fpath)
@@ -287,7 +389,7 @@ def align_reference(ref_fpath, output_dir, using_reads='all', calculate_coverage
                                                                 is_reference=True, alignment_only=True, using_reads=using_reads)
     if not qconfig.optimal_assembly_insert_size or qconfig.optimal_assembly_insert_size == 'auto':
         if using_reads == 'pe' and sam_fpath:
-            insert_size, _, _ = calculate_insert_size(sam_fpath, output_dir, ref_name)
+            insert_size, _, _ = calculate_insert_size(sam_fpath, output_dir, ref_name, err_fpath, bam_fpath=bam_fpath)
             if not insert_size:
                 logger.info('  Failed calculating insert size.')
             else:
@@ -403,55 +505,33 @@ def run_processing_reads(contigs_fpaths, main_ref_fpath, meta_ref_fpaths, ref_la
     bam_mapped_fpath = get_safe_fpath(temp_output_dir, add_suffix(bam_fpath, 'mapped'))
     bam_sorted_fpath = get_safe_fpath(temp_output_dir, add_suffix(bam_mapped_fpath, 'sorted'))
 
-    if is_non_empty_file(sam_sorted_fpath):
+    if not is_bundled_bedtools() and is_non_empty_file(sam_sorted_fpath):
         logger.info('  Using existing sorted SAM-file: ' + sam_sorted_fpath)
     else:
         if not is_non_empty_file(bam_sorted_fpath):
             sambamba_view(bam_fpath, bam_mapped_fpath, qconfig.max_threads, err_fpath, logger,  filter_rule='not unmapped')
             sort_bam(bam_mapped_fpath, bam_sorted_fpath, err_fpath, logger)
-        sambamba_view(bam_sorted_fpath, sam_sorted_fpath, qconfig.max_threads, err_fpath, logger)
+        if not is_bundled_bedtools():  # QUAST's bedtools scans the sorted BAM itself, see search_trivial_deletions_in_bam
+            sambamba_view(bam_sorted_fpath, sam_sorted_fpath, qconfig.max_threads, err_fpath, logger)
     if qconfig.create_icarus_html and (not is_non_empty_file(cov_fpath) or not is_non_empty_file(physical_cov_fpath)):
         cov_fpath, physical_cov_fpath = get_coverage(temp_output_dir, main_ref_fpath, ref_name, bam_fpath, bam_sorted_fpath,
-                                                     log_path, err_fpath, correct_chr_names, cov_fpath, physical_cov_fpath)
+                                                     log_path, err_fpath, correct_chr_names, cov_fpath, physical_cov_fpath,
+                                                     ref_labels=ref_labels if meta_ref_fpaths else None)
     if not is_non_empty_file(bed_fpath) and not qconfig.no_sv:
-        if meta_ref_fpaths:
-            logger.info('  Splitting SAM-file by references...')
-        headers = []
-        seq_lengths = {}
-        with open(sam_fpath) as sam_file:
-            for line in sam_file:
-                if not line.startswith('@'):
-                    break
-                if line.startswith('@SQ') and 'SN:' in line and 'LN:' in line:
-                    seq_name = line.split('\tSN:')[1].split('\t')[0]
-                    seq_length = int(line.split('\tLN:')[1].split('\t')[0])
-                    seq_lengths[seq_name] = seq_length
-                headers.append(line.strip())
-        need_ref_splitting = False
-        ref_files = {}
-        if meta_ref_fpaths:
-            global ref_sam_fpaths
-            for cur_ref_fpath in meta_ref_fpaths:
-                cur_ref_name = qutils.name_from_fpath(cur_ref_fpath)
-                ref_sam_fpath = join(temp_output_dir, cur_ref_name + '.sam')
-                ref_sam_fpaths[cur_ref_fpath] = ref_sam_fpath
-                if is_non_empty_file(ref_sam_fpath):
-                    logger.info('    Using existing split SAM-file for %s: %s' % (cur_ref_name, ref_sam_fpath))
-                    ref_files[cur_ref_name] = None
-                else:
-                    ref_sam_file = open(ref_sam_fpath, 'w')
-                    if not headers[0].startswith('@SQ'):
-                        ref_sam_file.write(headers[0] + '\n')
-                    for h in (h for h in headers if h.startswith('@SQ') and 'SN:' in h):
-                        seq_name = h.split('\tSN:')[1].split('\t')[0]
-                        if seq_name in ref_labels and ref_labels[seq_name] == cur_ref_name:
-                            ref_sam_file.write(h + '\n')
-                    ref_sam_file.write(headers[-1] + '\n')
-                    ref_files[cur_ref_name] = ref_sam_file
-                    need_ref_splitting = True
-
-        trivial_deletions_fpath = \
-            search_trivial_deletions(temp_output_dir, sam_sorted_fpath, ref_files, ref_labels, seq_lengths, need_ref_splitting)
+        if is_bundled_bedtools():
+            if meta_ref_fpaths:
+                logger.info('  Splitting BAM-file by references...')
+            trivial_deletions_fpath = \
+                search_trivial_deletions_in_bam(temp_output_dir, bam_sorted_fpath, meta_ref_fpaths, ref_labels, err_fpath)
+            if not trivial_deletions_fpath:
+                logger.warning('  QUAST\'s bedtools failed to scan the BAM-file, searching the SAM-file instead.')
+                if not is_non_empty_file(sam_sorted_fpath):
+                    sambamba_view(bam_sorted_fpath, sam_sorted_fpath, qconfig.max_threads, err_fpath, logger)
+        else:
+            trivial_deletions_fpath = None
+        if not trivial_deletions_fpath:
+            trivial_deletions_fpath = search_trivial_deletions_in_sam(temp_output_dir, sam_fpath, sam_sorted_fpath,
+                                                                      meta_ref_fpaths, ref_labels)
         if get_gridss_fpath() and isfile(get_gridss_fpath()):
             try:
                 gridss_sv_fpath = search_sv_with_gridss(main_ref_fpath, bam_mapped_fpath, meta_ref_fpaths, temp_output_dir, err_fpath)
@@ -628,7 +708,8 @@ def run_aligner(read_fpaths, ref_fpath, sam_fpath, out_sam_fpaths, output_dir, e
                 if exists(bam_dedup_fpath):
                     shutil.move(bam_dedup_fpath, bam_fpath)
         if reads_type == 'pe':
-            insert_size, _, _ = calculate_insert_size(output_fpath, output_dir, qutils.name_from_fpath(sam_fpath))
+            insert_size, _, _ = calculate_insert_size(output_fpath, output_dir, qutils.name_from_fpath(sam_fpath),
+                                                      err_fpath, bam_fpath=bam_fpath)
             if insert_size is not None and insert_size < qconfig.optimal_assembly_max_IS:
                 insert_sizes.append(insert_size)
         temp_sam_fpaths.append(output_fpath)
@@ -762,22 +843,36 @@ def add_statistics_to_report(output_dir, contigs_fpaths, ref_fpath):
 
 def analyse_coverage(output_dirpath, fpath, chr_names, bam_fpath, stats_fpath, err_fpath, logger):
     filename = qutils.name_from_fpath(fpath)
-    bed_fpath = bam_to_bed(output_dirpath, filename, bam_fpath, err_fpath, logger)
     chr_len_fpath = get_chr_len_fpath(fpath, chr_names)
     cov_fpath = join(output_dirpath, filename + '.genomecov')
-    calculate_genome_cov(bed_fpath, cov_fpath, chr_len_fpath, err_fpath, logger, print_all_positions=False)
-
     avg_depth = 0
     coverage_for_thresholds = [0 for threshold in qconfig.coverage_thresholds]
-    with open(cov_fpath) as f:
-        for line in f:
-            l = line.split()  # genome; depth; number of bases; size of genome; fraction of bases with depth
-            depth, genome_fraction = int(l[1]), float(l[4])
-            if l[0] == 'genome':
-                avg_depth += depth * genome_fraction
-                for i, threshold in enumerate(qconfig.coverage_thresholds):
-                    if depth >= threshold:
-                        coverage_for_thresholds[i] += genome_fraction
+    if is_bundled_bedtools():
+        if can_skip_bam_to_bed():
+            calculate_genome_cov(bam_fpath, cov_fpath, chr_len_fpath, err_fpath, logger, print_all_positions=False,
+                                 summary_thresholds=qconfig.coverage_thresholds, bam_mode='footprint')
+        else:
+            bed_fpath = bam_to_bed(output_dirpath, filename, bam_fpath, err_fpath, logger)
+            calculate_genome_cov(bed_fpath, cov_fpath, chr_len_fpath, err_fpath, logger, print_all_positions=False,
+                                 summary_thresholds=qconfig.coverage_thresholds)
+        with open(cov_fpath) as f:
+            for line in f:
+                l = line.split()  # genome; size of genome; mean depth; fraction of bases with depth >= each threshold
+                if l[0] == 'genome':
+                    avg_depth = float(l[2])
+                    coverage_for_thresholds = [float(fraction) for fraction in l[3:]]
+    else:
+        bed_fpath = bam_to_bed(output_dirpath, filename, bam_fpath, err_fpath, logger)
+        calculate_genome_cov(bed_fpath, cov_fpath, chr_len_fpath, err_fpath, logger, print_all_positions=False)
+        with open(cov_fpath) as f:
+            for line in f:
+                l = line.split()  # genome; depth; number of bases; size of genome; fraction of bases with depth
+                depth, genome_fraction = int(l[1]), float(l[4])
+                if l[0] == 'genome':
+                    avg_depth += depth * genome_fraction
+                    for i, threshold in enumerate(qconfig.coverage_thresholds):
+                        if depth >= threshold:
+                            coverage_for_thresholds[i] += genome_fraction
 
     with open(stats_fpath, 'a') as out_f:
         out_f.write('%s depth\n' % int(avg_depth))
@@ -785,43 +880,115 @@ def analyse_coverage(output_dirpath, fpath, chr_names, bam_fpath, stats_fpath, e
             out_f.write('%.2f coverage >= %sx\n' % (coverage_for_thresholds[i] * 100, threshold))
 
 
-def get_physical_coverage(output_dirpath, ref_name, bam_fpath, log_path, err_fpath, cov_fpath, chr_len_fpath):
-    raw_cov_fpath = add_suffix(cov_fpath, 'raw')
+def can_skip_bam_to_bed():
+    # QUAST's copy of bedtools reads the BAM directly (genomecov -footprint) instead of bamtobed + sort,
+    # but keeps the depth of the whole genome in memory (up to 4 bytes per base), so not for large genomes
+    return is_bundled_bedtools() and not qconfig.large_genome
+
+
+def get_coverage_window():
+    # QUAST's copy of bedtools bins the depth for Icarus itself (genomecov -window),
+    # otherwise the per-base -bga output is binned by proceed_cov_file
+    return COVERAGE_FACTOR if is_bundled_bedtools() else None
+
+
+def get_ref_cov_fpaths(cov_fpath, ref_labels):
+    # MetaQUAST: the coverage of each reference of the combined one, passed to its own QUAST run instead of the whole
+    return dict((ref_name, add_suffix(cov_fpath, ref_name)) for ref_name in set(ref_labels.values())) if ref_labels else {}
+
+
+def get_coverage_tracks(raw_cov_fpath, ref_labels):
+    # the raw coverage file of each reference, written by the genomecov run of the combined reference
+    # (only QUAST's copy of bedtools has -tracks, and only the -window output is split this way)
+    if not ref_labels or not get_coverage_window():
+        return {}, {}
+    ref_raw_cov_fpaths = get_ref_cov_fpaths(raw_cov_fpath, ref_labels)
+    tracks = dict((seq_name, ref_raw_cov_fpaths[ref_name]) for seq_name, ref_name in ref_labels.items())
+    return tracks, ref_raw_cov_fpaths
+
+
+def get_physical_coverage(output_dirpath, ref_name, bam_fpath, bam_sorted_fpath, log_path, err_fpath, cov_fpath, chr_len_fpath,
+                          tracks=None):
+    window = get_coverage_window()
+    raw_cov_fpath = add_suffix(cov_fpath, 'windows' if window else 'raw')
     if not is_non_empty_file(raw_cov_fpath):
         logger.info('  Calculating physical coverage...')
         ## keep properly mapped, unique, non-duplicate paired-end reads only
+        filter_rule = 'proper_pair and not supplementary and not duplicate ' \
+                      'and template_length > %d and template_length < %d' % (-qconfig.MAX_PE_IS, qconfig.MAX_PE_IS)
         bam_filtered_fpath = join(output_dirpath, ref_name + '.physical.bam')
-        sambamba_view(bam_fpath, bam_filtered_fpath, qconfig.max_threads, err_fpath, logger,
-                      filter_rule='proper_pair and not supplementary and not duplicate '
-                                  'and template_length > %d and template_length < %d' %
-                                  (-qconfig.MAX_PE_IS, qconfig.MAX_PE_IS))
-        ## sort by read names
-        bam_filtered_sorted_fpath = join(output_dirpath, ref_name + '.physical.sorted.bam')
-        sort_bam(bam_filtered_fpath, bam_filtered_sorted_fpath, err_fpath, logger, sort_rule='-n')
-        bed_fpath = bam_to_bed(output_dirpath, ref_name + '.physical', bam_filtered_sorted_fpath, err_fpath, logger, bedpe=True)
-        calculate_genome_cov(bed_fpath, raw_cov_fpath, chr_len_fpath, err_fpath, logger)
+        if is_bundled_bedtools():
+            ## QUAST's bedtools pairs up the mates of the position-sorted BAM itself (genomecov -fragments)
+            if not is_non_empty_file(bam_sorted_fpath):
+                sort_bam(bam_fpath, bam_sorted_fpath, err_fpath, logger)
+            sambamba_view(bam_sorted_fpath, bam_filtered_fpath, qconfig.max_threads, err_fpath, logger, filter_rule=filter_rule)
+            calculate_genome_cov(bam_filtered_fpath, raw_cov_fpath, chr_len_fpath, err_fpath, logger,
+                                 window=window, bam_mode='fragments', tracks=tracks)
+        else:
+            sambamba_view(bam_fpath, bam_filtered_fpath, qconfig.max_threads, err_fpath, logger, filter_rule=filter_rule)
+            ## sort by read names
+            bam_filtered_sorted_fpath = join(output_dirpath, ref_name + '.physical.sorted.bam')
+            sort_bam(bam_filtered_fpath, bam_filtered_sorted_fpath, err_fpath, logger, sort_rule='-n')
+            bed_fpath = bam_to_bed(output_dirpath, ref_name + '.physical', bam_filtered_sorted_fpath, err_fpath, logger, bedpe=True)
+            calculate_genome_cov(bed_fpath, raw_cov_fpath, chr_len_fpath, err_fpath, logger, window=window)
     return raw_cov_fpath
 
 
 def get_coverage(output_dirpath, ref_fpath, ref_name, bam_fpath, bam_sorted_fpath, log_path, err_fpath, correct_chr_names,
-                 cov_fpath, physical_cov_fpath=None, uncovered_fpath=None, create_cov_files=True):
+                 cov_fpath, physical_cov_fpath=None, uncovered_fpath=None, create_cov_files=True, ref_labels=None):
     raw_cov_fpath = cov_fpath + '_raw'
+    windows_cov_fpath = cov_fpath + '_windows'
+    window = get_coverage_window()
     chr_len_fpath = get_chr_len_fpath(ref_fpath, correct_chr_names)
     if not is_non_empty_file(cov_fpath):
         logger.info('  Calculating reads coverage...')
-        if not is_non_empty_file(raw_cov_fpath):
+        # QUAST's copy of bedtools lists the zero-covered regions itself (bamgaps -zero), no per-base coverage needed
+        uncovered_from_raw_cov = uncovered_fpath and not is_bundled_bedtools()
+        if not is_non_empty_file(raw_cov_fpath) and (uncovered_from_raw_cov or not window):
             if not is_non_empty_file(bam_sorted_fpath):
                 sort_bam(bam_fpath, bam_sorted_fpath, err_fpath, logger)
-            calculate_genome_cov(bam_sorted_fpath, raw_cov_fpath, chr_len_fpath, err_fpath, logger)
+            calculate_genome_cov(bam_sorted_fpath, raw_cov_fpath, chr_len_fpath, err_fpath, logger,
+                                 max_threads=qconfig.max_threads)
             qutils.assert_file_exists(raw_cov_fpath, 'coverage file')
-        if uncovered_fpath:
+        if uncovered_from_raw_cov:
             print_uncovered_regions(raw_cov_fpath, uncovered_fpath, correct_chr_names)
-        if create_cov_files:
+        elif uncovered_fpath:
+            raw_uncovered_fpath = uncovered_fpath + '_raw'
+            if not is_non_empty_file(bam_sorted_fpath):
+                sort_bam(bam_fpath, bam_sorted_fpath, err_fpath, logger)
+            find_bam_gaps(bam_sorted_fpath, err_fpath, logger, zero_cov_fpath=raw_uncovered_fpath)
+            qutils.assert_file_exists(raw_uncovered_fpath, 'uncovered regions file')
+            print_uncovered_regions(raw_uncovered_fpath, uncovered_fpath, correct_chr_names)
+            if not qconfig.debug:
+                os.remove(raw_uncovered_fpath)
+        if create_cov_files and window:
+            if not is_non_empty_file(bam_sorted_fpath):
+                sort_bam(bam_fpath, bam_sorted_fpath, err_fpath, logger)
+            tracks, ref_windows_cov_fpaths = get_coverage_tracks(windows_cov_fpath, ref_labels)
+            calculate_genome_cov(bam_sorted_fpath, windows_cov_fpath, chr_len_fpath, err_fpath, logger,
+                                 max_threads=qconfig.max_threads, window=window, tracks=tracks)
+            qutils.assert_file_exists(windows_cov_fpath, 'coverage file')
+            proceed_windows_file(windows_cov_fpath, cov_fpath, correct_chr_names)
+            ref_cov_fpaths = get_ref_cov_fpaths(cov_fpath, ref_labels)
+            for cur_ref_name, ref_windows_cov_fpath in ref_windows_cov_fpaths.items():
+                if isfile(ref_windows_cov_fpath):
+                    proceed_windows_file(ref_windows_cov_fpath, ref_cov_fpaths[cur_ref_name], correct_chr_names)
+            if isfile(raw_cov_fpath) and not qconfig.debug:
+                os.remove(raw_cov_fpath)
+        elif create_cov_files:
             proceed_cov_file(raw_cov_fpath, cov_fpath, correct_chr_names)
     if not is_non_empty_file(physical_cov_fpath) and create_cov_files:
-        raw_cov_fpath = get_physical_coverage(output_dirpath, ref_name, bam_fpath, log_path, err_fpath,
-                                              physical_cov_fpath, chr_len_fpath)
-        proceed_cov_file(raw_cov_fpath, physical_cov_fpath, correct_chr_names)
+        tracks, ref_raw_cov_fpaths = get_coverage_tracks(add_suffix(physical_cov_fpath, 'windows'), ref_labels)
+        raw_cov_fpath = get_physical_coverage(output_dirpath, ref_name, bam_fpath, bam_sorted_fpath, log_path, err_fpath,
+                                              physical_cov_fpath, chr_len_fpath, tracks=tracks)
+        if window:
+            proceed_windows_file(raw_cov_fpath, physical_cov_fpath, correct_chr_names)
+            ref_cov_fpaths = get_ref_cov_fpaths(physical_cov_fpath, ref_labels)
+            for cur_ref_name, ref_raw_cov_fpath in ref_raw_cov_fpaths.items():
+                if isfile(ref_raw_cov_fpath):
+                    proceed_windows_file(ref_raw_cov_fpath, ref_cov_fpaths[cur_ref_name], correct_chr_names)
+        else:
+            proceed_cov_file(raw_cov_fpath, physical_cov_fpath, correct_chr_names)
     return cov_fpath, physical_cov_fpath
 
 
@@ -855,13 +1022,31 @@ def proceed_cov_file(raw_cov_fpath, cov_fpath, correct_chr_names):
                 os.remove(raw_cov_fpath)
 
 
+def proceed_windows_file(windows_cov_fpath, cov_fpath, correct_chr_names):
+    # same output as proceed_cov_file, from genomecov -window COVERAGE_FACTOR:
+    # the depth is already averaged, only the shorter last window of each chromosome is dropped
+    used_chromosomes = dict()
+    with open(windows_cov_fpath, 'r') as in_coverage:
+        with open(cov_fpath, 'w') as out_coverage:
+            for line in in_coverage:
+                name, start, end, depth = line.split()[:4]
+                if name not in used_chromosomes:
+                    used_chromosomes[name] = str(len(used_chromosomes) + 1)
+                    correct_name = correct_chr_names[name] if correct_chr_names else name
+                    out_coverage.write('#' + correct_name + ' ' + used_chromosomes[name] + '\n')
+                if int(end) - int(start) == COVERAGE_FACTOR:
+                    out_coverage.write(' '.join([used_chromosomes[name], str(int(float(depth))) + '\n']))
+    if not qconfig.debug:
+        os.remove(windows_cov_fpath)
+
+
 def get_max_min_is(insert_sizes):
     decile_1 = percentile(insert_sizes, 10)
     decile_9 = percentile(insert_sizes, 90)
     return decile_1, decile_9
 
 
-def calculate_insert_size(sam_fpath, output_dir, ref_name, reads_suffix=''):
+def calculate_insert_size(sam_fpath, output_dir, ref_name, err_fpath, reads_suffix='', bam_fpath=None):
     insert_size_fpath = join(output_dir, ref_name + ('.' + reads_suffix if reads_suffix else '') + '.is.txt')
     if is_non_empty_file(insert_size_fpath):
         try:
@@ -873,34 +1058,41 @@ def calculate_insert_size(sam_fpath, output_dir, ref_name, reads_suffix=''):
                 return insert_size, min_insert_size, max_insert_size
         except:
             pass
-    insert_sizes = []
-    mapped_flags = ['99', '147', '83', '163']  # reads mapped in correct orientation and within insert size
-    with open(sam_fpath) as sam_in:
-        for i, l in enumerate(sam_in):
-            if i > 1000000:
-                break
-            if l.startswith('@'):
-                continue
-            fs = l.split('\t')
-            flag = fs[1]
-            if flag not in mapped_flags:
-                continue
-            insert_size = abs(int(fs[8]))
-            insert_sizes.append(insert_size)
-
-    if insert_sizes:
+    if bam_fpath and is_non_empty_file(bam_fpath) and is_bundled_bedtools():
+        pair_stats = get_pair_stats(bam_fpath, err_fpath, logger)
+        if not pair_stats:
+            return None, None, None
+        median_is = pair_stats['median_is']
+        min_insert_size, max_insert_size = pair_stats['is_deciles'][0], pair_stats['is_deciles'][-1]
+    else:
+        insert_sizes = []
+        mapped_flags = ['99', '147', '83', '163']  # reads mapped in correct orientation and within insert size
+        with open(sam_fpath) as sam_in:
+            for i, l in enumerate(sam_in):
+                if i > 1000000:
+                    break
+                if l.startswith('@'):
+                    continue
+                fs = l.split('\t')
+                flag = fs[1]
+                if flag not in mapped_flags:
+                    continue
+                insert_size = abs(int(fs[8]))
+                insert_sizes.append(insert_size)
+        if not insert_sizes:
+            return None, None, None
         insert_sizes.sort()
         median_is = calc_median(insert_sizes)
-        if median_is <= 0:
-            return None, None, None
         min_insert_size, max_insert_size = get_max_min_is(insert_sizes)
-        insert_size = max(qconfig.optimal_assembly_min_IS, median_is)
-        with open(insert_size_fpath, 'w') as out_f:
-            out_f.write(str(insert_size) + '\n')
-            out_f.write(str(min_insert_size) + '\n')
-            out_f.write(str(max_insert_size) + '\n')
-        return insert_size, min_insert_size, max_insert_size
-    return None, None, None
+
+    if median_is <= 0:
+        return None, None, None
+    insert_size = max(qconfig.optimal_assembly_min_IS, median_is)
+    with open(insert_size_fpath, 'w') as out_f:
+        out_f.write(str(insert_size) + '\n')
+        out_f.write(str(min_insert_size) + '\n')
+        out_f.write(str(max_insert_size) + '\n')
+    return insert_size, min_insert_size, max_insert_size
 
 
 def print_uncovered_regions(raw_cov_fpath, uncovered_fpath, correct_chr_names):
@@ -911,7 +1103,7 @@ def print_uncovered_regions(raw_cov_fpath, uncovered_fpath, correct_chr_names):
             name = fs[0]
             depth = int(float(fs[-1]))
             correct_name = correct_chr_names[name] if correct_chr_names else name
-            if len(fs) > 3 and depth == 0:
+            if len(fs) == 3 or depth == 0:  # BED from bamgaps -zero or BEDGRAPH from genomecov -bga
                 uncovered_regions[correct_name].append((fs[1], fs[2]))
     with open(uncovered_fpath, 'w') as out_f:
         for chrom, regions in uncovered_regions.items():